@@ -0,0 +1,1313 @@
+// Standalone benchmark for the projectile simulation core.
+//
+// Links only the parts of the extension that use no Godot types: the pool,
+// kernels, broadphase, hitbox history, hurtbox tree, replication codec and
+// frame arena. Those sources stay free of Godot on purpose, so the bench runs
+// on CI machines without an engine. Results are printed as JSON.
+//
+//   projectile_bench [--counts=100,1000,10000,100000] [--threads=1,2,4,8]
+//                    [--ticks=600] [--kernels=all|auto|scalar,sse2,avx2]
+//                    [--rewind-entities=64] [--rewind-history=1.0]
+//                    [--rewind-shots=100000] [--snapshot-count=1000]
+//                    [--replication-players=64]
+//                    [--replication-projectiles=2000]
+//                    [--ballistic-projectiles=10000] [--ballistic-colliders=64]
+//                    [--hurtbox-targets=64,512,4096] [--hurtbox-segments=2000]
+//                    [--arena-hits=4000]
+//                    [--output=results.json]
+
+#include "combat/hitbox_history.hpp"
+#include "combat/hurtbox_tree.hpp"
+#include "memory/frame_arena.hpp"
+#include "net/replication_codec.hpp"
+#include "weapons/projectile_broadphase.hpp"
+#include "weapons/projectile_kernels.hpp"
+#include "weapons/projectile_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace godot;
+
+// ================ ALLOCATION COUNTING ================
+
+static std::atomic<uint64_t> allocation_count(0);
+
+// GCC flags free() on memory from the replaced operator new as mismatched
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void *operator new(std::size_t p_size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    void *ptr = std::malloc(p_size ? p_size : 1);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void *p_ptr) noexcept {
+    std::free(p_ptr);
+}
+
+void operator delete(void *p_ptr, std::size_t) noexcept {
+    std::free(p_ptr);
+}
+
+// ================ WORKERS ================
+
+// Persistent workers so thread start-up is not part of the measured tick.
+// The calling thread runs job 0 itself.
+class ChunkRunner {
+private:
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable start_cv;
+    std::condition_variable done_cv;
+    void (*job)(void *, int) = nullptr;
+    void *job_data = nullptr;
+    uint64_t generation = 0;
+    int pending = 0;
+    bool quit = false;
+
+    void worker_main(int p_index) {
+        uint64_t seen = 0;
+        while (true) {
+            std::unique_lock<std::mutex> lock(mutex);
+            start_cv.wait(lock, [&] { return quit || generation != seen; });
+            if (quit) {
+                return;
+            }
+            seen = generation;
+            lock.unlock();
+
+            job(job_data, p_index);
+
+            lock.lock();
+            if (--pending == 0) {
+                done_cv.notify_one();
+            }
+        }
+    }
+
+public:
+    explicit ChunkRunner(int p_threads) {
+        for (int i = 1; i < p_threads; i++) {
+            threads.emplace_back(&ChunkRunner::worker_main, this, i);
+        }
+    }
+
+    ~ChunkRunner() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        start_cv.notify_all();
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+    }
+
+    int get_thread_count() const { return (int)threads.size() + 1; }
+
+    // Takes the job by reference instead of through std::function so that
+    // dispatching never allocates and the allocation counts stay honest
+    template <typename F>
+    void run(F &p_job) {
+        void (*invoke)(void *, int) = [](void *p_data, int p_chunk) { (*(F *)p_data)(p_chunk); };
+        if (threads.empty()) {
+            invoke(&p_job, 0);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = invoke;
+            job_data = &p_job;
+            pending = (int)threads.size();
+            generation++;
+        }
+        start_cv.notify_all();
+
+        invoke(&p_job, 0);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done_cv.wait(lock, [&] { return pending == 0; });
+    }
+};
+
+// ================ SCENARIO ================
+
+struct BenchConfig {
+    std::vector<uint32_t> counts = { 100, 1000, 10000, 100000 };
+    std::vector<int> threads = { 1, 2, 4, 8 };
+    std::vector<ProjectileKernels::Isa> kernels;
+    int ticks = 600;
+    uint32_t rewind_entities = 64;
+    double rewind_history = 1.0;
+    uint32_t rewind_shots = 100000;
+    uint32_t snapshot_count = 1000;
+    uint32_t replication_players = 64;
+    uint32_t replication_projectiles = 2000;
+    uint32_t ballistic_projectiles = 10000;
+    uint32_t ballistic_colliders = 64;
+    std::vector<uint32_t> hurtbox_targets = { 64, 512, 4096 };
+    uint32_t hurtbox_segments = 2000;
+    uint32_t arena_hits = 4000;
+    std::string output;
+};
+
+struct BenchResult {
+    ProjectileKernels::Isa kernel;
+    uint32_t projectiles;
+    int threads;
+    double ns_per_projectile;
+    double mean_usec;
+    double p50_usec;
+    double p99_usec;
+    double allocations_per_tick;
+    double expired_per_tick;
+};
+
+static const float TICK_DELTA = 1.0f / 60.0f;
+
+static ProjectilePool::SpawnParams random_spawn(std::mt19937 &p_rng) {
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> speed(40.0f, 400.0f);
+    std::uniform_real_distribution<float> range(50.0f, 300.0f);
+
+    ProjectilePool::SpawnParams params;
+    float dir[3] = { unit(p_rng), unit(p_rng), unit(p_rng) };
+    float len = std::sqrt(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+    if (len < 1e-3f) {
+        dir[2] = len = 1.0f;
+    }
+    for (int i = 0; i < 3; i++) {
+        params.position[i] = unit(p_rng) * 100.0f;
+        params.direction[i] = dir[i] / len;
+    }
+    params.speed = speed(p_rng);
+    params.damage = 10.0f;
+    params.max_range = range(p_rng);
+    params.shooter = 1;
+    return params;
+}
+
+static double percentile(std::vector<double> &r_samples, double p_fraction) {
+    size_t index = (size_t)(p_fraction * (r_samples.size() - 1) + 0.5);
+    std::nth_element(r_samples.begin(), r_samples.begin() + index, r_samples.end());
+    return r_samples[index];
+}
+
+static BenchResult run_case(ProjectileKernels::Isa p_kernel, uint32_t p_count, ChunkRunner &p_runner, int p_ticks) {
+    std::mt19937 rng(1234);
+    ProjectilePool pool;
+    pool.reset(p_count);
+    for (uint32_t i = 0; i < p_count; i++) {
+        pool.spawn(random_spawn(rng));
+    }
+
+    // Spawn parameters are drawn up front so the RNG is not measured
+    std::vector<ProjectilePool::SpawnParams> respawns(p_count);
+    for (uint32_t i = 0; i < p_count; i++) {
+        respawns[i] = random_spawn(rng);
+    }
+    uint32_t respawn_cursor = 0;
+
+    ProjectileKernels::IntegrateFunc integrate = ProjectileKernels::get_integrate_func(p_kernel);
+    int threads = p_runner.get_thread_count();
+    std::vector<uint32_t> expired(p_count);
+    std::vector<uint32_t> chunk_expired(threads);
+    std::vector<double> samples(p_ticks);
+    uint64_t total_expired = 0;
+
+    uint64_t allocations_before = allocation_count.load();
+
+    for (int tick = 0; tick < p_ticks; tick++) {
+        auto start = std::chrono::steady_clock::now();
+
+        // Same chunking and compaction scheme as ProjectileManager
+        ProjectileKernels::Streams streams = ProjectileKernels::get_streams(pool);
+        uint32_t count = pool.get_count();
+        uint32_t chunk_size = (count + threads - 1) / threads;
+        auto integrate_chunk = [&](int p_chunk) {
+            uint32_t begin = std::min(count, p_chunk * chunk_size);
+            uint32_t end = std::min(count, begin + chunk_size);
+            chunk_expired[p_chunk] = integrate(streams, begin, end, TICK_DELTA, expired.data() + begin);
+        };
+        p_runner.run(integrate_chunk);
+        pool.advance_time(TICK_DELTA);
+
+        uint32_t expired_count = 0;
+        for (int chunk = 0; chunk < threads; chunk++) {
+            uint32_t begin = std::min(count, chunk * chunk_size);
+            for (uint32_t i = 0; i < chunk_expired[chunk]; i++) {
+                expired[expired_count++] = expired[begin + i];
+            }
+        }
+
+        for (uint32_t i = expired_count; i > 0; i--) {
+            pool.release_dense(expired[i - 1]);
+        }
+
+        // Keep the population steady, as sustained fire would
+        for (uint32_t i = 0; i < expired_count; i++) {
+            pool.spawn(respawns[respawn_cursor]);
+            respawn_cursor = (respawn_cursor + 1) % p_count;
+        }
+
+        auto end = std::chrono::steady_clock::now();
+        samples[tick] = std::chrono::duration<double, std::micro>(end - start).count();
+        total_expired += expired_count;
+    }
+
+    uint64_t allocations = allocation_count.load() - allocations_before;
+
+    double total_usec = 0.0;
+    for (double sample : samples) {
+        total_usec += sample;
+    }
+
+    BenchResult result;
+    result.kernel = p_kernel;
+    result.projectiles = p_count;
+    result.threads = threads;
+    result.mean_usec = total_usec / p_ticks;
+    result.ns_per_projectile = result.mean_usec * 1000.0 / p_count;
+    result.p50_usec = percentile(samples, 0.50);
+    result.p99_usec = percentile(samples, 0.99);
+    result.allocations_per_tick = (double)allocations / p_ticks;
+    result.expired_per_tick = (double)total_expired / p_ticks;
+    return result;
+}
+
+// ================ LAG COMPENSATION ================
+
+struct RewindResult {
+    uint32_t entities;
+    uint32_t frames;
+    uint32_t shots;
+    double ns_per_shot;
+    double ns_per_record; // Recording one frame of every entity
+    double hit_rate;
+    double allocations_per_shot;
+};
+
+// Entities circle the origin at different radii and speeds while turning,
+// recorded at TICK_DELTA. Shots aim at an entity's pose at a random time in
+// the window from a random point, so most of them hit.
+static void entity_pose(uint32_t p_entity, double p_time, HitboxHistory::Pose &r_pose) {
+    float radius = 5.0f + (p_entity % 16) * 2.0f;
+    float angle = (float)(p_time * (0.5 + (p_entity % 7) * 0.25)) + p_entity;
+    float yaw = angle * 0.5f;
+
+    r_pose.position[0] = std::cos(angle) * radius;
+    r_pose.position[1] = (float)(p_entity / 16) * 3.0f;
+    r_pose.position[2] = std::sin(angle) * radius;
+    r_pose.rotation[0] = 0.0f;
+    r_pose.rotation[1] = std::sin(yaw);
+    r_pose.rotation[2] = 0.0f;
+    r_pose.rotation[3] = std::cos(yaw);
+    r_pose.center[0] = 0.0f;
+    r_pose.center[1] = 0.9f;
+    r_pose.center[2] = 0.0f;
+    r_pose.half_extents[0] = 0.4f;
+    r_pose.half_extents[1] = 0.9f;
+    r_pose.half_extents[2] = 0.4f;
+    r_pose.key = p_entity + 1;
+}
+
+static RewindResult run_rewind(uint32_t p_entities, double p_history, uint32_t p_shots) {
+    uint32_t frames = (uint32_t)std::ceil(p_history / TICK_DELTA) + 1;
+    HitboxHistory history;
+    history.reset(p_entities, frames);
+
+    // Fill the window twice over so the ring has wrapped
+    auto record_start = std::chrono::steady_clock::now();
+    uint32_t recorded = frames * 2;
+    double time = 0.0;
+    for (uint32_t frame = 0; frame < recorded; frame++) {
+        time = frame * (double)TICK_DELTA;
+        history.begin_frame(time);
+        for (uint32_t entity = 0; entity < p_entities; entity++) {
+            HitboxHistory::Pose pose;
+            entity_pose(entity, time, pose);
+            history.set_pose(entity, pose);
+        }
+    }
+    auto record_end = std::chrono::steady_clock::now();
+
+    // Shots are drawn up front so the RNG and trigonometry are not measured
+    struct Shot {
+        double time;
+        float origin[3];
+        float direction[3];
+    };
+    std::mt19937 rng(99);
+    std::uniform_real_distribution<double> when(history.get_oldest_time(), history.get_newest_time());
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_int_distribution<uint32_t> target(0, p_entities - 1);
+    std::vector<Shot> shots(p_shots);
+    for (Shot &shot : shots) {
+        shot.time = when(rng);
+        HitboxHistory::Pose pose;
+        entity_pose(target(rng), shot.time, pose);
+
+        float to[3] = { pose.position[0], pose.position[1] + 0.9f, pose.position[2] };
+        shot.origin[0] = unit(rng) * 60.0f;
+        shot.origin[1] = 1.8f;
+        shot.origin[2] = unit(rng) * 60.0f;
+        float dir[3] = { to[0] - shot.origin[0], to[1] - shot.origin[1], to[2] - shot.origin[2] };
+        float len = std::sqrt(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+        for (int i = 0; i < 3; i++) {
+            shot.direction[i] = dir[i] / len;
+        }
+    }
+
+    uint64_t allocations_before = allocation_count.load();
+    uint32_t hits = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const Shot &shot : shots) {
+        HitboxHistory::RayHit hit;
+        hits += history.raycast(shot.time, shot.origin, shot.direction, 500.0f, 0, hit) ? 1 : 0;
+    }
+    auto end = std::chrono::steady_clock::now();
+    uint64_t allocations = allocation_count.load() - allocations_before;
+
+    RewindResult result;
+    result.entities = p_entities;
+    result.frames = frames;
+    result.shots = p_shots;
+    result.ns_per_shot = std::chrono::duration<double, std::nano>(end - start).count() / p_shots;
+    result.ns_per_record = std::chrono::duration<double, std::nano>(record_end - record_start).count() / recorded;
+    result.hit_rate = (double)hits / p_shots;
+    result.allocations_per_shot = (double)allocations / p_shots;
+    return result;
+}
+
+// ================ SNAPSHOTS ================
+
+struct SnapshotResult {
+    uint32_t projectiles;
+    size_t bytes;
+    double capture_usec;
+    double restore_usec;
+    double allocations_per_cycle;
+    bool deterministic;
+    bool rejects_corrupt; // A snapshot with an out-of-range id is refused and the pool kept
+};
+
+// Integrates and releases the way ProjectileManager does, at a fixed timestep
+static void step_pool(ProjectilePool &r_pool, std::vector<uint32_t> &r_expired, ProjectileKernels::IntegrateFunc p_integrate) {
+    ProjectileKernels::Streams streams = ProjectileKernels::get_streams(r_pool);
+    uint32_t expired_count = p_integrate(streams, 0, r_pool.get_count(), TICK_DELTA, r_expired.data());
+    r_pool.advance_time(TICK_DELTA);
+    for (uint32_t i = expired_count; i > 0; i--) {
+        r_pool.release_dense(r_expired[i - 1]);
+    }
+}
+
+static SnapshotResult run_snapshot(uint32_t p_count) {
+    const int warmup_ticks = 30;
+    const int replay_ticks = 120;
+    const int iterations = 2000;
+
+    std::mt19937 rng(7);
+    ProjectilePool pool;
+    pool.reset(p_count);
+    for (uint32_t i = 0; i < p_count; i++) {
+        pool.spawn(random_spawn(rng));
+    }
+
+    ProjectileKernels::IntegrateFunc integrate = ProjectileKernels::get_integrate_func(ProjectileKernels::get_best_isa());
+    std::vector<uint32_t> expired(p_count);
+    for (int tick = 0; tick < warmup_ticks; tick++) {
+        step_pool(pool, expired, integrate);
+    }
+
+    std::vector<uint8_t> snapshot(pool.get_state_size());
+    std::vector<uint8_t> scratch(snapshot.size());
+
+    uint64_t allocations_before = allocation_count.load();
+    auto capture_start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        pool.write_state(scratch.data());
+    }
+    auto capture_end = std::chrono::steady_clock::now();
+    pool.write_state(snapshot.data());
+
+    auto restore_start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        pool.read_state(snapshot.data(), snapshot.size());
+    }
+    auto restore_end = std::chrono::steady_clock::now();
+    uint64_t allocations = allocation_count.load() - allocations_before;
+
+    // Replaying from the snapshot must end in exactly the same state
+    for (int tick = 0; tick < replay_ticks; tick++) {
+        step_pool(pool, expired, integrate);
+    }
+    std::vector<uint8_t> first(pool.get_state_size());
+    pool.write_state(first.data());
+
+    pool.read_state(snapshot.data(), snapshot.size());
+    for (int tick = 0; tick < replay_ticks; tick++) {
+        step_pool(pool, expired, integrate);
+    }
+    std::vector<uint8_t> second(pool.get_state_size());
+    pool.write_state(second.data());
+
+    // The snapshot ends with the free list, or the spawn links when it is empty
+    std::vector<uint8_t> corrupt = snapshot;
+    uint32_t out_of_range = pool.get_capacity();
+    std::memcpy(corrupt.data() + corrupt.size() - sizeof(out_of_range), &out_of_range, sizeof(out_of_range));
+    bool rejected = !pool.read_state(corrupt.data(), corrupt.size());
+    std::vector<uint8_t> kept(pool.get_state_size());
+    pool.write_state(kept.data());
+
+    SnapshotResult result;
+    result.projectiles = p_count;
+    result.bytes = snapshot.size();
+    result.capture_usec = std::chrono::duration<double, std::micro>(capture_end - capture_start).count() / iterations;
+    result.restore_usec = std::chrono::duration<double, std::micro>(restore_end - restore_start).count() / iterations;
+    result.allocations_per_cycle = (double)allocations / iterations;
+    result.deterministic = first == second;
+    result.rejects_corrupt = rejected && kept == second;
+    return result;
+}
+
+// ================ REPLICATION LOOPBACK ================
+
+struct ReplicationResult {
+    uint32_t players;
+    uint32_t projectiles;
+    uint32_t ticks;
+    double bytes_per_tick;
+    double full_bytes_per_tick; // Same frames without a baseline
+    double spawns_per_tick;
+    double encode_usec;
+    double decode_usec;
+    bool lossless;
+    bool rejects_bad_counts;
+};
+
+static bool same_player(const QuantizedPlayer &a, const QuantizedPlayer &b) {
+    return a.id == b.id && a.position[0] == b.position[0] && a.position[1] == b.position[1] && a.position[2] == b.position[2] && a.yaw == b.yaw && a.pitch == b.pitch;
+}
+
+// Packets claiming far more players, removals or spawns than they carry must
+// fail to decode instead of sizing the frame from the claim
+static bool rejects_bad_counts() {
+    std::vector<uint8_t> packet;
+    BitWriter writer;
+    ReplicationDecoder decoder;
+    ReplicationFrame decoded;
+    for (int field = 0; field < 3; field++) {
+        writer.begin(packet);
+        writer.write(1, 32);
+        writer.write_bool(false);
+        for (int i = 0; i < field; i++) {
+            writer.write_varuint(0);
+        }
+        writer.write_varuint(0xFFFFFFFFu);
+        writer.finish();
+        decoder.reset();
+        if (decoder.decode(packet.data(), packet.size(), decoded) || decoded.players.size() > 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Server and client in one process: the client acks every packet and the
+// acks reach the server after ack_delay ticks, like a round trip would.
+static ReplicationResult run_replication(uint32_t p_players, uint32_t p_projectiles) {
+    const uint32_t ticks = 600;
+    const uint32_t ack_delay = 6;
+
+    std::mt19937 rng(2024);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> lifetime(0.5f, 2.0f);
+
+    // In-flight projectiles with a despawn tick, kept at a steady population
+    struct LiveProjectile {
+        QuantizedProjectile record;
+        uint32_t despawn_tick;
+    };
+    std::vector<LiveProjectile> live;
+    live.reserve(p_projectiles);
+    uint32_t next_projectile_id = 1;
+    auto spawn = [&](uint32_t p_tick) {
+        LiveProjectile projectile;
+        float direction[3] = { unit(rng), unit(rng) * 0.2f, unit(rng) };
+        float length = std::sqrt(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+        for (int i = 0; i < 3; i++) {
+            direction[i] /= length;
+        }
+        uint32_t shooter = 1 + (uint32_t)(rng() % p_players);
+        projectile.record.id = next_projectile_id++;
+        projectile.record.spawn_tick = p_tick;
+        projectile.record.shooter = shooter;
+        projectile.record.position[0] = ReplicationQuantize::position(unit(rng) * 100.0f);
+        projectile.record.position[1] = ReplicationQuantize::position(1.5f);
+        projectile.record.position[2] = ReplicationQuantize::position(unit(rng) * 100.0f);
+        ReplicationQuantize::direction(direction, projectile.record.direction);
+        projectile.record.speed = ReplicationQuantize::speed(150.0f);
+        projectile.record.range = ReplicationQuantize::range(300.0f);
+        projectile.record.damage = ReplicationQuantize::damage(20.0f);
+        projectile.despawn_tick = p_tick + (uint32_t)(lifetime(rng) / TICK_DELTA);
+        live.push_back(projectile);
+    };
+    for (uint32_t i = 0; i < p_projectiles; i++) {
+        spawn(0);
+    }
+
+    ReplicationEncoder encoder;
+    ReplicationEncoder full_encoder; // Never acked, for the comparison
+    ReplicationDecoder decoder;
+    encoder.reset();
+    full_encoder.reset();
+    decoder.reset();
+
+    ReplicationFrame frame;
+    ReplicationFrame decoded;
+    std::vector<uint8_t> packet;
+    std::vector<uint8_t> full_packet;
+    std::vector<uint32_t> pending_acks(ticks + 1, 0);
+
+    uint64_t total_bytes = 0;
+    uint64_t total_full_bytes = 0;
+    uint64_t total_spawns = 0;
+    double encode_usec = 0.0;
+    double decode_usec = 0.0;
+    bool lossless = true;
+
+    for (uint32_t tick = 1; tick <= ticks; tick++) {
+        if (tick > ack_delay) {
+            encoder.acknowledge(pending_acks[tick - ack_delay]);
+        }
+
+        // Players walk in circles and look around
+        frame.tick = tick;
+        frame.players.resize(p_players);
+        for (uint32_t i = 0; i < p_players; i++) {
+            float time = tick * TICK_DELTA;
+            float angle = time * (0.5f + (i % 5) * 0.2f) + i;
+            QuantizedPlayer &player = frame.players[i];
+            player.id = i + 1;
+            player.position[0] = ReplicationQuantize::position(std::cos(angle) * (10.0f + i));
+            player.position[1] = ReplicationQuantize::position(i % 3 == 0 ? 0.0f : std::fabs(std::sin(time * 3.0f)) * 1.2f);
+            player.position[2] = ReplicationQuantize::position(std::sin(angle) * (10.0f + i));
+            player.yaw = ReplicationQuantize::angle(angle + 1.57f);
+            player.pitch = ReplicationQuantize::angle(std::sin(time + i) * 0.3f);
+        }
+
+        size_t before = live.size();
+        for (size_t i = 0; i < live.size();) {
+            if (live[i].despawn_tick <= tick) {
+                live[i] = live.back();
+                live.pop_back();
+            } else {
+                i++;
+            }
+        }
+        size_t spawns = before - live.size();
+        for (size_t i = 0; i < spawns; i++) {
+            spawn(tick);
+        }
+        total_spawns += spawns;
+
+        // Ids only grow and survivors keep their order apart from swap-removal
+        std::sort(live.begin(), live.end(), [](const LiveProjectile &a, const LiveProjectile &b) {
+            return a.record.id < b.record.id;
+        });
+        frame.projectiles.resize(live.size());
+        for (size_t i = 0; i < live.size(); i++) {
+            frame.projectiles[i] = live[i].record;
+        }
+
+        auto encode_start = std::chrono::steady_clock::now();
+        encoder.encode(frame, packet);
+        auto encode_end = std::chrono::steady_clock::now();
+        bool ok = decoder.decode(packet.data(), packet.size(), decoded);
+        auto decode_end = std::chrono::steady_clock::now();
+
+        full_encoder.encode(frame, full_packet);
+
+        encode_usec += std::chrono::duration<double, std::micro>(encode_end - encode_start).count();
+        decode_usec += std::chrono::duration<double, std::micro>(decode_end - encode_end).count();
+        total_bytes += packet.size();
+        total_full_bytes += full_packet.size();
+
+        lossless = lossless && ok && decoded.players.size() == frame.players.size() && decoded.projectiles.size() == frame.projectiles.size();
+        for (size_t i = 0; lossless && i < frame.players.size(); i++) {
+            lossless = same_player(decoded.players[i], frame.players[i]);
+        }
+        for (size_t i = 0; lossless && i < frame.projectiles.size(); i++) {
+            lossless = decoded.projectiles[i].id == frame.projectiles[i].id && decoded.projectiles[i].spawn_tick == frame.projectiles[i].spawn_tick &&
+                    std::memcmp(decoded.projectiles[i].position, frame.projectiles[i].position, sizeof(frame.projectiles[i].position)) == 0;
+        }
+        pending_acks[tick] = tick;
+    }
+
+    ReplicationResult result;
+    result.players = p_players;
+    result.projectiles = p_projectiles;
+    result.ticks = ticks;
+    result.bytes_per_tick = (double)total_bytes / ticks;
+    result.full_bytes_per_tick = (double)total_full_bytes / ticks;
+    result.spawns_per_tick = (double)total_spawns / ticks;
+    result.encode_usec = encode_usec / ticks;
+    result.decode_usec = decode_usec / ticks;
+    result.lossless = lossless;
+    result.rejects_bad_counts = rejects_bad_counts();
+    return result;
+}
+
+// ================ BALLISTICS ================
+
+struct BallisticResult {
+    uint32_t projectiles;
+    uint32_t static_colliders;
+    uint32_t dynamic_colliders;
+    double tests_per_tick; // Segments left for the raycast stage
+    double skips_per_tick;
+    double idle_per_tick; // Not looked at, still inside their lookahead
+    double ns_per_projectile;
+    double allocations_per_tick;
+    bool bounds_exact;
+};
+
+// Rounds fired across a 400 m arena with crates on the ground and moving
+// targets, under gravity and drag. Every tick runs the broadphase over the
+// whole pool the way the collision stage does; an eager sweep would raycast
+// every projectile every tick.
+static BallisticResult run_ballistics(uint32_t p_count, uint32_t p_colliders) {
+    const int ticks = 600;
+    const uint32_t targets = 64;
+
+    std::mt19937 rng(19);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> speed(100.0f, 900.0f);
+    std::uniform_real_distribution<float> range(100.0f, 1500.0f);
+
+    ProjectilePool pool;
+    pool.reset(p_count);
+    ProjectileBallistics ballistics;
+    ballistics.gravity[1] = -9.8f;
+    ballistics.drag = 0.05f;
+    pool.set_ballistics(ballistics);
+
+    // Ground slab and crates are static, the targets are refreshed every tick
+    ProjectileBroadphase broadphase;
+    const float ground_min[3] = { -200.0f, -1.0f, -200.0f };
+    const float ground_max[3] = { 200.0f, 0.0f, 200.0f };
+    broadphase.add_static(ground_min, ground_max);
+    for (uint32_t i = 0; i < p_colliders; i++) {
+        float center[3] = { unit(rng) * 180.0f, 1.0f, unit(rng) * 180.0f };
+        float min[3] = { center[0] - 1.0f, 0.0f, center[2] - 1.0f };
+        float max[3] = { center[0] + 1.0f, 2.0f, center[2] + 1.0f };
+        broadphase.add_static(min, max);
+    }
+
+    // Fired from head height, mostly level with a little arc
+    std::vector<ProjectilePool::SpawnParams> spawns(p_count * 2);
+    for (ProjectilePool::SpawnParams &params : spawns) {
+        float dir[3] = { unit(rng), 0.05f + unit(rng) * 0.05f, unit(rng) };
+        float len = std::sqrt(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+        params.position[0] = unit(rng) * 150.0f;
+        params.position[1] = 1.6f;
+        params.position[2] = unit(rng) * 150.0f;
+        for (int axis = 0; axis < 3; axis++) {
+            params.direction[axis] = dir[axis] / len;
+        }
+        params.speed = speed(rng);
+        params.damage = 10.0f;
+        params.max_range = range(rng);
+        params.shooter = 1;
+    }
+    uint32_t spawn_cursor = 0;
+    for (uint32_t i = 0; i < p_count; i++) {
+        pool.spawn(spawns[spawn_cursor++]);
+    }
+
+    ProjectileKernels::IntegrateFunc integrate = ProjectileKernels::get_integrate_func(ProjectileKernels::get_best_isa());
+    std::vector<uint32_t> expired(p_count);
+    uint64_t tests = 0;
+    uint64_t skips = 0;
+    uint64_t idle = 0;
+    double sweep_nsec = 0.0;
+    uint64_t visited = 0;
+
+    uint64_t allocations_before = allocation_count.load();
+    for (int tick = 0; tick < ticks; tick++) {
+        ProjectileKernels::Streams streams = ProjectileKernels::get_streams(pool);
+        uint32_t expired_count = integrate(streams, 0, pool.get_count(), TICK_DELTA, expired.data());
+        pool.advance_time(TICK_DELTA);
+
+        broadphase.clear_dynamic();
+        for (uint32_t t = 0; t < targets; t++) {
+            float angle = (float)pool.get_time() * 0.5f + t;
+            float radius = 20.0f + t * 2.0f;
+            float min[3] = { std::cos(angle) * radius - 0.4f, 0.0f, std::sin(angle) * radius - 0.4f };
+            float max[3] = { min[0] + 0.8f, 1.8f, min[2] + 0.8f };
+            broadphase.add_dynamic(min, max);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        double now = pool.get_time();
+        for (uint32_t i = 0; i < pool.get_count(); i++) {
+            float from[3];
+            float to[3];
+            switch (broadphase.prepare_sweep(pool, i, now, from, to)) {
+                case ProjectileBroadphase::SWEEP_IDLE:
+                    idle++;
+                    break;
+                case ProjectileBroadphase::SWEEP_SKIP:
+                    skips++;
+                    break;
+                case ProjectileBroadphase::SWEEP_TEST:
+                    pool.swept_time[i] = now;
+                    tests++;
+                    break;
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        sweep_nsec += std::chrono::duration<double, std::nano>(end - start).count();
+        visited += pool.get_count();
+
+        for (uint32_t i = expired_count; i > 0; i--) {
+            pool.release_dense(expired[i - 1]);
+        }
+        for (uint32_t i = 0; i < expired_count; i++) {
+            pool.spawn(spawns[spawn_cursor]);
+            spawn_cursor = (spawn_cursor + 1) % spawns.size();
+        }
+    }
+    uint64_t allocations = allocation_count.load() - allocations_before;
+
+    // The path bounds must contain densely sampled points of the same path
+    bool bounds_exact = true;
+    for (uint32_t i = 0; bounds_exact && i < std::min<uint32_t>(pool.get_count(), 256); i++) {
+        double from_time = pool.spawn_time[i];
+        double to_time = std::min(pool.get_expiry_time(i), from_time + 3.0);
+        float min[3];
+        float max[3];
+        pool.get_path_bounds(i, from_time, to_time, min, max);
+        for (int step = 0; bounds_exact && step <= 64; step++) {
+            float position[3];
+            pool.get_position(i, from_time + (to_time - from_time) * step / 64.0, position);
+            for (int axis = 0; axis < 3; axis++) {
+                float slack = 1e-3f * (1.0f + std::fabs(position[axis]));
+                bounds_exact = bounds_exact && position[axis] >= min[axis] - slack && position[axis] <= max[axis] + slack;
+            }
+        }
+    }
+
+    BallisticResult result;
+    result.projectiles = p_count;
+    result.static_colliders = broadphase.get_static_count();
+    result.dynamic_colliders = broadphase.get_dynamic_count();
+    result.tests_per_tick = (double)tests / ticks;
+    result.skips_per_tick = (double)skips / ticks;
+    result.idle_per_tick = (double)idle / ticks;
+    result.ns_per_projectile = visited > 0 ? sweep_nsec / visited : 0.0;
+    result.allocations_per_tick = (double)allocations / ticks;
+    result.bounds_exact = bounds_exact;
+    return result;
+}
+
+// ================ HURTBOXES ================
+
+struct HurtboxResult {
+    uint32_t targets;
+    uint32_t segments;
+    int32_t tree_height;
+    double refit_usec; // Moving every target once
+    double reinserts_per_tick;
+    double tree_ns_per_segment;
+    double linear_ns_per_segment; // Every hurtbox tested, the cost without a tree
+    double hit_rate;
+    double allocations_per_tick;
+    bool matches_linear;
+};
+
+// Targets walk around a square arena whose area grows with their count, so
+// the density stays that of a busy match. Segments are one tick of projectile
+// flight (5-15 m) from random points, aimed roughly at a target so a fair
+// share of them hit.
+static void hurtbox_pose(uint32_t p_target, uint32_t p_targets, double p_time, HitboxHistory::Pose &r_pose) {
+    float half = 4.0f * std::sqrt((float)p_targets);
+    float phase = p_target * 2.399963f; // Golden angle, spreads the targets out
+    float x = std::fmod(p_target * 7.31f, 2.0f * half) - half;
+    float z = std::fmod(p_target * 13.17f, 2.0f * half) - half;
+    float yaw = (float)p_time * 0.7f + phase;
+
+    entity_pose(p_target, p_time, r_pose);
+    r_pose.position[0] = x + std::cos((float)p_time * 0.9f + phase) * 3.0f;
+    r_pose.position[1] = 0.0f;
+    r_pose.position[2] = z + std::sin((float)p_time * 1.1f + phase) * 3.0f;
+    r_pose.rotation[1] = std::sin(yaw * 0.5f);
+    r_pose.rotation[3] = std::cos(yaw * 0.5f);
+}
+
+static bool linear_raycast(const std::vector<HitboxHistory::Pose> &p_poses, const HurtboxTree::Segment &p_segment, HurtboxTree::Hit &r_hit) {
+    float direction[3] = { p_segment.to[0] - p_segment.from[0], p_segment.to[1] - p_segment.from[1], p_segment.to[2] - p_segment.from[2] };
+    r_hit = HurtboxTree::Hit();
+    float nearest = 1.0f;
+    for (const HitboxHistory::Pose &pose : p_poses) {
+        float fraction;
+        if (pose.key != p_segment.ignore_key && HitboxHistory::intersect_pose(pose, p_segment.from, direction, nearest, fraction)) {
+            nearest = fraction;
+            r_hit.key = pose.key;
+        }
+    }
+    r_hit.fraction = nearest;
+    return r_hit.key != 0;
+}
+
+static HurtboxResult run_hurtboxes(uint32_t p_targets, uint32_t p_segments) {
+    const int ticks = 120;
+
+    HurtboxTree tree;
+    tree.reserve(p_targets);
+    std::vector<HitboxHistory::Pose> poses(p_targets);
+    std::vector<uint32_t> proxies(p_targets);
+    for (uint32_t t = 0; t < p_targets; t++) {
+        hurtbox_pose(t, p_targets, 0.0, poses[t]);
+        proxies[t] = tree.create_proxy(poses[t]);
+    }
+    tree.take_reinsert_count();
+
+    std::mt19937 rng(23);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> length(5.0f, 15.0f);
+    std::uniform_int_distribution<uint32_t> target(0, p_targets - 1);
+    std::vector<HurtboxTree::Segment> segments(p_segments);
+    std::vector<HurtboxTree::Hit> tree_hits(p_segments);
+    std::vector<HurtboxTree::Hit> linear_hits(p_segments);
+
+    double refit_nsec = 0.0;
+    double tree_nsec = 0.0;
+    double linear_nsec = 0.0;
+    uint64_t reinserts = 0;
+    uint64_t hits = 0;
+    uint64_t allocations = 0;
+    bool matches = true;
+    for (int tick = 1; tick <= ticks; tick++) {
+        double time = tick * (double)TICK_DELTA;
+        for (uint32_t t = 0; t < p_targets; t++) {
+            hurtbox_pose(t, p_targets, time, poses[t]);
+        }
+
+        // Segments start a few meters from a target, slightly off its center
+        for (HurtboxTree::Segment &segment : segments) {
+            const HitboxHistory::Pose &aim = poses[target(rng)];
+            float dir[3] = { unit(rng), unit(rng) * 0.1f, unit(rng) };
+            float len = std::sqrt(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+            float travel = length(rng);
+            for (int i = 0; i < 3; i++) {
+                float to_center = (i == 1 ? 1.2f : 0.0f) + unit(rng) * 0.5f;
+                segment.from[i] = aim.position[i] + to_center - dir[i] / len * travel * 0.5f;
+                segment.to[i] = segment.from[i] + dir[i] / len * travel;
+            }
+            segment.ignore_key = 0;
+        }
+
+        uint64_t allocations_before = allocation_count.load();
+        auto refit_start = std::chrono::steady_clock::now();
+        for (uint32_t t = 0; t < p_targets; t++) {
+            tree.move_proxy(proxies[t], poses[t]);
+        }
+        auto query_start = std::chrono::steady_clock::now();
+        hits += tree.raycast_batch(segments.data(), p_segments, tree_hits.data());
+        auto query_end = std::chrono::steady_clock::now();
+        allocations += allocation_count.load() - allocations_before;
+        reinserts += tree.take_reinsert_count();
+
+        for (uint32_t s = 0; s < p_segments; s++) {
+            linear_raycast(poses, segments[s], linear_hits[s]);
+        }
+        auto linear_end = std::chrono::steady_clock::now();
+
+        refit_nsec += std::chrono::duration<double, std::nano>(query_start - refit_start).count();
+        tree_nsec += std::chrono::duration<double, std::nano>(query_end - query_start).count();
+        linear_nsec += std::chrono::duration<double, std::nano>(linear_end - query_end).count();
+
+        // Same nearest target; the fraction may differ in the last bits only
+        // when two boxes are hit at the same distance
+        for (uint32_t s = 0; s < p_segments; s++) {
+            const HurtboxTree::Hit &a = tree_hits[s];
+            const HurtboxTree::Hit &b = linear_hits[s];
+            if (a.key != b.key && std::fabs(a.fraction - b.fraction) > 1e-5f) {
+                matches = false;
+            }
+        }
+    }
+    matches = matches && tree.validate();
+
+    HurtboxResult result;
+    result.targets = p_targets;
+    result.segments = p_segments;
+    result.tree_height = tree.get_height();
+    result.refit_usec = refit_nsec / ticks / 1000.0;
+    result.reinserts_per_tick = (double)reinserts / ticks;
+    result.tree_ns_per_segment = tree_nsec / ((double)ticks * p_segments);
+    result.linear_ns_per_segment = linear_nsec / ((double)ticks * p_segments);
+    result.hit_rate = (double)hits / ((double)ticks * p_segments);
+    result.allocations_per_tick = (double)allocations / ticks;
+    result.matches_linear = matches;
+    return result;
+}
+
+// A target that only the hurtbox tree knows about, i.e. a Health body that is
+// not lag compensated, must keep projectiles aimed at it from being skipped
+// once level geometry makes the broadphase active
+static bool hurtbox_stops_skipping() {
+    ProjectilePool pool;
+    pool.reset(1);
+    ProjectilePool::SpawnParams params;
+    params.position[1] = 1.2f;
+    params.direction[0] = 0.0f;
+    params.direction[2] = 1.0f;
+    params.speed = 300.0f;
+    params.max_range = 200.0f;
+    pool.spawn(params);
+
+    ProjectileBroadphase broadphase;
+    const float far_min[3] = { 500.0f, 0.0f, 500.0f };
+    const float far_max[3] = { 510.0f, 10.0f, 510.0f };
+    broadphase.add_static(far_min, far_max);
+
+    HurtboxTree tree;
+    HitboxHistory::Pose target;
+    target.position[2] = 40.0f;
+    target.center[1] = 0.9f;
+    target.half_extents[0] = 0.4f;
+    target.half_extents[1] = 0.9f;
+    target.half_extents[2] = 0.4f;
+    target.key = 7;
+    tree.create_proxy(target);
+
+    for (int tick = 0; tick < 60; tick++) {
+        pool.advance_time(TICK_DELTA);
+        broadphase.clear_dynamic();
+        broadphase.add_hurtboxes(tree, true);
+
+        float from[3];
+        float to[3];
+        if (broadphase.prepare_sweep(pool, 0, pool.get_time(), from, to) == ProjectileBroadphase::SWEEP_TEST) {
+            pool.swept_time[0] = pool.get_time();
+            HurtboxTree::Hit hit;
+            if (tree.raycast(from, to, 0, hit)) {
+                return hit.key == target.key;
+            }
+        }
+    }
+    return false;
+}
+
+// ================ FRAME ARENA ================
+
+struct ArenaResult {
+    uint32_t hits;
+    double arena_usec;
+    double heap_usec; // The same work on std::vector
+    size_t peak_bytes;
+    double warm_allocations_per_tick; // Heap allocations once the arena has grown
+    double heap_allocations_per_tick;
+    bool allocation_free;
+};
+
+struct ArenaHit {
+    uint32_t projectile;
+    uint32_t target;
+    float fraction;
+};
+
+// One tick of collision scratch: hit lists that grow without a reserve, as the
+// stage does, and an index list sorted by target. The hit count varies from
+// tick to tick up to p_hits.
+template <template <typename> class V>
+static void arena_tick(std::mt19937 &r_rng, uint32_t p_hits) {
+    std::uniform_int_distribution<uint32_t> count(p_hits / 2, p_hits);
+    std::uniform_int_distribution<uint32_t> target(0, 255);
+    V<ArenaHit> hits;
+    V<uint32_t> order;
+    uint32_t n = count(r_rng);
+    for (uint32_t i = 0; i < n; i++) {
+        hits.push_back({ i, target(r_rng), 0.5f });
+        order.push_back(i);
+    }
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return hits[a].target != hits[b].target ? hits[a].target < hits[b].target : a < b;
+    });
+}
+
+template <typename T>
+using HeapVector = std::vector<T>;
+
+static ArenaResult run_arena(uint32_t p_hits) {
+    const int warm_up = 8;
+    const int ticks = 240;
+
+    FrameArena &arena = FrameArena::get_thread_arena();
+    std::mt19937 rng(31);
+    for (int tick = 0; tick < warm_up; tick++) {
+        arena_tick<FrameVector>(rng, p_hits);
+        arena.reset();
+    }
+
+    size_t peak = 0;
+    uint64_t allocations_before = allocation_count.load();
+    auto arena_start = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < ticks; tick++) {
+        arena_tick<FrameVector>(rng, p_hits);
+        arena.reset();
+        peak = std::max(peak, arena.get_peak_last_tick());
+    }
+    auto arena_end = std::chrono::steady_clock::now();
+    uint64_t arena_allocations = allocation_count.load() - allocations_before;
+
+    allocations_before = allocation_count.load();
+    for (int tick = 0; tick < ticks; tick++) {
+        arena_tick<HeapVector>(rng, p_hits);
+    }
+    auto heap_end = std::chrono::steady_clock::now();
+    uint64_t heap_allocations = allocation_count.load() - allocations_before;
+
+    // The arena gets its blocks from malloc, which the counter does not see
+    uint64_t block_allocations = arena.get_block_allocations_total();
+    for (int tick = 0; tick < ticks; tick++) {
+        arena_tick<FrameVector>(rng, p_hits);
+        arena.reset();
+    }
+    block_allocations = arena.get_block_allocations_total() - block_allocations;
+
+    ArenaResult result;
+    result.hits = p_hits;
+    result.arena_usec = std::chrono::duration<double, std::micro>(arena_end - arena_start).count() / ticks;
+    result.heap_usec = std::chrono::duration<double, std::micro>(heap_end - arena_end).count() / ticks;
+    result.peak_bytes = peak;
+    result.warm_allocations_per_tick = (double)(arena_allocations + block_allocations) / ticks;
+    result.heap_allocations_per_tick = (double)heap_allocations / ticks;
+    result.allocation_free = arena_allocations == 0 && block_allocations == 0;
+    return result;
+}
+
+// ================ COMMAND LINE ================
+
+template <typename T>
+static std::vector<T> parse_list(const std::string &p_value) {
+    std::vector<T> values;
+    size_t start = 0;
+    while (start <= p_value.size()) {
+        size_t comma = p_value.find(',', start);
+        std::string item = p_value.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+        if (!item.empty()) {
+            values.push_back((T)std::strtoll(item.c_str(), nullptr, 10));
+        }
+        if (comma == std::string::npos) {
+            break;
+        }
+        start = comma + 1;
+    }
+    return values;
+}
+
+static bool parse_kernels(const std::string &p_value, std::vector<ProjectileKernels::Isa> &r_kernels) {
+    r_kernels.clear();
+    if (p_value == "all") {
+        // Every kernel the CPU can run, without duplicates from fallbacks
+        for (int isa = ProjectileKernels::ISA_SCALAR; isa <= ProjectileKernels::get_best_isa(); isa++) {
+            r_kernels.push_back((ProjectileKernels::Isa)isa);
+        }
+        return true;
+    }
+
+    size_t start = 0;
+    while (start <= p_value.size()) {
+        size_t comma = p_value.find(',', start);
+        std::string name = p_value.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+        if (name == "auto") {
+            r_kernels.push_back(ProjectileKernels::get_best_isa());
+        } else if (name == "scalar") {
+            r_kernels.push_back(ProjectileKernels::ISA_SCALAR);
+        } else if (name == "sse2") {
+            r_kernels.push_back(ProjectileKernels::ISA_SSE2);
+        } else if (name == "avx2") {
+            r_kernels.push_back(ProjectileKernels::ISA_AVX2);
+        } else {
+            std::fprintf(stderr, "Unknown kernel '%s'\n", name.c_str());
+            return false;
+        }
+        if (comma == std::string::npos) {
+            break;
+        }
+        start = comma + 1;
+    }
+    return true;
+}
+
+static bool parse_args(int argc, char **argv, BenchConfig &r_config) {
+    parse_kernels("all", r_config.kernels);
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+
+        if (key == "--counts") {
+            r_config.counts = parse_list<uint32_t>(value);
+        } else if (key == "--threads") {
+            r_config.threads = parse_list<int>(value);
+        } else if (key == "--ticks") {
+            r_config.ticks = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--kernels") {
+            if (!parse_kernels(value, r_config.kernels)) {
+                return false;
+            }
+        } else if (key == "--rewind-entities") {
+            r_config.rewind_entities = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--rewind-history") {
+            r_config.rewind_history = std::max(0.05, std::atof(value.c_str()));
+        } else if (key == "--rewind-shots") {
+            r_config.rewind_shots = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--snapshot-count") {
+            r_config.snapshot_count = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--replication-players") {
+            r_config.replication_players = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--replication-projectiles") {
+            r_config.replication_projectiles = std::max(0, std::atoi(value.c_str()));
+        } else if (key == "--ballistic-projectiles") {
+            r_config.ballistic_projectiles = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--ballistic-colliders") {
+            r_config.ballistic_colliders = std::max(0, std::atoi(value.c_str()));
+        } else if (key == "--hurtbox-targets") {
+            r_config.hurtbox_targets = parse_list<uint32_t>(value);
+        } else if (key == "--hurtbox-segments") {
+            r_config.hurtbox_segments = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--arena-hits") {
+            r_config.arena_hits = std::max(2, std::atoi(value.c_str()));
+        } else if (key == "--output") {
+            r_config.output = value;
+        } else {
+            std::fprintf(stderr, "Unknown argument '%s'\n", arg.c_str());
+            return false;
+        }
+    }
+    for (uint32_t targets : r_config.hurtbox_targets) {
+        if (targets == 0) {
+            return false;
+        }
+    }
+    return !r_config.counts.empty() && !r_config.threads.empty() && !r_config.kernels.empty();
+}
+
+int main(int argc, char **argv) {
+    BenchConfig config;
+    if (!parse_args(argc, argv, config)) {
+        std::fprintf(stderr, "usage: projectile_bench [--counts=N,...] [--threads=N,...] [--ticks=N] [--kernels=all|auto|scalar,sse2,avx2] [--rewind-entities=N] [--rewind-history=SECONDS] [--rewind-shots=N] [--snapshot-count=N] [--replication-players=N] [--replication-projectiles=N] [--ballistic-projectiles=N] [--ballistic-colliders=N] [--hurtbox-targets=N,...] [--hurtbox-segments=N] [--arena-hits=N] [--output=file.json]\n");
+        return 2;
+    }
+
+    FILE *out = stdout;
+    if (!config.output.empty()) {
+        out = std::fopen(config.output.c_str(), "w");
+        if (!out) {
+            std::fprintf(stderr, "Cannot open '%s' for writing\n", config.output.c_str());
+            return 2;
+        }
+    }
+
+    bool all_valid = true;
+    std::fprintf(out, "{\n  \"cpu_isa\": \"%s\",\n  \"ticks\": %d,\n  \"tick_delta\": %.6f,\n", ProjectileKernels::get_isa_name(ProjectileKernels::get_best_isa()), config.ticks, TICK_DELTA);
+
+    std::fprintf(out, "  \"validation\": {");
+    for (size_t k = 0; k < config.kernels.size(); k++) {
+        ProjectileKernels::Isa kernel = ProjectileKernels::resolve_isa(config.kernels[k]);
+        bool valid = ProjectileKernels::matches_scalar(kernel);
+        all_valid = all_valid && valid;
+        std::fprintf(out, "%s\"%s\": %s", k > 0 ? ", " : "", ProjectileKernels::get_isa_name(kernel), valid ? "true" : "false");
+    }
+    std::fprintf(out, "},\n  \"results\": [\n");
+
+    bool first = true;
+    for (int threads : config.threads) {
+        ChunkRunner runner(std::max(1, threads));
+        for (ProjectileKernels::Isa requested : config.kernels) {
+            ProjectileKernels::Isa kernel = ProjectileKernels::resolve_isa(requested);
+            for (uint32_t count : config.counts) {
+                BenchResult r = run_case(kernel, count, runner, config.ticks);
+                std::fprintf(out, "%s    {\"kernel\": \"%s\", \"projectiles\": %u, \"threads\": %d, \"ns_per_projectile\": %.3f, \"mean_usec\": %.3f, \"p50_usec\": %.3f, \"p99_usec\": %.3f, \"allocations_per_tick\": %.3f, \"expired_per_tick\": %.1f}",
+                        first ? "" : ",\n", ProjectileKernels::get_isa_name(r.kernel), r.projectiles, r.threads, r.ns_per_projectile, r.mean_usec, r.p50_usec, r.p99_usec, r.allocations_per_tick, r.expired_per_tick);
+                std::fflush(out);
+                first = false;
+            }
+        }
+    }
+    std::fprintf(out, "\n  ],\n");
+
+    RewindResult rewind = run_rewind(config.rewind_entities, config.rewind_history, config.rewind_shots);
+    std::fprintf(out, "  \"rewind\": {\"entities\": %u, \"frames\": %u, \"shots\": %u, \"ns_per_shot\": %.3f, \"ns_per_record\": %.3f, \"hit_rate\": %.3f, \"allocations_per_shot\": %.3f},\n",
+            rewind.entities, rewind.frames, rewind.shots, rewind.ns_per_shot, rewind.ns_per_record, rewind.hit_rate, rewind.allocations_per_shot);
+
+    SnapshotResult snapshot = run_snapshot(config.snapshot_count);
+    all_valid = all_valid && snapshot.deterministic && snapshot.rejects_corrupt;
+    std::fprintf(out, "  \"snapshot\": {\"projectiles\": %u, \"bytes\": %zu, \"capture_usec\": %.3f, \"restore_usec\": %.3f, \"allocations_per_cycle\": %.3f, \"deterministic\": %s, \"rejects_corrupt\": %s},\n",
+            snapshot.projectiles, snapshot.bytes, snapshot.capture_usec, snapshot.restore_usec, snapshot.allocations_per_cycle, snapshot.deterministic ? "true" : "false", snapshot.rejects_corrupt ? "true" : "false");
+
+    ReplicationResult replication = run_replication(config.replication_players, config.replication_projectiles);
+    all_valid = all_valid && replication.lossless && replication.rejects_bad_counts;
+    std::fprintf(out, "  \"replication\": {\"players\": %u, \"projectiles\": %u, \"ticks\": %u, \"bytes_per_tick\": %.1f, \"full_bytes_per_tick\": %.1f, \"spawns_per_tick\": %.1f, \"encode_usec\": %.3f, \"decode_usec\": %.3f, \"lossless\": %s, \"rejects_bad_counts\": %s},\n",
+            replication.players, replication.projectiles, replication.ticks, replication.bytes_per_tick, replication.full_bytes_per_tick, replication.spawns_per_tick, replication.encode_usec, replication.decode_usec, replication.lossless ? "true" : "false", replication.rejects_bad_counts ? "true" : "false");
+
+    BallisticResult ballistic = run_ballistics(config.ballistic_projectiles, config.ballistic_colliders);
+    all_valid = all_valid && ballistic.bounds_exact;
+    std::fprintf(out, "  \"ballistics\": {\"projectiles\": %u, \"static_colliders\": %u, \"dynamic_colliders\": %u, \"tests_per_tick\": %.1f, \"skips_per_tick\": %.1f, \"idle_per_tick\": %.1f, \"ns_per_projectile\": %.3f, \"allocations_per_tick\": %.3f, \"bounds_exact\": %s},\n",
+            ballistic.projectiles, ballistic.static_colliders, ballistic.dynamic_colliders, ballistic.tests_per_tick, ballistic.skips_per_tick, ballistic.idle_per_tick, ballistic.ns_per_projectile, ballistic.allocations_per_tick, ballistic.bounds_exact ? "true" : "false");
+
+    bool hurtbox_hit = hurtbox_stops_skipping();
+    all_valid = all_valid && hurtbox_hit;
+    std::fprintf(out, "  \"hurtbox_broadphase_hit\": %s,\n", hurtbox_hit ? "true" : "false");
+
+    std::fprintf(out, "  \"hurtboxes\": [\n");
+    for (size_t i = 0; i < config.hurtbox_targets.size(); i++) {
+        HurtboxResult h = run_hurtboxes(config.hurtbox_targets[i], config.hurtbox_segments);
+        all_valid = all_valid && h.matches_linear;
+        std::fprintf(out, "%s    {\"targets\": %u, \"segments\": %u, \"tree_height\": %d, \"refit_usec\": %.3f, \"reinserts_per_tick\": %.1f, \"tree_ns_per_segment\": %.3f, \"linear_ns_per_segment\": %.3f, \"hit_rate\": %.3f, \"allocations_per_tick\": %.3f, \"matches_linear\": %s}",
+                i > 0 ? ",\n" : "", h.targets, h.segments, h.tree_height, h.refit_usec, h.reinserts_per_tick, h.tree_ns_per_segment, h.linear_ns_per_segment, h.hit_rate, h.allocations_per_tick, h.matches_linear ? "true" : "false");
+        std::fflush(out);
+    }
+    std::fprintf(out, "\n  ],\n");
+
+    ArenaResult arena = run_arena(config.arena_hits);
+    all_valid = all_valid && arena.allocation_free;
+    std::fprintf(out, "  \"frame_arena\": {\"hits\": %u, \"arena_usec\": %.3f, \"heap_usec\": %.3f, \"peak_bytes\": %zu, \"warm_allocations_per_tick\": %.3f, \"heap_allocations_per_tick\": %.3f, \"allocation_free\": %s}\n}\n",
+            arena.hits, arena.arena_usec, arena.heap_usec, arena.peak_bytes, arena.warm_allocations_per_tick, arena.heap_allocations_per_tick, arena.allocation_free ? "true" : "false");
+
+    if (out != stdout) {
+        std::fclose(out);
+    }
+
+    // A kernel that disagrees with the scalar path, a replay that diverges, a
+    // lossy replication round trip, path bounds that miss part of the path or
+    // a hurtbox tree that disagrees with the linear scan make the timings
+    // meaningless. So do a broadphase that skips past a hurtbox and a frame
+    // arena that still allocates once warm.
+    return all_valid ? 0 : 1;
+}
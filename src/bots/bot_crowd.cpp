@@ -0,0 +1,612 @@
+#include "bot_crowd.hpp"
+#include "../combat/entities.hpp"
+#include "../debug/perf_monitors.hpp"
+#include "../debug/trace.hpp"
+#include "../weapons/projectile_broadphase.hpp"
+#include <godot_cpp/classes/engine.hpp>
+#include <godot_cpp/classes/physics_server3d.hpp>
+#include <godot_cpp/classes/rendering_server.hpp>
+#include <godot_cpp/classes/scene_tree.hpp>
+#include <godot_cpp/classes/time.hpp>
+#include <godot_cpp/classes/world3d.hpp>
+#include <godot_cpp/variant/callable_method_pointer.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace godot;
+
+// Contacts whose normal points up more than this are floor, as with move_and_slide's 45 degrees
+static const float FLOOR_NORMAL_Y = 0.7071f;
+
+// A blocked sweep slides along the contact once
+static const int MAX_SLIDES = 2;
+
+// Shots leave from just outside the capsule so the shooter is not hit
+static const float MUZZLE_CLEARANCE = 0.2f;
+
+// Bots that fall this far below the crowd are put back in the arena
+static const float FALL_LIMIT = 50.0f;
+
+// Random samples per retarget when looking for another bot in range
+static const int BOT_TARGET_SAMPLES = 4;
+
+std::vector<BotCrowd *> BotCrowd::monitored_crowds;
+
+BotCrowd::BotCrowd() {
+    motion_parameters.instantiate();
+    motion_parameters->set_max_collisions(1);
+    motion_result.instantiate();
+}
+
+BotCrowd::~BotCrowd() {}
+
+void BotCrowd::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("get_active_bot_count"), &BotCrowd::get_active_bot_count);
+    ClassDB::bind_method(D_METHOD("get_bot_positions"), &BotCrowd::get_bot_positions);
+    ClassDB::bind_method(D_METHOD("get_update_usec_last_tick"), &BotCrowd::get_update_usec_last_tick);
+    ClassDB::bind_method(D_METHOD("get_shots_last_tick"), &BotCrowd::get_shots_last_tick);
+    ClassDB::bind_method(D_METHOD("get_motion_tests_last_tick"), &BotCrowd::get_motion_tests_last_tick);
+
+    ClassDB::bind_method(D_METHOD("get_bot_count"), &BotCrowd::get_bot_count);
+    ClassDB::bind_method(D_METHOD("set_bot_count", "count"), &BotCrowd::set_bot_count);
+    ClassDB::bind_method(D_METHOD("get_speed"), &BotCrowd::get_speed);
+    ClassDB::bind_method(D_METHOD("set_speed", "speed"), &BotCrowd::set_speed);
+    ClassDB::bind_method(D_METHOD("get_gravity"), &BotCrowd::get_gravity);
+    ClassDB::bind_method(D_METHOD("set_gravity", "gravity"), &BotCrowd::set_gravity);
+    ClassDB::bind_method(D_METHOD("get_jump_velocity"), &BotCrowd::get_jump_velocity);
+    ClassDB::bind_method(D_METHOD("set_jump_velocity", "jump_velocity"), &BotCrowd::set_jump_velocity);
+    ClassDB::bind_method(D_METHOD("get_jump_chance"), &BotCrowd::get_jump_chance);
+    ClassDB::bind_method(D_METHOD("set_jump_chance", "chance"), &BotCrowd::set_jump_chance);
+    ClassDB::bind_method(D_METHOD("get_arena_half_extents"), &BotCrowd::get_arena_half_extents);
+    ClassDB::bind_method(D_METHOD("set_arena_half_extents", "extents"), &BotCrowd::set_arena_half_extents);
+    ClassDB::bind_method(D_METHOD("get_seed"), &BotCrowd::get_seed);
+    ClassDB::bind_method(D_METHOD("set_seed", "seed"), &BotCrowd::set_seed);
+    ClassDB::bind_method(D_METHOD("get_body_radius"), &BotCrowd::get_body_radius);
+    ClassDB::bind_method(D_METHOD("set_body_radius", "radius"), &BotCrowd::set_body_radius);
+    ClassDB::bind_method(D_METHOD("get_body_height"), &BotCrowd::get_body_height);
+    ClassDB::bind_method(D_METHOD("set_body_height", "height"), &BotCrowd::set_body_height);
+    ClassDB::bind_method(D_METHOD("get_collision_layer"), &BotCrowd::get_collision_layer);
+    ClassDB::bind_method(D_METHOD("set_collision_layer", "layer"), &BotCrowd::set_collision_layer);
+    ClassDB::bind_method(D_METHOD("get_collision_mask"), &BotCrowd::get_collision_mask);
+    ClassDB::bind_method(D_METHOD("set_collision_mask", "mask"), &BotCrowd::set_collision_mask);
+    ClassDB::bind_method(D_METHOD("get_fire_mode"), &BotCrowd::get_fire_mode);
+    ClassDB::bind_method(D_METHOD("set_fire_mode", "mode"), &BotCrowd::set_fire_mode);
+    ClassDB::bind_method(D_METHOD("get_damage"), &BotCrowd::get_damage);
+    ClassDB::bind_method(D_METHOD("set_damage", "damage"), &BotCrowd::set_damage);
+    ClassDB::bind_method(D_METHOD("get_range"), &BotCrowd::get_range);
+    ClassDB::bind_method(D_METHOD("set_range", "range"), &BotCrowd::set_range);
+    ClassDB::bind_method(D_METHOD("get_projectile_speed"), &BotCrowd::get_projectile_speed);
+    ClassDB::bind_method(D_METHOD("set_projectile_speed", "speed"), &BotCrowd::set_projectile_speed);
+    ClassDB::bind_method(D_METHOD("get_rounds_per_minute"), &BotCrowd::get_rounds_per_minute);
+    ClassDB::bind_method(D_METHOD("set_rounds_per_minute", "rpm"), &BotCrowd::set_rounds_per_minute);
+    ClassDB::bind_method(D_METHOD("get_spread_degrees"), &BotCrowd::get_spread_degrees);
+    ClassDB::bind_method(D_METHOD("set_spread_degrees", "degrees"), &BotCrowd::set_spread_degrees);
+    ClassDB::bind_method(D_METHOD("get_fire_range"), &BotCrowd::get_fire_range);
+    ClassDB::bind_method(D_METHOD("set_fire_range", "range"), &BotCrowd::set_fire_range);
+    ClassDB::bind_method(D_METHOD("get_retarget_interval"), &BotCrowd::get_retarget_interval);
+    ClassDB::bind_method(D_METHOD("set_retarget_interval", "interval"), &BotCrowd::set_retarget_interval);
+    ClassDB::bind_method(D_METHOD("get_target_group"), &BotCrowd::get_target_group);
+    ClassDB::bind_method(D_METHOD("set_target_group", "group"), &BotCrowd::set_target_group);
+    ClassDB::bind_method(D_METHOD("get_target_bots"), &BotCrowd::get_target_bots);
+    ClassDB::bind_method(D_METHOD("set_target_bots", "enable"), &BotCrowd::set_target_bots);
+    ClassDB::bind_method(D_METHOD("get_bot_mesh"), &BotCrowd::get_bot_mesh);
+    ClassDB::bind_method(D_METHOD("set_bot_mesh", "mesh"), &BotCrowd::set_bot_mesh);
+
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "bot_count", PROPERTY_HINT_RANGE, "0,4096,1,or_greater"), "set_bot_count", "get_bot_count");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "speed"), "set_speed", "get_speed");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "gravity"), "set_gravity", "get_gravity");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "jump_velocity"), "set_jump_velocity", "get_jump_velocity");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "jump_chance", PROPERTY_HINT_RANGE, "0,10,0.01,suffix:/s"), "set_jump_chance", "get_jump_chance");
+    ADD_PROPERTY(PropertyInfo(Variant::VECTOR2, "arena_half_extents", PROPERTY_HINT_NONE, "suffix:m"), "set_arena_half_extents", "get_arena_half_extents");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "seed"), "set_seed", "get_seed");
+    ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "bot_mesh", PROPERTY_HINT_RESOURCE_TYPE, "Mesh"), "set_bot_mesh", "get_bot_mesh");
+
+    ADD_GROUP("Body", "");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "body_radius", PROPERTY_HINT_RANGE, "0.05,5,0.01,suffix:m"), "set_body_radius", "get_body_radius");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "body_height", PROPERTY_HINT_RANGE, "0.1,10,0.01,suffix:m"), "set_body_height", "get_body_height");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "collision_layer", PROPERTY_HINT_LAYERS_3D_PHYSICS), "set_collision_layer", "get_collision_layer");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "collision_mask", PROPERTY_HINT_LAYERS_3D_PHYSICS), "set_collision_mask", "get_collision_mask");
+
+    ADD_GROUP("Firing", "");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "fire_mode", PROPERTY_HINT_ENUM, "Hitscan,Projectile"), "set_fire_mode", "get_fire_mode");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "damage", PROPERTY_HINT_RANGE, "0,1000,0.1,or_greater"), "set_damage", "get_damage");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "range", PROPERTY_HINT_RANGE, "1,5000,1,or_greater,suffix:m"), "set_range", "get_range");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "projectile_speed", PROPERTY_HINT_RANGE, "1,2000,1,or_greater,suffix:m/s"), "set_projectile_speed", "get_projectile_speed");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "rounds_per_minute", PROPERTY_HINT_RANGE, "1,2000,1,or_greater"), "set_rounds_per_minute", "get_rounds_per_minute");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "spread_degrees", PROPERTY_HINT_RANGE, "0,45,0.1,suffix:deg"), "set_spread_degrees", "get_spread_degrees");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "fire_range", PROPERTY_HINT_RANGE, "0,1000,1,or_greater,suffix:m"), "set_fire_range", "get_fire_range");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "retarget_interval", PROPERTY_HINT_RANGE, "0.05,10,0.05,suffix:s"), "set_retarget_interval", "get_retarget_interval");
+    ADD_PROPERTY(PropertyInfo(Variant::STRING_NAME, "target_group"), "set_target_group", "get_target_group");
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "target_bots"), "set_target_bots", "get_target_bots");
+}
+
+void BotCrowd::_notification(int p_what) {
+    if (Engine::get_singleton()->is_editor_hint()) {
+        return;
+    }
+
+    if (p_what == NOTIFICATION_ENTER_TREE) {
+        add_to_group(GROUP_NAME);
+        entity = Entities::register_node(this, EntityRegistry::KIND_BOT_CROWD);
+        create_bots();
+        monitored_crowds.push_back(this);
+        if (monitored_crowds.size() == 1) {
+            PerfMonitors::add("Bots/Active", callable_mp_static(&BotCrowd::get_total_active_bots));
+            PerfMonitors::add("Bots/Update Time (us)", callable_mp_static(&BotCrowd::get_total_update_usec));
+            PerfMonitors::add("Bots/Shots Per Tick", callable_mp_static(&BotCrowd::get_total_shots));
+            PerfMonitors::add("Bots/Motion Tests Per Tick", callable_mp_static(&BotCrowd::get_total_motion_tests));
+        }
+    } else if (p_what == NOTIFICATION_EXIT_TREE) {
+        monitored_crowds.erase(std::find(monitored_crowds.begin(), monitored_crowds.end(), this));
+        if (monitored_crowds.empty()) {
+            PerfMonitors::remove("Bots/Active");
+            PerfMonitors::remove("Bots/Update Time (us)");
+            PerfMonitors::remove("Bots/Shots Per Tick");
+            PerfMonitors::remove("Bots/Motion Tests Per Tick");
+        }
+        free_bots();
+        Entities::unregister(entity);
+    }
+}
+
+int BotCrowd::get_total_active_bots() {
+    int total = 0;
+    for (const BotCrowd *crowd : monitored_crowds) {
+        total += crowd->get_active_bot_count();
+    }
+    return total;
+}
+
+int BotCrowd::get_total_update_usec() {
+    int total = 0;
+    for (const BotCrowd *crowd : monitored_crowds) {
+        total += crowd->get_update_usec_last_tick();
+    }
+    return total;
+}
+
+int BotCrowd::get_total_shots() {
+    int total = 0;
+    for (const BotCrowd *crowd : monitored_crowds) {
+        total += crowd->get_shots_last_tick();
+    }
+    return total;
+}
+
+int BotCrowd::get_total_motion_tests() {
+    int total = 0;
+    for (const BotCrowd *crowd : monitored_crowds) {
+        total += crowd->get_motion_tests_last_tick();
+    }
+    return total;
+}
+
+float BotCrowd::randf() {
+    // splitmix64, runs are repeatable for a given seed
+    uint64_t z = (rng_state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    return (float)(z >> 40) / (float)(1ull << 24);
+}
+
+void BotCrowd::pick_goal(uint32_t p_bot) {
+    Vector3 center = get_global_position();
+    goal_x[p_bot] = center.x + (randf() * 2.0f - 1.0f) * arena_half_extents.x;
+    goal_z[p_bot] = center.z + (randf() * 2.0f - 1.0f) * arena_half_extents.y;
+    blocked[p_bot] = 0;
+}
+
+Transform3D BotCrowd::get_bot_transform(uint32_t p_bot) const {
+    return Transform3D(Basis(Vector3(0, 1, 0), yaw[p_bot]), Vector3(pos_x[p_bot], pos_y[p_bot], pos_z[p_bot]));
+}
+
+void BotCrowd::create_bots() {
+    free_bots();
+    Ref<World3D> world = get_world_3d();
+    ERR_FAIL_COND_MSG(world.is_null(), "BotCrowd: No 3D world to spawn bots in.");
+
+    PhysicsServer3D *ps = PhysicsServer3D::get_singleton();
+    shape = ps->capsule_shape_create();
+    Dictionary shape_data;
+    shape_data["radius"] = body_radius;
+    shape_data["height"] = body_height;
+    ps->shape_set_data(shape, shape_data);
+
+    rng_state = (uint64_t)(int64_t)seed;
+    Vector3 center = get_global_position();
+    uint32_t count = bot_count;
+
+    body.resize(count);
+    pos_x.resize(count);
+    pos_y.resize(count);
+    pos_z.resize(count);
+    velocity_y.assign(count, 0.0f);
+    yaw.resize(count);
+    goal_x.resize(count);
+    goal_z.resize(count);
+    shot_cooldown.assign(count, 0.0f);
+    retarget_timer.resize(count);
+    target.assign(count, -1);
+    target_is_bot.assign(count, 0);
+    on_floor.assign(count, 0);
+    blocked.assign(count, 0);
+    start_x.resize(count);
+    start_y.resize(count);
+    start_z.resize(count);
+    shots.reserve(count);
+
+    // The capsule's origin is at the feet, like Player's hurtbox
+    Transform3D shape_transform(Basis(), Vector3(0, body_height * 0.5, 0));
+    for (uint32_t i = 0; i < count; i++) {
+        pos_x[i] = center.x + (randf() * 2.0f - 1.0f) * arena_half_extents.x;
+        pos_y[i] = center.y;
+        pos_z[i] = center.z + (randf() * 2.0f - 1.0f) * arena_half_extents.y;
+        yaw[i] = randf() * Math_TAU;
+        retarget_timer[i] = randf() * retarget_interval; // Spread retargeting over the interval
+        pick_goal(i);
+
+        RID rid = ps->body_create();
+        ps->body_set_mode(rid, PhysicsServer3D::BODY_MODE_KINEMATIC);
+        ps->body_add_shape(rid, shape, shape_transform);
+        ps->body_set_collision_layer(rid, collision_layer);
+        ps->body_set_collision_mask(rid, collision_mask);
+        ps->body_attach_object_instance_id(rid, get_instance_id());
+        ps->body_set_space(rid, world->get_space());
+        ps->body_set_state(rid, PhysicsServer3D::BODY_STATE_TRANSFORM, get_bot_transform(i));
+        body[i] = rid;
+    }
+
+    create_visuals();
+}
+
+void BotCrowd::free_bots() {
+    free_visuals();
+
+    PhysicsServer3D *ps = PhysicsServer3D::get_singleton();
+    for (const RID &rid : body) {
+        ps->free_rid(rid);
+    }
+    body.clear();
+    if (shape.is_valid()) {
+        ps->free_rid(shape);
+        shape = RID();
+    }
+}
+
+void BotCrowd::_physics_process(double delta) {
+    TRACE_SCOPE("BotCrowd::physics_process");
+    if (Engine::get_singleton()->is_editor_hint() || body.empty()) {
+        return;
+    }
+    uint64_t start_usec = Time::get_singleton()->get_ticks_usec();
+
+    // Each phase runs over every bot before the next one starts
+    think(delta);
+    move(delta);
+    fire(delta);
+    update_visuals();
+
+    update_usec_last_tick = Time::get_singleton()->get_ticks_usec() - start_usec;
+    TRACE_COUNTER("bot_shots", shots_last_tick);
+}
+
+void BotCrowd::think(double p_delta) {
+    float dt = p_delta;
+    float jump_probability = jump_chance * p_delta;
+
+    for (uint32_t i = 0; i < body.size(); i++) {
+        float dx = goal_x[i] - pos_x[i];
+        float dz = goal_z[i] - pos_z[i];
+        if (blocked[i] || dx * dx + dz * dz < 1.0f) {
+            pick_goal(i);
+        }
+
+        // Gravity keeps pulling so the sweep finds the floor again every tick
+        velocity_y[i] -= gravity * dt;
+        if (on_floor[i] && randf() < jump_probability) {
+            velocity_y[i] = jump_velocity;
+        }
+    }
+}
+
+void BotCrowd::move(double p_delta) {
+    TRACE_SCOPE("BotCrowd::move");
+    PhysicsServer3D *ps = PhysicsServer3D::get_singleton();
+    float dt = p_delta;
+    Vector3 center = get_global_position();
+    motion_tests_last_tick = 0;
+
+    for (uint32_t i = 0; i < body.size(); i++) {
+        start_x[i] = pos_x[i];
+        start_y[i] = pos_y[i];
+        start_z[i] = pos_z[i];
+
+        Vector3 position(pos_x[i], pos_y[i], pos_z[i]);
+        Vector3 heading(goal_x[i] - pos_x[i], 0.0f, goal_z[i] - pos_z[i]);
+        heading = heading.normalized();
+        if (target[i] < 0 && heading != Vector3()) {
+            yaw[i] = std::atan2(-heading.x, -heading.z);
+        }
+
+        Vector3 motion = heading * (speed * dt);
+        motion.y = velocity_y[i] * dt;
+        on_floor[i] = 0;
+
+        // One shape sweep, plus one more to slide along whatever stopped it
+        for (int slide = 0; slide < MAX_SLIDES; slide++) {
+            motion_parameters->set_from(Transform3D(Basis(), position));
+            motion_parameters->set_motion(motion);
+            motion_tests_last_tick++;
+            if (!ps->body_test_motion(body[i], motion_parameters, motion_result)) {
+                position += motion;
+                break;
+            }
+
+            position += motion_result->get_travel();
+            Vector3 normal = motion_result->get_collision_normal();
+            if (normal.y > FLOOR_NORMAL_Y) {
+                on_floor[i] = 1;
+                velocity_y[i] = MAX(velocity_y[i], 0.0f);
+            } else if (normal.y < -FLOOR_NORMAL_Y) {
+                velocity_y[i] = MIN(velocity_y[i], 0.0f);
+            } else {
+                blocked[i] = 1;
+            }
+
+            Vector3 remainder = motion_result->get_remainder();
+            motion = remainder - normal * remainder.dot(normal);
+            if (motion.length_squared() < CMP_EPSILON2) {
+                break;
+            }
+        }
+
+        if (position.y < center.y - FALL_LIMIT) {
+            position = Vector3(goal_x[i], center.y, goal_z[i]);
+            velocity_y[i] = 0.0f;
+        }
+        pos_x[i] = position.x;
+        pos_y[i] = position.y;
+        pos_z[i] = position.z;
+    }
+
+    for (uint32_t i = 0; i < body.size(); i++) {
+        ps->body_set_state(body[i], PhysicsServer3D::BODY_STATE_TRANSFORM, get_bot_transform(i));
+    }
+}
+
+bool BotCrowd::gather_targets() {
+    target_positions.clear();
+    target_ids.clear();
+
+    TypedArray<Node> members = get_tree()->get_nodes_in_group(target_group);
+    for (int i = 0; i < members.size(); i++) {
+        Node3D *node = Object::cast_to<Node3D>(members[i]);
+        if (node) {
+            target_positions.push_back(node->get_global_position() + Vector3(0, body_height * 0.5, 0));
+            target_ids.push_back(node->get_instance_id());
+        }
+    }
+
+    if (target_ids == last_target_ids) {
+        return false;
+    }
+    last_target_ids = target_ids;
+    return true;
+}
+
+void BotCrowd::retarget(uint32_t p_bot) {
+    Vector3 position(pos_x[p_bot], pos_y[p_bot], pos_z[p_bot]);
+    float best = fire_range * fire_range;
+    target[p_bot] = -1;
+    target_is_bot[p_bot] = 0;
+
+    // Real players in range first, the nearest one
+    for (int32_t i = 0; i < (int32_t)target_positions.size(); i++) {
+        float distance = position.distance_squared_to(target_positions[i]);
+        if (distance <= best) {
+            best = distance;
+            target[p_bot] = i;
+        }
+    }
+    if (target[p_bot] >= 0 || !target_bots || body.size() < 2) {
+        return;
+    }
+
+    // Otherwise whichever of a few random bots is in range
+    for (int sample = 0; sample < BOT_TARGET_SAMPLES; sample++) {
+        uint32_t other = MIN((uint32_t)(randf() * body.size()), (uint32_t)body.size() - 1);
+        if (other == p_bot) {
+            continue;
+        }
+        Vector3 other_position(pos_x[other], pos_y[other], pos_z[other]);
+        if (position.distance_squared_to(other_position) <= best) {
+            target[p_bot] = other;
+            target_is_bot[p_bot] = 1;
+            return;
+        }
+    }
+}
+
+void BotCrowd::fire(double p_delta) {
+    TRACE_SCOPE("BotCrowd::fire");
+    // Player targets are indices into the group, which only hold while it stays the same
+    bool group_changed = gather_targets();
+
+    double interval = 60.0 / rounds_per_minute;
+    float eye_height = body_height * 0.9;
+    float spread = std::tan(Math::deg_to_rad(spread_degrees));
+    float fire_range_squared = fire_range * fire_range;
+    shots.clear();
+
+    for (uint32_t i = 0; i < body.size(); i++) {
+        retarget_timer[i] -= p_delta;
+        bool stale = target[i] >= 0 && (target_is_bot[i] ? !target_bots : group_changed);
+        if (retarget_timer[i] <= 0.0f || stale) {
+            retarget(i);
+            retarget_timer[i] += retarget_interval;
+        }
+
+        Vector3 position(pos_x[i], pos_y[i], pos_z[i]);
+        int32_t index = target[i];
+        Vector3 aim_point;
+        if (index >= 0) {
+            aim_point = target_is_bot[i] ? Vector3(pos_x[index], pos_y[index] + body_height * 0.5, pos_z[index]) : target_positions[index];
+        }
+        if (index < 0 || position.distance_squared_to(aim_point) > fire_range_squared) {
+            shot_cooldown[i] = MAX(shot_cooldown[i] - p_delta, 0.0);
+            continue;
+        }
+
+        Vector3 facing = aim_point - position;
+        yaw[i] = std::atan2(-facing.x, -facing.z);
+
+        // Shots are placed within the tick like a Weapon's, fired from where the bot was then
+        Vector3 start(start_x[i], start_y[i], start_z[i]);
+        double next_shot = MAX((double)shot_cooldown[i], 0.0);
+        while (next_shot < p_delta) {
+            Vector3 eye = start.lerp(position, next_shot / p_delta) + Vector3(0, eye_height, 0);
+            Vector3 jitter(randf() * 2.0f - 1.0f, randf() * 2.0f - 1.0f, randf() * 2.0f - 1.0f);
+            Vector3 direction = (aim_point - eye).normalized();
+            direction = (direction + jitter * spread).normalized();
+
+            ScheduledShot shot;
+            shot.origin = eye + direction * (body_radius + MUZZLE_CLEARANCE);
+            shot.direction = direction;
+            shot.delay = next_shot;
+            shots.push_back(shot);
+            next_shot += interval;
+        }
+        shot_cooldown[i] = next_shot - p_delta;
+    }
+    shots_last_tick = shots.size();
+
+    // The whole crowd's burst in one call, before the ProjectileManager's update this tick
+    ProjectileManager *projectile_manager = ProjectileManager::get_singleton();
+    if (projectile_manager && !shots.empty()) {
+        projectile_manager->queue_shots(shots, fire_mode == Weapon::FIRE_MODE_HITSCAN, projectile_speed, damage, range, entity);
+    }
+}
+
+void BotCrowd::add_broadphase_boxes(ProjectileBroadphase &r_broadphase) const {
+    float radius = body_radius;
+    float height = body_height;
+    for (uint32_t i = 0; i < body.size(); i++) {
+        float min[3] = { pos_x[i] - radius, pos_y[i], pos_z[i] - radius };
+        float max[3] = { pos_x[i] + radius, pos_y[i] + height, pos_z[i] + radius };
+        r_broadphase.add_dynamic(min, max);
+    }
+}
+
+PackedVector3Array BotCrowd::get_bot_positions() const {
+    PackedVector3Array positions;
+    positions.resize(body.size());
+    Vector3 *write = positions.ptrw();
+    for (uint32_t i = 0; i < body.size(); i++) {
+        write[i] = Vector3(pos_x[i], pos_y[i], pos_z[i]);
+    }
+    return positions;
+}
+
+void BotCrowd::create_visuals() {
+    if (bot_mesh.is_null() || body.empty()) {
+        return;
+    }
+    Ref<World3D> world = get_world_3d();
+    if (world.is_null()) {
+        return;
+    }
+
+    // Every bot is one instance of a single multimesh
+    RenderingServer *rs = RenderingServer::get_singleton();
+    multimesh = rs->multimesh_create();
+    rs->multimesh_set_mesh(multimesh, bot_mesh->get_rid());
+    rs->multimesh_allocate_data(multimesh, body.size(), RenderingServer::MULTIMESH_TRANSFORM_3D);
+    multimesh_instance = rs->instance_create2(multimesh, world->get_scenario());
+    visual_buffer.resize(body.size() * 12);
+    update_visuals();
+}
+
+void BotCrowd::free_visuals() {
+    RenderingServer *rs = RenderingServer::get_singleton();
+    if (multimesh_instance.is_valid()) {
+        rs->free_rid(multimesh_instance);
+        multimesh_instance = RID();
+    }
+    if (multimesh.is_valid()) {
+        rs->free_rid(multimesh);
+        multimesh = RID();
+    }
+}
+
+void BotCrowd::update_visuals() {
+    if (!multimesh.is_valid()) {
+        return;
+    }
+
+    // Row-major 3x4 transforms, a yaw rotation about the capsule's center
+    float *write = visual_buffer.ptrw();
+    float half_height = body_height * 0.5;
+    for (uint32_t i = 0; i < body.size(); i++) {
+        float s = std::sin(yaw[i]);
+        float c = std::cos(yaw[i]);
+        float *row = write + i * 12;
+        row[0] = c;
+        row[1] = 0.0f;
+        row[2] = s;
+        row[3] = pos_x[i];
+        row[4] = 0.0f;
+        row[5] = 1.0f;
+        row[6] = 0.0f;
+        row[7] = pos_y[i] + half_height;
+        row[8] = -s;
+        row[9] = 0.0f;
+        row[10] = c;
+        row[11] = pos_z[i];
+    }
+    RenderingServer::get_singleton()->multimesh_set_buffer(multimesh, visual_buffer);
+}
+
+void BotCrowd::set_bot_count(int p_count) {
+    bot_count = MAX(p_count, 0);
+    if (is_inside_tree() && !Engine::get_singleton()->is_editor_hint()) {
+        create_bots();
+    }
+}
+
+void BotCrowd::set_body_radius(double p_radius) {
+    body_radius = MAX(p_radius, 0.05);
+    if (is_inside_tree() && !Engine::get_singleton()->is_editor_hint()) {
+        create_bots();
+    }
+}
+
+void BotCrowd::set_body_height(double p_height) {
+    body_height = MAX(p_height, 0.1);
+    if (is_inside_tree() && !Engine::get_singleton()->is_editor_hint()) {
+        create_bots();
+    }
+}
+
+void BotCrowd::set_collision_layer(uint32_t p_layer) {
+    collision_layer = p_layer;
+    for (const RID &rid : body) {
+        PhysicsServer3D::get_singleton()->body_set_collision_layer(rid, collision_layer);
+    }
+}
+
+void BotCrowd::set_collision_mask(uint32_t p_mask) {
+    collision_mask = p_mask;
+    for (const RID &rid : body) {
+        PhysicsServer3D::get_singleton()->body_set_collision_mask(rid, collision_mask);
+    }
+}
+
+void BotCrowd::set_bot_mesh(const Ref<Mesh> &p_mesh) {
+    bot_mesh = p_mesh;
+    free_visuals();
+    if (is_inside_tree() && !Engine::get_singleton()->is_editor_hint()) {
+        create_visuals();
+    }
+}
@@ -0,0 +1,199 @@
+#ifndef BOT_CROWD_H
+#define BOT_CROWD_H
+
+#include <godot_cpp/classes/mesh.hpp>
+#include <godot_cpp/classes/node3d.hpp>
+#include <godot_cpp/classes/physics_test_motion_parameters3d.hpp>
+#include <godot_cpp/classes/physics_test_motion_result3d.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#include "../weapons/projectile_manager.hpp"
+#include "../weapons/weapon_manager.hpp"
+
+#include <vector>
+
+namespace godot {
+
+class ProjectileBroadphase;
+
+// Many simulated opponents updated in one batch, for load tests.
+//
+// Bots are not nodes. Each one is a kinematic capsule created directly on the
+// PhysicsServer3D, moved with body_test_motion shape sweeps, so projectiles
+// and other raycasts hit them like any body. Movement uses the same speed,
+// gravity and jump parameters as Player. Bots wander the arena around this
+// node, and fire at the nearest member of target_group in range, or at
+// another bot, by queueing their shots for the tick with the
+// ProjectileManager in one call.
+//
+// Hits on bots report this node as the collider. Bots have no Health, so
+// damage against them is dropped by the DamageSystem.
+class BotCrowd : public Node3D {
+    GDCLASS(BotCrowd, Node3D)
+
+private:
+    // Per-bot state, one entry per bot in every array
+    std::vector<RID> body;
+    std::vector<float> pos_x;
+    std::vector<float> pos_y;
+    std::vector<float> pos_z;
+    std::vector<float> velocity_y;
+    std::vector<float> yaw;
+    std::vector<float> goal_x;
+    std::vector<float> goal_z;
+    std::vector<float> shot_cooldown;
+    std::vector<float> retarget_timer;
+    std::vector<int32_t> target; // A bot, or a target_group member of the tick; -1 for none
+    std::vector<uint8_t> target_is_bot;
+    std::vector<uint8_t> on_floor;
+    std::vector<uint8_t> blocked; // Hit a wall, a new goal is picked
+
+    // Tick scratch
+    std::vector<float> start_x;
+    std::vector<float> start_y;
+    std::vector<float> start_z;
+    std::vector<Vector3> target_positions; // target_group members
+    std::vector<uint64_t> target_ids; // Their instance ids
+    std::vector<uint64_t> last_target_ids; // As of the previous tick
+    std::vector<ScheduledShot> shots;
+
+    RID shape;
+    Ref<PhysicsTestMotionParameters3D> motion_parameters;
+    Ref<PhysicsTestMotionResult3D> motion_result;
+    uint64_t rng_state = 0;
+    uint32_t entity = 0; // EntityRegistry handle, the shooter of every bot's shots
+
+    // Movement, mirroring Player
+    int bot_count = 256;
+    double speed = 5.0;
+    double gravity = 9.82;
+    double jump_velocity = 4.5;
+    double jump_chance = 0.05; // Per second while on the floor
+    Vector2 arena_half_extents = Vector2(40.0, 40.0);
+    int seed = 0;
+
+    // Body
+    double body_radius = 0.4;
+    double body_height = 1.8;
+    uint32_t collision_layer = 1u << 1;
+    uint32_t collision_mask = 1u; // Only the level, bots walk through each other
+
+    // Firing
+    Weapon::FireMode fire_mode = Weapon::FIRE_MODE_PROJECTILE;
+    double damage = 10.0;
+    double range = 200.0;
+    double projectile_speed = 150.0;
+    double rounds_per_minute = 120.0;
+    double spread_degrees = 2.0;
+    double fire_range = 40.0;
+    double retarget_interval = 1.0;
+    StringName target_group = "players";
+    bool target_bots = true;
+
+    // Visuals
+    Ref<Mesh> bot_mesh; // Centered on the collision capsule
+    RID multimesh;
+    RID multimesh_instance;
+    PackedFloat32Array visual_buffer;
+
+    // Sampled by the Performance monitors
+    uint64_t update_usec_last_tick = 0;
+    uint32_t shots_last_tick = 0;
+    uint32_t motion_tests_last_tick = 0;
+
+    // Crowds in the tree; the monitors sum over them and live while any is
+    static std::vector<BotCrowd *> monitored_crowds;
+    static int get_total_active_bots();
+    static int get_total_update_usec();
+    static int get_total_shots();
+    static int get_total_motion_tests();
+
+    float randf();
+    void pick_goal(uint32_t p_bot);
+    void create_bots();
+    void free_bots();
+    void create_visuals();
+    void free_visuals();
+    void update_visuals();
+
+    // Returns whether the group differs from the previous tick's
+    bool gather_targets();
+    void think(double p_delta);
+    void move(double p_delta);
+    void fire(double p_delta);
+    void retarget(uint32_t p_bot);
+    Transform3D get_bot_transform(uint32_t p_bot) const;
+
+public:
+    // Crowds whose bots feed the projectile broadphase
+    static constexpr const char *GROUP_NAME = "bot_crowds";
+
+    BotCrowd();
+    ~BotCrowd();
+
+    static void _bind_methods();
+
+    void _notification(int p_what);
+    void _physics_process(double delta) override;
+
+    // Adds the bounds of every bot as a moving target
+    void add_broadphase_boxes(ProjectileBroadphase &r_broadphase) const;
+
+    int get_active_bot_count() const { return body.size(); }
+    PackedVector3Array get_bot_positions() const;
+    int get_update_usec_last_tick() const { return update_usec_last_tick; }
+    int get_shots_last_tick() const { return shots_last_tick; }
+    int get_motion_tests_last_tick() const { return motion_tests_last_tick; }
+
+    // Property getters and setters
+    int get_bot_count() const { return bot_count; }
+    void set_bot_count(int p_count);
+    double get_speed() const { return speed; }
+    void set_speed(double p_speed) { speed = p_speed; }
+    double get_gravity() const { return gravity; }
+    void set_gravity(double p_gravity) { gravity = p_gravity; }
+    double get_jump_velocity() const { return jump_velocity; }
+    void set_jump_velocity(double p_jump_velocity) { jump_velocity = p_jump_velocity; }
+    double get_jump_chance() const { return jump_chance; }
+    void set_jump_chance(double p_chance) { jump_chance = MAX(p_chance, 0.0); }
+    Vector2 get_arena_half_extents() const { return arena_half_extents; }
+    void set_arena_half_extents(const Vector2 &p_extents) { arena_half_extents = p_extents.abs(); }
+    int get_seed() const { return seed; }
+    void set_seed(int p_seed) { seed = p_seed; }
+
+    double get_body_radius() const { return body_radius; }
+    void set_body_radius(double p_radius);
+    double get_body_height() const { return body_height; }
+    void set_body_height(double p_height);
+    uint32_t get_collision_layer() const { return collision_layer; }
+    void set_collision_layer(uint32_t p_layer);
+    uint32_t get_collision_mask() const { return collision_mask; }
+    void set_collision_mask(uint32_t p_mask);
+
+    Weapon::FireMode get_fire_mode() const { return fire_mode; }
+    void set_fire_mode(Weapon::FireMode p_mode) { fire_mode = p_mode; }
+    double get_damage() const { return damage; }
+    void set_damage(double p_damage) { damage = p_damage; }
+    double get_range() const { return range; }
+    void set_range(double p_range) { range = p_range; }
+    double get_projectile_speed() const { return projectile_speed; }
+    void set_projectile_speed(double p_speed) { projectile_speed = p_speed; }
+    double get_rounds_per_minute() const { return rounds_per_minute; }
+    void set_rounds_per_minute(double p_rpm) { rounds_per_minute = MAX(p_rpm, 1.0); }
+    double get_spread_degrees() const { return spread_degrees; }
+    void set_spread_degrees(double p_degrees) { spread_degrees = MAX(p_degrees, 0.0); }
+    double get_fire_range() const { return fire_range; }
+    void set_fire_range(double p_range) { fire_range = MAX(p_range, 0.0); }
+    double get_retarget_interval() const { return retarget_interval; }
+    void set_retarget_interval(double p_interval) { retarget_interval = MAX(p_interval, 0.05); }
+    StringName get_target_group() const { return target_group; }
+    void set_target_group(const StringName &p_group) { target_group = p_group; }
+    bool get_target_bots() const { return target_bots; }
+    void set_target_bots(bool p_enable) { target_bots = p_enable; }
+
+    Ref<Mesh> get_bot_mesh() const { return bot_mesh; }
+    void set_bot_mesh(const Ref<Mesh> &p_mesh);
+};
+
+}
+
+#endif // BOT_CROWD_H
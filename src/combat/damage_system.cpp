@@ -0,0 +1,341 @@
+#include "damage_system.hpp"
+#include "health.hpp"
+#include "lag_compensation.hpp"
+#include "../debug/perf_monitors.hpp"
+#include "../weapons/projectile_collision.hpp"
+#include <godot_cpp/classes/node3d.hpp>
+#include <godot_cpp/classes/scene_tree.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/core/object.hpp>
+#include <godot_cpp/variant/callable_method_pointer.hpp>
+#include <godot_cpp/variant/typed_array.hpp>
+
+using namespace godot;
+
+DamageSystem* DamageSystem::singleton = nullptr;
+
+// Runs after gameplay and projectile nodes so every hit of the tick is queued
+static const int DAMAGE_FLUSH_PRIORITY = 1000;
+
+DamageSystem::DamageSystem() {
+    singleton = this;
+}
+
+DamageSystem::~DamageSystem() {
+    if (singleton == this) {
+        singleton = nullptr;
+    }
+}
+
+void DamageSystem::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("flush"), &DamageSystem::flush);
+    ClassDB::bind_method(D_METHOD("get_entity_count"), &DamageSystem::get_entity_count);
+    ClassDB::bind_method(D_METHOD("get_events_last_flush"), &DamageSystem::get_events_last_flush);
+    ClassDB::bind_method(D_METHOD("get_deaths_last_flush"), &DamageSystem::get_deaths_last_flush);
+    ClassDB::bind_method(D_METHOD("get_hurtbox_reinserts_last_refit"), &DamageSystem::get_hurtbox_reinserts_last_refit);
+    ClassDB::bind_method(D_METHOD("refit_hurtboxes"), &DamageSystem::refit_hurtboxes);
+}
+
+void DamageSystem::_notification(int p_what) {
+    if (p_what == NOTIFICATION_ENTER_TREE) {
+        PerfMonitors::add("Combat/Entities", callable_mp(this, &DamageSystem::get_entity_count));
+        PerfMonitors::add("Combat/Damage Events Per Tick", callable_mp(this, &DamageSystem::get_events_last_flush));
+        PerfMonitors::add("Combat/Deaths Per Tick", callable_mp(this, &DamageSystem::get_deaths_last_flush));
+        PerfMonitors::add("Combat/Hurtbox Reinserts Per Tick", callable_mp(this, &DamageSystem::get_hurtbox_reinserts_last_refit));
+    } else if (p_what == NOTIFICATION_EXIT_TREE) {
+        PerfMonitors::remove("Combat/Entities");
+        PerfMonitors::remove("Combat/Damage Events Per Tick");
+        PerfMonitors::remove("Combat/Deaths Per Tick");
+        PerfMonitors::remove("Combat/Hurtbox Reinserts Per Tick");
+    }
+}
+
+void DamageSystem::_ready() {
+    set_physics_process_priority(DAMAGE_FLUSH_PRIORITY);
+
+    // Health nodes that entered the tree before us could not register yet
+    TypedArray<Node> components = get_tree()->get_nodes_in_group(Health::GROUP_NAME);
+    for (int i = 0; i < components.size(); i++) {
+        Health *component = Object::cast_to<Health>(components[i]);
+        if (component) {
+            component->register_with_system();
+        }
+    }
+}
+
+void DamageSystem::_physics_process(double delta) {
+    flush();
+}
+
+uint32_t DamageSystem::register_entity(Health *p_health, Node *p_body, float p_max_health, float p_armor) {
+    uint32_t handle = p_health->get_handle();
+    if (!EntityRegistry::get_singleton().is_valid(handle) || get_dense(handle) != INVALID_DENSE) {
+        return INVALID_HANDLE;
+    }
+
+    uint32_t index = EntityRegistry::get_index(handle);
+    if (index >= dense_of.size()) {
+        dense_of.resize(index + 1, INVALID_DENSE);
+    }
+    uint32_t dense = handle_of.size();
+    dense_of[index] = dense;
+
+    health.push_back(p_max_health);
+    max_health.push_back(p_max_health);
+    armor.push_back(p_armor);
+    alive.push_back(1);
+    owner_id.push_back(p_health->get_instance_id());
+    body_id.push_back(p_body ? ObjectID(p_body->get_instance_id()) : ObjectID());
+    handle_of.push_back(handle);
+    pending_damage.push_back(0.0f);
+    last_source.push_back(INVALID_HANDLE);
+    touched.push_back(0);
+
+    uint32_t proxy = HurtboxTree::NULL_NODE;
+    Node3D *body_3d = Object::cast_to<Node3D>(p_body);
+    if (body_3d) {
+        AABB hurtbox = LagCompensation::get_body_hurtbox(body_3d);
+        Vector3 center = hurtbox.get_center();
+        Vector3 half_extents = hurtbox.size * 0.5;
+
+        HitboxHistory::Pose pose;
+        for (int i = 0; i < 3; i++) {
+            pose.center[i] = center[i];
+            pose.half_extents[i] = half_extents[i];
+        }
+        pose.key = body_3d->get_instance_id();
+        if (body_3d->is_inside_tree()) {
+            set_pose_transform(body_3d, pose);
+        }
+        proxy = hurtboxes.create_proxy(pose);
+    }
+    hurtbox_proxy.push_back(proxy);
+
+    if (p_body) {
+        handle_by_body[p_body->get_instance_id()] = handle;
+    }
+
+    return handle;
+}
+
+void DamageSystem::unregister_entity(uint32_t p_handle) {
+    uint32_t dense = get_dense(p_handle);
+    if (dense == INVALID_DENSE) {
+        return;
+    }
+
+    if (!body_id[dense].is_null()) {
+        auto it = handle_by_body.find((uint64_t)body_id[dense]);
+        if (it != handle_by_body.end() && it->second == p_handle) {
+            handle_by_body.erase(it);
+        }
+    }
+    if (hurtbox_proxy[dense] != HurtboxTree::NULL_NODE) {
+        hurtboxes.destroy_proxy(hurtbox_proxy[dense]);
+    }
+
+    // Swap the last entity into the hole to keep the arrays dense
+    uint32_t last = handle_of.size() - 1;
+    if (dense != last) {
+        health[dense] = health[last];
+        max_health[dense] = max_health[last];
+        armor[dense] = armor[last];
+        alive[dense] = alive[last];
+        owner_id[dense] = owner_id[last];
+        body_id[dense] = body_id[last];
+        handle_of[dense] = handle_of[last];
+        pending_damage[dense] = pending_damage[last];
+        last_source[dense] = last_source[last];
+        touched[dense] = touched[last];
+        hurtbox_proxy[dense] = hurtbox_proxy[last];
+        dense_of[EntityRegistry::get_index(handle_of[dense])] = dense;
+    }
+
+    health.pop_back();
+    max_health.pop_back();
+    armor.pop_back();
+    alive.pop_back();
+    owner_id.pop_back();
+    body_id.pop_back();
+    handle_of.pop_back();
+    pending_damage.pop_back();
+    last_source.pop_back();
+    touched.pop_back();
+    hurtbox_proxy.pop_back();
+
+    dense_of[EntityRegistry::get_index(p_handle)] = INVALID_DENSE;
+}
+
+void DamageSystem::set_entity_max_health(uint32_t p_handle, float p_max_health) {
+    uint32_t dense = get_dense(p_handle);
+    if (dense == INVALID_DENSE) {
+        return;
+    }
+    max_health[dense] = p_max_health;
+    health[dense] = MIN(health[dense], p_max_health);
+}
+
+void DamageSystem::set_entity_armor(uint32_t p_handle, float p_armor) {
+    uint32_t dense = get_dense(p_handle);
+    if (dense != INVALID_DENSE) {
+        armor[dense] = p_armor;
+    }
+}
+
+uint32_t DamageSystem::get_handle_for_body(ObjectID p_body_id) const {
+    auto it = handle_by_body.find((uint64_t)p_body_id);
+    return it != handle_by_body.end() ? it->second : INVALID_HANDLE;
+}
+
+bool DamageSystem::has_hurtbox(ObjectID p_body_id) const {
+    uint32_t dense = get_dense(get_handle_for_body(p_body_id));
+    return dense != INVALID_DENSE && hurtbox_proxy[dense] != HurtboxTree::NULL_NODE;
+}
+
+// Scale is not part of the pose, hurtboxes are authored in world units
+void DamageSystem::set_pose_transform(const Node3D *p_body, HitboxHistory::Pose &r_pose) {
+    Transform3D transform = p_body->get_global_transform();
+    Quaternion rotation = transform.basis.get_rotation_quaternion();
+    r_pose.position[0] = transform.origin.x;
+    r_pose.position[1] = transform.origin.y;
+    r_pose.position[2] = transform.origin.z;
+    r_pose.rotation[0] = rotation.x;
+    r_pose.rotation[1] = rotation.y;
+    r_pose.rotation[2] = rotation.z;
+    r_pose.rotation[3] = rotation.w;
+}
+
+void DamageSystem::refit_hurtboxes() {
+    for (uint32_t dense = 0; dense < hurtbox_proxy.size(); dense++) {
+        uint32_t proxy = hurtbox_proxy[dense];
+        if (proxy == HurtboxTree::NULL_NODE) {
+            continue;
+        }
+        Node3D *body = Object::cast_to<Node3D>(ObjectDB::get_instance(body_id[dense]));
+        if (!body || !body->is_inside_tree()) {
+            continue;
+        }
+
+        // Only bodies that left their fat box change the tree
+        HitboxHistory::Pose pose = hurtboxes.get_pose(proxy);
+        set_pose_transform(body, pose);
+        hurtboxes.move_proxy(proxy, pose);
+    }
+    hurtbox_reinserts_last_refit = hurtboxes.take_reinsert_count();
+}
+
+void DamageSystem::queue_damage(uint32_t p_handle, float p_amount, uint32_t p_source) {
+    if (p_handle == INVALID_HANDLE || p_amount <= 0.0f) {
+        return;
+    }
+    events.push_back({ p_handle, p_amount, p_source });
+}
+
+bool DamageSystem::queue_damage_to_body(ObjectID p_body_id, float p_amount, uint32_t p_source) {
+    uint32_t handle = get_handle_for_body(p_body_id);
+    if (handle == INVALID_HANDLE) {
+        return false;
+    }
+    queue_damage(handle, p_amount, p_source);
+    return true;
+}
+
+void DamageSystem::queue_hits(const FrameVector<ProjectileHit> &p_hits) {
+    events.reserve(events.size() + p_hits.size());
+    for (const ProjectileHit &hit : p_hits) {
+        queue_damage_to_body(hit.collider_id, hit.damage, hit.shooter);
+    }
+}
+
+void DamageSystem::flush() {
+    events_last_flush = events.size();
+    deaths_last_flush = 0;
+    if (events.empty()) {
+        return;
+    }
+
+    // Scratch of this flush only. It is rewound at the end so flushes work
+    // without a ProjectileManager resetting the arena; signal handlers must
+    // not keep frame memory.
+    FrameArena &arena = FrameArena::get_thread_arena();
+    FrameArena::Mark mark = arena.get_mark();
+    FrameVector<uint32_t> touched_list;
+    touched_list.reserve(events.size());
+
+    // Fold every event into one pending total per entity
+    for (const DamageEvent &event : events) {
+        uint32_t dense = get_dense(event.handle);
+        if (dense == INVALID_DENSE || !alive[dense]) {
+            continue;
+        }
+        if (!touched[dense]) {
+            touched[dense] = 1;
+            pending_damage[dense] = 0.0f;
+            touched_list.push_back(dense);
+        }
+        pending_damage[dense] += event.amount * (1.0f - armor[dense]);
+        last_source[dense] = event.source;
+    }
+    events.clear();
+
+    // Apply the totals, then notify once all state is consistent. Sources are
+    // resolved here, once per damaged entity; a dead shooter resolves to null.
+    const EntityRegistry &registry = EntityRegistry::get_singleton();
+    FrameVector<Notification> notifications;
+    notifications.reserve(touched_list.size());
+    for (uint32_t dense : touched_list) {
+        touched[dense] = 0;
+        health[dense] = MAX(health[dense] - pending_damage[dense], 0.0f);
+
+        bool died = health[dense] <= 0.0f;
+        if (died) {
+            alive[dense] = 0;
+            deaths_last_flush++;
+        }
+        notifications.push_back({ owner_id[dense], ObjectID(registry.get_object(last_source[dense])), pending_damage[dense], health[dense], died });
+    }
+
+    // Handlers may free or unregister entities, so only ObjectIDs are kept
+    for (const Notification &notification : notifications) {
+        Object *owner = ObjectDB::get_instance(notification.owner);
+        if (!owner) {
+            continue;
+        }
+        Object *source = ObjectDB::get_instance(notification.source);
+        owner->emit_signal("damaged", notification.amount, notification.health, source);
+        if (notification.died) {
+            owner->emit_signal("died");
+        }
+    }
+
+    frame_release(touched_list);
+    frame_release(notifications);
+    arena.rewind(mark);
+}
+
+float DamageSystem::get_health(uint32_t p_handle) const {
+    uint32_t dense = get_dense(p_handle);
+    return dense != INVALID_DENSE ? health[dense] : 0.0f;
+}
+
+bool DamageSystem::is_alive(uint32_t p_handle) const {
+    uint32_t dense = get_dense(p_handle);
+    return dense != INVALID_DENSE && alive[dense];
+}
+
+void DamageSystem::heal(uint32_t p_handle, float p_amount) {
+    uint32_t dense = get_dense(p_handle);
+    if (dense == INVALID_DENSE || !alive[dense]) {
+        return;
+    }
+    health[dense] = MIN(health[dense] + p_amount, max_health[dense]);
+}
+
+void DamageSystem::revive(uint32_t p_handle) {
+    uint32_t dense = get_dense(p_handle);
+    if (dense == INVALID_DENSE) {
+        return;
+    }
+    health[dense] = max_health[dense];
+    alive[dense] = 1;
+}
@@ -0,0 +1,137 @@
+#ifndef DAMAGE_SYSTEM_H
+#define DAMAGE_SYSTEM_H
+
+#include <godot_cpp/classes/node.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/core/object_id.hpp>
+#include "entity_registry.hpp"
+#include "hurtbox_tree.hpp"
+#include "../memory/frame_arena.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace godot {
+
+class Health;
+class Node3D;
+struct ProjectileHit;
+
+// Central store for every Health component.
+//
+// Health, armor and alive flags live in dense arrays addressed through the
+// EntityRegistry handle of each Health, so a stale handle simply misses.
+// Damage is queued as events during the tick and applied in a single batch
+// from _physics_process, which runs after gameplay nodes thanks to a high
+// process priority. Each entity then gets at most one `damaged` and one
+// `died` signal per tick, no matter how many hits it took.
+//
+// Entities whose body is a Node3D also get a hurtbox in a HurtboxTree, from
+// the body's get_hurtbox() or a standing humanoid. The ProjectileManager
+// refits it once per tick and sweeps projectiles against it, so damage
+// queries never touch level geometry.
+class DamageSystem : public Node {
+    GDCLASS(DamageSystem, Node)
+
+public:
+    static constexpr uint32_t INVALID_HANDLE = EntityRegistry::INVALID_HANDLE;
+
+    struct DamageEvent {
+        uint32_t handle;
+        float amount;
+        uint32_t source; // EntityRegistry handle of whoever dealt it
+    };
+
+private:
+    static DamageSystem* singleton;
+
+    // Dense per-entity data
+    std::vector<float> health;
+    std::vector<float> max_health;
+    std::vector<float> armor; // Fraction of incoming damage absorbed, 0..1
+    std::vector<uint8_t> alive;
+    std::vector<ObjectID> owner_id; // Health node
+    std::vector<ObjectID> body_id; // Collider the Health is attached to
+    std::vector<uint32_t> handle_of;
+    std::vector<uint32_t> hurtbox_proxy; // HurtboxTree::NULL_NODE without a Node3D body
+
+    // Handle index -> dense index
+    static constexpr uint32_t INVALID_DENSE = 0xFFFFFFFFu;
+    std::vector<uint32_t> dense_of;
+    std::unordered_map<uint64_t, uint32_t> handle_by_body;
+
+    HurtboxTree hurtboxes;
+
+    // Per-tick batch state. Scripts may queue damage between ticks, so the
+    // events outlive the frame arena; the rest of a flush lives in it.
+    std::vector<DamageEvent> events;
+    std::vector<float> pending_damage;
+    std::vector<uint32_t> last_source;
+    std::vector<uint8_t> touched;
+
+    struct Notification {
+        ObjectID owner;
+        ObjectID source;
+        float amount;
+        float health;
+        bool died;
+    };
+
+    // Sampled by the Performance monitors
+    uint32_t events_last_flush = 0;
+    uint32_t deaths_last_flush = 0;
+    uint32_t hurtbox_reinserts_last_refit = 0;
+
+    uint32_t get_dense(uint32_t p_handle) const {
+        uint32_t index = EntityRegistry::get_index(p_handle);
+        uint32_t dense = index < dense_of.size() ? dense_of[index] : INVALID_DENSE;
+        return dense != INVALID_DENSE && handle_of[dense] == p_handle ? dense : INVALID_DENSE;
+    }
+    static void set_pose_transform(const Node3D *p_body, HitboxHistory::Pose &r_pose);
+
+public:
+    DamageSystem();
+    ~DamageSystem();
+
+    static void _bind_methods();
+    static DamageSystem* get_singleton() { return singleton; }
+
+    void _notification(int p_what);
+    void _ready() override;
+    void _physics_process(double delta) override;
+
+    // Registration, called by Health as it enters and leaves the tree. The
+    // handle is the Health's own entity handle.
+    uint32_t register_entity(Health *p_health, Node *p_body, float p_max_health, float p_armor);
+    void unregister_entity(uint32_t p_handle);
+    void set_entity_max_health(uint32_t p_handle, float p_max_health);
+    void set_entity_armor(uint32_t p_handle, float p_armor);
+
+    uint32_t get_handle_for_body(ObjectID p_body_id) const;
+    int get_entity_count() const { return handle_of.size(); }
+    int get_events_last_flush() const { return events_last_flush; }
+    int get_deaths_last_flush() const { return deaths_last_flush; }
+    int get_hurtbox_reinserts_last_refit() const { return hurtbox_reinserts_last_refit; }
+
+    // Moves every hurtbox to its body's current transform
+    void refit_hurtboxes();
+    const HurtboxTree &get_hurtbox_tree() const { return hurtboxes; }
+    bool has_hurtbox(ObjectID p_body_id) const;
+
+    // Queued damage, applied at the next flush
+    void queue_damage(uint32_t p_handle, float p_amount, uint32_t p_source);
+    bool queue_damage_to_body(ObjectID p_body_id, float p_amount, uint32_t p_source);
+    void queue_hits(const FrameVector<ProjectileHit> &p_hits);
+    void flush();
+
+    // Immediate state access
+    float get_health(uint32_t p_handle) const;
+    bool is_alive(uint32_t p_handle) const;
+    void heal(uint32_t p_handle, float p_amount);
+    void revive(uint32_t p_handle);
+};
+
+}
+
+#endif // DAMAGE_SYSTEM_H
@@ -0,0 +1,79 @@
+#include "entities.hpp"
+#include <godot_cpp/classes/collision_object3d.hpp>
+#include <godot_cpp/classes/node.hpp>
+#include <godot_cpp/classes/os.hpp>
+#include <godot_cpp/core/object.hpp>
+#include <godot_cpp/variant/callable_method_pointer.hpp>
+
+namespace godot {
+
+namespace Entities {
+
+static void release(uint32_t p_handle) {
+    EntityRegistry::get_singleton().destroy(p_handle);
+}
+
+uint32_t register_node(Node *p_node, EntityRegistry::Kind p_kind, uint32_t p_owner) {
+    if (!p_node) {
+        return EntityRegistry::INVALID_HANDLE;
+    }
+
+    // Weapons and health components are excluded and hit through their carrier
+    uint64_t body_id = 0;
+    for (Node *node = p_node; node; node = node->get_parent()) {
+        if (Object::cast_to<CollisionObject3D>(node)) {
+            body_id = node->get_instance_id();
+            break;
+        }
+    }
+
+    uint32_t handle = EntityRegistry::get_singleton().create(p_kind, p_node->get_instance_id(), body_id, p_owner);
+    ERR_FAIL_COND_V_MSG(handle == EntityRegistry::INVALID_HANDLE, handle, "Entities: Too many live entities.");
+    return handle;
+}
+
+void unregister(uint32_t &r_handle) {
+    release(r_handle);
+    r_handle = EntityRegistry::INVALID_HANDLE;
+}
+
+uint32_t find_ancestor(Node *p_node, EntityRegistry::Kind p_kind) {
+    const EntityRegistry &registry = EntityRegistry::get_singleton();
+    for (Node *node = p_node ? p_node->get_parent() : nullptr; node; node = node->get_parent()) {
+        uint32_t handle = registry.find(node->get_instance_id());
+        if (registry.get_kind(handle) == p_kind) {
+            return handle;
+        }
+    }
+    return EntityRegistry::INVALID_HANDLE;
+}
+
+uint32_t find_or_register(Node *p_node) {
+    if (!p_node) {
+        return EntityRegistry::INVALID_HANDLE;
+    }
+    uint32_t handle = EntityRegistry::get_singleton().find(p_node->get_instance_id());
+    if (handle != EntityRegistry::INVALID_HANDLE) {
+        return handle;
+    }
+
+    // Connecting is not thread-safe, and a node outside the tree would never release its slot
+    OS *os = OS::get_singleton();
+    if (!p_node->is_inside_tree() || os->get_thread_caller_id() != os->get_main_thread_id()) {
+        return EntityRegistry::INVALID_HANDLE;
+    }
+    handle = register_node(p_node, EntityRegistry::KIND_OTHER);
+    if (handle != EntityRegistry::INVALID_HANDLE) {
+        p_node->connect("tree_exiting", callable_mp_static(&release).bind(handle), Object::CONNECT_ONE_SHOT);
+    }
+    return handle;
+}
+
+Object *get_object(uint32_t p_handle) {
+    uint64_t object_id = EntityRegistry::get_singleton().get_object(p_handle);
+    return object_id != 0 ? ObjectDB::get_instance(ObjectID(object_id)) : nullptr;
+}
+
+} // namespace Entities
+
+}
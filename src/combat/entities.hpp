@@ -0,0 +1,36 @@
+#ifndef ENTITIES_H
+#define ENTITIES_H
+
+#include "entity_registry.hpp"
+
+namespace godot {
+
+class Node;
+class Object;
+
+// Node-facing side of the EntityRegistry. Combat nodes register themselves as
+// they enter the tree and destroy their handle as they leave it; nodes given
+// to the scripting API are looked up, and registered on first use.
+namespace Entities {
+
+// The body of the entity is the nearest CollisionObject3D at or above p_node
+uint32_t register_node(Node *p_node, EntityRegistry::Kind p_kind, uint32_t p_owner = EntityRegistry::INVALID_HANDLE);
+// Destroys r_handle and resets it to INVALID_HANDLE
+void unregister(uint32_t &r_handle);
+
+// Handle of the nearest registered ancestor of p_node that is of p_kind
+uint32_t find_ancestor(Node *p_node, EntityRegistry::Kind p_kind);
+
+// Handle of p_node for the scripting API. On the main thread, unregistered
+// nodes in the tree get a KIND_OTHER entity until they leave it; elsewhere
+// they resolve to INVALID_HANDLE.
+uint32_t find_or_register(Node *p_node);
+
+// The registered object, null when the handle is stale or it was freed
+Object *get_object(uint32_t p_handle);
+
+} // namespace Entities
+
+}
+
+#endif // ENTITIES_H
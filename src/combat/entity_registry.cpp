@@ -0,0 +1,95 @@
+#include "entity_registry.hpp"
+
+using namespace godot;
+
+EntityRegistry &EntityRegistry::get_singleton() {
+    static EntityRegistry registry;
+    return registry;
+}
+
+uint32_t EntityRegistry::create(Kind p_kind, uint64_t p_object_id, uint64_t p_body_id, uint32_t p_owner) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    uint32_t index;
+    if (!free_indices.empty()) {
+        index = free_indices.back();
+        free_indices.pop_back();
+    } else {
+        if (kind.size() >= MAX_ENTITIES) {
+            return INVALID_HANDLE;
+        }
+        index = kind.size();
+        generation.push_back(1);
+        kind.push_back(KIND_NONE);
+        object_id.push_back(0);
+        body_id.push_back(0);
+        owner.push_back(INVALID_HANDLE);
+    }
+
+    kind[index] = p_kind;
+    object_id[index] = p_object_id;
+    body_id[index] = p_body_id;
+    owner[index] = p_owner;
+    count++;
+
+    uint32_t handle = ((uint32_t)generation[index] << INDEX_BITS) | index;
+    if (p_object_id != 0) {
+        handle_by_object[p_object_id] = handle;
+    }
+    return handle;
+}
+
+void EntityRegistry::destroy(uint32_t p_handle) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!is_valid(p_handle)) {
+        return;
+    }
+
+    uint32_t index = get_index(p_handle);
+    auto it = handle_by_object.find(object_id[index]);
+    if (it != handle_by_object.end() && it->second == p_handle) {
+        handle_by_object.erase(it);
+    }
+
+    // Generation 0 is skipped on wrap so INVALID_HANDLE never validates
+    uint32_t next = (generation[index] + 1) & GENERATION_MASK;
+    generation[index] = next == 0 ? 1 : next;
+    kind[index] = KIND_NONE;
+    object_id[index] = 0;
+    body_id[index] = 0;
+    owner[index] = INVALID_HANDLE;
+    free_indices.push_back(index);
+    count--;
+}
+
+uint32_t EntityRegistry::find(uint64_t p_object_id) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = handle_by_object.find(p_object_id);
+    return it != handle_by_object.end() ? it->second : INVALID_HANDLE;
+}
+
+uint32_t EntityRegistry::find_owner_of_kind(uint32_t p_handle, Kind p_kind) const {
+    // Ownership is shallow, the bound only guards against cycles
+    for (int depth = 0; depth < 8 && is_valid(p_handle); depth++) {
+        if (kind[get_index(p_handle)] == p_kind) {
+            return p_handle;
+        }
+        p_handle = owner[get_index(p_handle)];
+    }
+    return INVALID_HANDLE;
+}
+
+uint32_t EntityRegistry::invalidate_stale(uint32_t *p_handles, uint32_t p_count) const {
+    uint32_t slots = kind.size();
+    uint32_t replaced = 0;
+    for (uint32_t i = 0; i < p_count; i++) {
+        uint32_t handle = p_handles[i];
+        uint32_t index = get_index(handle);
+        bool valid = index < slots && kind[index] != KIND_NONE && generation[index] == get_generation(handle);
+        if (!valid && handle != INVALID_HANDLE) {
+            p_handles[i] = INVALID_HANDLE;
+            replaced++;
+        }
+    }
+    return replaced;
+}
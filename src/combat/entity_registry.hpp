@@ -0,0 +1,78 @@
+#ifndef ENTITY_REGISTRY_H
+#define ENTITY_REGISTRY_H
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace godot {
+
+// Generational handles for players, weapons, health components and bot
+// crowds; a stale handle stops validating instead of dangling. create(),
+// destroy() and find() lock, the per-slot reads belong to the simulation thread.
+class EntityRegistry {
+public:
+    enum Kind : uint8_t {
+        KIND_NONE, // Free slot
+        KIND_PLAYER,
+        KIND_WEAPON,
+        KIND_HEALTH,
+        KIND_BOT_CROWD,
+        KIND_OTHER, // Any other node that fired or dealt damage
+    };
+
+    static constexpr uint32_t INVALID_HANDLE = 0;
+    static constexpr uint32_t INDEX_BITS = 20;
+    static constexpr uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+    static constexpr uint32_t GENERATION_MASK = 0xFFFFFFFFu >> INDEX_BITS;
+    static constexpr uint32_t MAX_ENTITIES = INDEX_MASK + 1;
+
+    static uint32_t get_index(uint32_t p_handle) { return p_handle & INDEX_MASK; }
+    static uint32_t get_generation(uint32_t p_handle) { return p_handle >> INDEX_BITS; }
+
+private:
+    // Per slot
+    std::vector<uint16_t> generation; // Starts at 1 so no live handle is 0
+    std::vector<uint8_t> kind;
+    std::vector<uint64_t> object_id;
+    std::vector<uint64_t> body_id; // Collider that carries the object, 0 for none
+    std::vector<uint32_t> owner; // E.g. the player holding a weapon
+
+    std::vector<uint32_t> free_indices;
+    std::unordered_map<uint64_t, uint32_t> handle_by_object;
+    uint32_t count = 0;
+    mutable std::mutex mutex;
+
+public:
+    static EntityRegistry &get_singleton();
+
+    // Returns INVALID_HANDLE once MAX_ENTITIES are alive
+    uint32_t create(Kind p_kind, uint64_t p_object_id, uint64_t p_body_id, uint32_t p_owner = INVALID_HANDLE);
+    void destroy(uint32_t p_handle);
+    uint32_t find(uint64_t p_object_id) const;
+
+    bool is_valid(uint32_t p_handle) const {
+        uint32_t index = get_index(p_handle);
+        return index < kind.size() && kind[index] != KIND_NONE && generation[index] == get_generation(p_handle);
+    }
+
+    // All of these return 0/KIND_NONE/INVALID_HANDLE for stale handles
+    uint64_t get_object(uint32_t p_handle) const { return is_valid(p_handle) ? object_id[get_index(p_handle)] : 0; }
+    uint64_t get_body(uint32_t p_handle) const { return is_valid(p_handle) ? body_id[get_index(p_handle)] : 0; }
+    uint32_t get_owner(uint32_t p_handle) const { return is_valid(p_handle) ? owner[get_index(p_handle)] : INVALID_HANDLE; }
+    Kind get_kind(uint32_t p_handle) const { return is_valid(p_handle) ? (Kind)kind[get_index(p_handle)] : KIND_NONE; }
+
+    // p_handle itself or the nearest owner of p_kind above it
+    uint32_t find_owner_of_kind(uint32_t p_handle, Kind p_kind) const;
+
+    // Replaces every stale handle in p_handles with INVALID_HANDLE and
+    // returns how many were replaced
+    uint32_t invalidate_stale(uint32_t *p_handles, uint32_t p_count) const;
+
+    uint32_t get_count() const { return count; }
+};
+
+}
+
+#endif // ENTITY_REGISTRY_H
@@ -0,0 +1,120 @@
+#include "health.hpp"
+#include "damage_system.hpp"
+#include "entities.hpp"
+#include <godot_cpp/core/class_db.hpp>
+
+using namespace godot;
+
+Health::Health() {}
+
+Health::~Health() {}
+
+void Health::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("apply_damage", "amount", "source"), &Health::apply_damage, DEFVAL(Variant()));
+    ClassDB::bind_method(D_METHOD("heal", "amount"), &Health::heal);
+    ClassDB::bind_method(D_METHOD("revive"), &Health::revive);
+    ClassDB::bind_method(D_METHOD("get_health"), &Health::get_health);
+    ClassDB::bind_method(D_METHOD("is_alive"), &Health::is_alive);
+
+    ClassDB::bind_method(D_METHOD("get_max_health"), &Health::get_max_health);
+    ClassDB::bind_method(D_METHOD("set_max_health", "max_health"), &Health::set_max_health);
+    ClassDB::bind_method(D_METHOD("get_armor"), &Health::get_armor);
+    ClassDB::bind_method(D_METHOD("set_armor", "armor"), &Health::set_armor);
+
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "max_health", PROPERTY_HINT_RANGE, "1,10000,1,or_greater"), "set_max_health", "get_max_health");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "armor", PROPERTY_HINT_RANGE, "0,1,0.01"), "set_armor", "get_armor");
+
+    // Emitted at most once per physics tick with the total damage taken
+    ADD_SIGNAL(MethodInfo("damaged", PropertyInfo(Variant::FLOAT, "amount"), PropertyInfo(Variant::FLOAT, "health"), PropertyInfo(Variant::OBJECT, "source")));
+    ADD_SIGNAL(MethodInfo("died"));
+}
+
+void Health::_notification(int p_what) {
+    switch (p_what) {
+        case NOTIFICATION_ENTER_TREE:
+            add_to_group(GROUP_NAME);
+            handle = Entities::register_node(this, EntityRegistry::KIND_HEALTH);
+            register_with_system();
+            break;
+        case NOTIFICATION_EXIT_TREE:
+            unregister_from_system();
+            Entities::unregister(handle);
+            break;
+    }
+}
+
+Node *Health::get_body() const {
+    return get_parent();
+}
+
+void Health::register_with_system() {
+    DamageSystem *system = DamageSystem::get_singleton();
+    if (!system || registered || handle == EntityRegistry::INVALID_HANDLE) {
+        return;
+    }
+    registered = system->register_entity(this, get_body(), max_health, armor) != DamageSystem::INVALID_HANDLE;
+}
+
+void Health::unregister_from_system() {
+    DamageSystem *system = DamageSystem::get_singleton();
+    if (system && registered) {
+        system->unregister_entity(handle);
+    }
+    registered = false;
+}
+
+void Health::apply_damage(double amount, Node *source) {
+    DamageSystem *system = DamageSystem::get_singleton();
+    ERR_FAIL_NULL_MSG(system, "Health: No DamageSystem in the scene, damage is ignored.");
+
+    register_with_system();
+    system->queue_damage(handle, amount, Entities::find_or_register(source));
+}
+
+void Health::heal(double amount) {
+    DamageSystem *system = DamageSystem::get_singleton();
+    if (system) {
+        system->heal(handle, amount);
+    }
+}
+
+void Health::revive() {
+    DamageSystem *system = DamageSystem::get_singleton();
+    if (system) {
+        system->revive(handle);
+    }
+}
+
+double Health::get_health() const {
+    DamageSystem *system = DamageSystem::get_singleton();
+    if (!system || !registered) {
+        return max_health;
+    }
+    return system->get_health(handle);
+}
+
+bool Health::is_alive() const {
+    DamageSystem *system = DamageSystem::get_singleton();
+    if (!system || !registered) {
+        return true;
+    }
+    return system->is_alive(handle);
+}
+
+void Health::set_max_health(double p_max_health) {
+    max_health = MAX(p_max_health, 1.0);
+
+    DamageSystem *system = DamageSystem::get_singleton();
+    if (system && registered) {
+        system->set_entity_max_health(handle, max_health);
+    }
+}
+
+void Health::set_armor(double p_armor) {
+    armor = CLAMP(p_armor, 0.0, 1.0);
+
+    DamageSystem *system = DamageSystem::get_singleton();
+    if (system && registered) {
+        system->set_entity_armor(handle, armor);
+    }
+}
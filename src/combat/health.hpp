@@ -0,0 +1,57 @@
+#ifndef HEALTH_H
+#define HEALTH_H
+
+#include <godot_cpp/classes/node.hpp>
+#include <godot_cpp/core/class_db.hpp>
+
+#include <cstdint>
+
+namespace godot {
+
+// Health component. Attach it as a child of the body that receives hits.
+// The actual values live in the DamageSystem; this node only owns an
+// EntityRegistry handle, valid while it is in the tree.
+class Health : public Node {
+    GDCLASS(Health, Node)
+
+private:
+    double max_health = 100.0;
+    double armor = 0.0; // Fraction of incoming damage absorbed
+
+    uint32_t handle = 0; // EntityRegistry::INVALID_HANDLE
+    bool registered = false;
+
+    Node *get_body() const;
+
+public:
+    // Lets a DamageSystem that enters the tree late pick up existing components
+    static constexpr const char *GROUP_NAME = "health_components";
+
+    Health();
+    ~Health();
+
+    static void _bind_methods();
+    void _notification(int p_what);
+
+    void register_with_system();
+    void unregister_from_system();
+    uint32_t get_handle() const { return handle; }
+
+    // Damage goes through the DamageSystem queue and lands at the next flush
+    void apply_damage(double amount, Node *source = nullptr);
+    void heal(double amount);
+    void revive();
+
+    double get_health() const;
+    bool is_alive() const;
+
+    // Property getters/setters
+    double get_max_health() const { return max_health; }
+    void set_max_health(double p_max_health);
+    double get_armor() const { return armor; }
+    void set_armor(double p_armor);
+};
+
+}
+
+#endif // HEALTH_H
@@ -0,0 +1,256 @@
+#include "hitbox_history.hpp"
+
+#include <cmath>
+
+using namespace godot;
+
+void HitboxHistory::reset(uint32_t p_max_entities, uint32_t p_frame_capacity) {
+    max_entities = p_max_entities;
+    frame_capacity = p_frame_capacity > 0 ? p_frame_capacity : 1;
+
+    poses.assign((size_t)frame_capacity * max_entities, Pose());
+    frame_time.assign(frame_capacity, 0.0);
+    clear();
+}
+
+void HitboxHistory::clear() {
+    frame_count = 0;
+    newest = frame_capacity - 1;
+}
+
+uint32_t HitboxHistory::ring_index(uint32_t p_age) const {
+    return (newest + frame_capacity - p_age) % frame_capacity;
+}
+
+void HitboxHistory::begin_frame(double p_time) {
+    newest = (newest + 1) % frame_capacity;
+    if (frame_count < frame_capacity) {
+        frame_count++;
+    }
+
+    frame_time[newest] = p_time;
+    Pose *frame = &poses[(size_t)newest * max_entities];
+    for (uint32_t i = 0; i < max_entities; i++) {
+        frame[i].key = 0;
+    }
+}
+
+void HitboxHistory::set_pose(uint32_t p_slot, const Pose &p_pose) {
+    if (p_slot >= max_entities || frame_count == 0) {
+        return;
+    }
+    poses[(size_t)newest * max_entities + p_slot] = p_pose;
+}
+
+double HitboxHistory::get_oldest_time() const {
+    return frame_count > 0 ? frame_time[ring_index(frame_count - 1)] : 0.0;
+}
+
+double HitboxHistory::get_newest_time() const {
+    return frame_count > 0 ? frame_time[newest] : 0.0;
+}
+
+bool HitboxHistory::find_frames(double p_time, uint32_t &r_older, uint32_t &r_newer, float &r_weight) const {
+    if (frame_count == 0) {
+        return false;
+    }
+
+    // Clamp to the recorded window
+    if (p_time >= frame_time[newest] || frame_count == 1) {
+        r_older = r_newer = newest;
+        r_weight = 0.0f;
+        return true;
+    }
+    uint32_t oldest = ring_index(frame_count - 1);
+    if (p_time <= frame_time[oldest]) {
+        r_older = r_newer = oldest;
+        r_weight = 0.0f;
+        return true;
+    }
+
+    // Binary search on age; frame times only increase with ring order
+    uint32_t newer_age = 0;
+    uint32_t older_age = frame_count - 1;
+    while (older_age - newer_age > 1) {
+        uint32_t mid = (newer_age + older_age) / 2;
+        if (frame_time[ring_index(mid)] > p_time) {
+            newer_age = mid;
+        } else {
+            older_age = mid;
+        }
+    }
+
+    r_older = ring_index(older_age);
+    r_newer = ring_index(newer_age);
+    double span = frame_time[r_newer] - frame_time[r_older];
+    r_weight = span > 0.0 ? (float)((p_time - frame_time[r_older]) / span) : 0.0f;
+    return true;
+}
+
+static void interpolate_pose(const HitboxHistory::Pose &p_from, const HitboxHistory::Pose &p_to, float p_weight, HitboxHistory::Pose &r_pose) {
+    r_pose = p_to;
+    for (int i = 0; i < 3; i++) {
+        r_pose.position[i] = p_from.position[i] + (p_to.position[i] - p_from.position[i]) * p_weight;
+    }
+
+    // Normalized lerp along the shorter arc; ticks are close enough for nlerp
+    float dot = 0.0f;
+    for (int i = 0; i < 4; i++) {
+        dot += p_from.rotation[i] * p_to.rotation[i];
+    }
+    float sign = dot < 0.0f ? -1.0f : 1.0f;
+    float length_sq = 0.0f;
+    for (int i = 0; i < 4; i++) {
+        r_pose.rotation[i] = p_from.rotation[i] + (p_to.rotation[i] * sign - p_from.rotation[i]) * p_weight;
+        length_sq += r_pose.rotation[i] * r_pose.rotation[i];
+    }
+    float inv_length = length_sq > 0.0f ? 1.0f / std::sqrt(length_sq) : 1.0f;
+    for (int i = 0; i < 4; i++) {
+        r_pose.rotation[i] *= inv_length;
+    }
+}
+
+bool HitboxHistory::sample_pose(uint32_t p_slot, double p_time, Pose &r_pose) const {
+    uint32_t older, newer;
+    float weight;
+    if (p_slot >= max_entities || !find_frames(p_time, older, newer, weight)) {
+        return false;
+    }
+
+    const Pose &from = poses[(size_t)older * max_entities + p_slot];
+    const Pose &to = poses[(size_t)newer * max_entities + p_slot];
+
+    // Only blend frames that hold the same entity; otherwise use the closer one
+    if (from.key != 0 && from.key == to.key) {
+        interpolate_pose(from, to, weight, r_pose);
+        return true;
+    }
+    const Pose &closer = weight < 0.5f ? from : to;
+    if (closer.key == 0) {
+        return false;
+    }
+    r_pose = closer;
+    return true;
+}
+
+// Rotates p_v by the inverse of the unit quaternion p_q
+static void inverse_rotate(const float p_q[4], const float p_v[3], float r_v[3]) {
+    float ux = -p_q[0], uy = -p_q[1], uz = -p_q[2], w = p_q[3];
+    float tx = 2.0f * (uy * p_v[2] - uz * p_v[1]);
+    float ty = 2.0f * (uz * p_v[0] - ux * p_v[2]);
+    float tz = 2.0f * (ux * p_v[1] - uy * p_v[0]);
+    r_v[0] = p_v[0] + w * tx + (uy * tz - uz * ty);
+    r_v[1] = p_v[1] + w * ty + (uz * tx - ux * tz);
+    r_v[2] = p_v[2] + w * tz + (ux * ty - uy * tx);
+}
+
+bool HitboxHistory::intersect_pose(const Pose &p_pose, const float p_origin[3], const float p_direction[3], float p_max_distance, float &r_distance) {
+    // Move the ray into the hurtbox space instead of moving the box
+    float relative[3] = { p_origin[0] - p_pose.position[0], p_origin[1] - p_pose.position[1], p_origin[2] - p_pose.position[2] };
+    float origin[3], direction[3];
+    inverse_rotate(p_pose.rotation, relative, origin);
+    inverse_rotate(p_pose.rotation, p_direction, direction);
+
+    float t_min = 0.0f;
+    float t_max = p_max_distance;
+    for (int i = 0; i < 3; i++) {
+        float o = origin[i] - p_pose.center[i];
+        float h = p_pose.half_extents[i];
+        if (std::fabs(direction[i]) < 1e-12f) {
+            if (o < -h || o > h) {
+                return false;
+            }
+            continue;
+        }
+        float inv = 1.0f / direction[i];
+        float t0 = (-h - o) * inv;
+        float t1 = (h - o) * inv;
+        if (t0 > t1) {
+            float swap = t0;
+            t0 = t1;
+            t1 = swap;
+        }
+        t_min = t0 > t_min ? t0 : t_min;
+        t_max = t1 < t_max ? t1 : t_max;
+        if (t_min > t_max) {
+            return false;
+        }
+    }
+
+    r_distance = t_min;
+    return true;
+}
+
+// Conservative test of the ray segment against a sphere around a pose
+static bool ray_near_sphere(const float p_center[3], float p_radius_sq, const float p_origin[3], const float p_direction[3], float p_max_distance) {
+    float to_center[3] = { p_center[0] - p_origin[0], p_center[1] - p_origin[1], p_center[2] - p_origin[2] };
+    float along = to_center[0] * p_direction[0] + to_center[1] * p_direction[1] + to_center[2] * p_direction[2];
+    float distance_sq = to_center[0] * to_center[0] + to_center[1] * to_center[1] + to_center[2] * to_center[2];
+
+    // Clamp to the segment so boxes behind the origin or past the end are rejected
+    float t = along < 0.0f ? 0.0f : (along > p_max_distance ? p_max_distance : along);
+    float closest_sq = distance_sq - 2.0f * t * along + t * t;
+    return closest_sq <= p_radius_sq;
+}
+
+bool HitboxHistory::raycast(double p_time, const float p_origin[3], const float p_direction[3], float p_max_distance, uint64_t p_ignore_key, RayHit &r_hit) const {
+    uint32_t older, newer;
+    float weight;
+    if (!find_frames(p_time, older, newer, weight)) {
+        return false;
+    }
+
+    const Pose *from_frame = &poses[(size_t)older * max_entities];
+    const Pose *to_frame = &poses[(size_t)newer * max_entities];
+
+    bool found = false;
+    float nearest = p_max_distance;
+    for (uint32_t slot = 0; slot < max_entities; slot++) {
+        const Pose &from = from_frame[slot];
+        const Pose &to = to_frame[slot];
+
+        Pose pose;
+        const Pose *tested;
+        if (from.key != 0 && from.key == to.key) {
+            if (from.key == p_ignore_key) {
+                continue;
+            }
+
+            // Cheap bounding-sphere reject before blending rotations
+            float center[3];
+            float radius_sq = 0.0f;
+            for (int i = 0; i < 3; i++) {
+                center[i] = from.position[i] + (to.position[i] - from.position[i]) * weight;
+                float reach = std::fabs(to.center[i]) + to.half_extents[i];
+                radius_sq += reach * reach;
+            }
+            if (!ray_near_sphere(center, radius_sq, p_origin, p_direction, nearest)) {
+                continue;
+            }
+
+            interpolate_pose(from, to, weight, pose);
+            tested = &pose;
+        } else {
+            tested = weight < 0.5f ? &from : &to;
+            if (tested->key == 0 || tested->key == p_ignore_key) {
+                continue;
+            }
+        }
+
+        float distance;
+        if (intersect_pose(*tested, p_origin, p_direction, nearest, distance)) {
+            found = true;
+            nearest = distance;
+            r_hit.key = tested->key;
+            r_hit.slot = slot;
+        }
+    }
+
+    if (found) {
+        r_hit.distance = nearest;
+        for (int i = 0; i < 3; i++) {
+            r_hit.point[i] = p_origin[i] + p_direction[i] * nearest;
+        }
+    }
+    return found;
+}
@@ -0,0 +1,69 @@
+#ifndef HITBOX_HISTORY_H
+#define HITBOX_HISTORY_H
+
+#include <cstdint>
+#include <vector>
+
+namespace godot {
+
+// Ring of recorded hurtbox poses for lag compensation. Rewinds test rays
+// against poses interpolated at a past time; the bodies are never moved.
+class HitboxHistory {
+public:
+    struct Pose {
+        float position[3] = { 0.0f, 0.0f, 0.0f };
+        float rotation[4] = { 0.0f, 0.0f, 0.0f, 1.0f }; // Quaternion x, y, z, w
+        float center[3] = { 0.0f, 0.0f, 0.0f }; // Hurtbox center in local space
+        float half_extents[3] = { 0.5f, 0.5f, 0.5f };
+        uint64_t key = 0; // Entity identity, 0 marks an empty slot
+    };
+
+    struct RayHit {
+        uint64_t key = 0;
+        uint32_t slot = 0;
+        float distance = 0.0f;
+        float point[3] = { 0.0f, 0.0f, 0.0f };
+    };
+
+private:
+    std::vector<Pose> poses; // frame_capacity * max_entities
+    std::vector<double> frame_time;
+
+    uint32_t max_entities = 0;
+    uint32_t frame_capacity = 0;
+    uint32_t frame_count = 0;
+    uint32_t newest = 0; // Ring index of the newest frame
+
+    uint32_t ring_index(uint32_t p_age) const; // 0 is the newest frame
+    bool find_frames(double p_time, uint32_t &r_older, uint32_t &r_newer, float &r_weight) const;
+
+public:
+    void reset(uint32_t p_max_entities, uint32_t p_frame_capacity);
+    void clear();
+
+    // Starts a new frame, overwriting the oldest once the ring is full. Every
+    // slot starts empty; fill the tracked ones with set_pose.
+    void begin_frame(double p_time);
+    void set_pose(uint32_t p_slot, const Pose &p_pose);
+
+    // Pose of p_slot at p_time, interpolated between the recorded frames and
+    // clamped to the recorded range. Fails when the slot was empty.
+    bool sample_pose(uint32_t p_slot, double p_time, Pose &r_pose) const;
+
+    // Nearest historical hurtbox hit by the ray within p_max_distance,
+    // skipping the entity with p_ignore_key (usually the shooter).
+    bool raycast(double p_time, const float p_origin[3], const float p_direction[3], float p_max_distance, uint64_t p_ignore_key, RayHit &r_hit) const;
+
+    uint32_t get_max_entities() const { return max_entities; }
+    uint32_t get_frame_capacity() const { return frame_capacity; }
+    uint32_t get_frame_count() const { return frame_count; }
+    double get_oldest_time() const;
+    double get_newest_time() const;
+
+    // Ray against the oriented hurtbox of a single pose
+    static bool intersect_pose(const Pose &p_pose, const float p_origin[3], const float p_direction[3], float p_max_distance, float &r_distance);
+};
+
+}
+
+#endif // HITBOX_HISTORY_H
@@ -0,0 +1,433 @@
+#include "hurtbox_tree.hpp"
+
+#include <cmath>
+
+using namespace godot;
+
+namespace {
+
+constexpr int STACK_SIZE = 64; // Tree heights stay far below this for any entity count we can simulate
+
+float surface_area(const float p_min[3], const float p_max[3]) {
+    float x = p_max[0] - p_min[0];
+    float y = p_max[1] - p_min[1];
+    float z = p_max[2] - p_min[2];
+    return 2.0f * (x * y + y * z + z * x);
+}
+
+float union_area(const float p_min_a[3], const float p_max_a[3], const float p_min_b[3], const float p_max_b[3]) {
+    float min[3], max[3];
+    for (int i = 0; i < 3; i++) {
+        min[i] = p_min_a[i] < p_min_b[i] ? p_min_a[i] : p_min_b[i];
+        max[i] = p_max_a[i] > p_max_b[i] ? p_max_a[i] : p_max_b[i];
+    }
+    return surface_area(min, max);
+}
+
+bool contains(const float p_outer_min[3], const float p_outer_max[3], const float p_min[3], const float p_max[3]) {
+    for (int i = 0; i < 3; i++) {
+        if (p_min[i] < p_outer_min[i] || p_max[i] > p_outer_max[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Slab test of the segment origin + direction * t, t in [0, p_max_t]
+bool segment_hits_box(const float p_min[3], const float p_max[3], const float p_origin[3], const float p_inv_direction[3], float p_max_t) {
+    float t_min = 0.0f;
+    float t_max = p_max_t;
+    for (int i = 0; i < 3; i++) {
+        float t0 = (p_min[i] - p_origin[i]) * p_inv_direction[i];
+        float t1 = (p_max[i] - p_origin[i]) * p_inv_direction[i];
+        if (t0 > t1) {
+            float swap = t0;
+            t0 = t1;
+            t1 = swap;
+        }
+        // NaN from 0 * inf (origin on a slab plane of a flat axis) must not reject
+        t_min = t0 > t_min ? t0 : t_min;
+        t_max = t1 < t_max ? t1 : t_max;
+        if (t_min > t_max) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+void HurtboxTree::get_pose_bounds(const HitboxHistory::Pose &p_pose, float r_min[3], float r_max[3]) {
+    // Rotation matrix of the quaternion, then the usual |R| * extents trick
+    float x = p_pose.rotation[0], y = p_pose.rotation[1], z = p_pose.rotation[2], w = p_pose.rotation[3];
+    float m[3][3] = {
+        { 1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y - w * z), 2.0f * (x * z + w * y) },
+        { 2.0f * (x * y + w * z), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z - w * x) },
+        { 2.0f * (x * z - w * y), 2.0f * (y * z + w * x), 1.0f - 2.0f * (x * x + y * y) },
+    };
+    for (int i = 0; i < 3; i++) {
+        float center = p_pose.position[i];
+        float reach = 0.0f;
+        for (int j = 0; j < 3; j++) {
+            center += m[i][j] * p_pose.center[j];
+            reach += std::fabs(m[i][j]) * p_pose.half_extents[j];
+        }
+        r_min[i] = center - reach;
+        r_max[i] = center + reach;
+    }
+}
+
+void HurtboxTree::clear() {
+    nodes.clear();
+    poses.clear();
+    root = NULL_NODE;
+    free_list = NULL_NODE;
+    proxy_count = 0;
+    reinserts = 0;
+}
+
+void HurtboxTree::reserve(uint32_t p_proxies) {
+    // A binary tree with n leaves has 2n - 1 nodes
+    size_t count = p_proxies > 0 ? (size_t)p_proxies * 2 - 1 : 0;
+    nodes.reserve(count);
+    poses.reserve(count);
+}
+
+uint32_t HurtboxTree::allocate_node() {
+    uint32_t node;
+    if (free_list != NULL_NODE) {
+        node = free_list;
+        free_list = nodes[node].parent;
+    } else {
+        node = nodes.size();
+        nodes.emplace_back();
+        poses.emplace_back();
+    }
+    Node &n = nodes[node];
+    n.parent = NULL_NODE;
+    n.child[0] = n.child[1] = NULL_NODE;
+    n.height = 0;
+    return node;
+}
+
+void HurtboxTree::free_node(uint32_t p_node) {
+    nodes[p_node].parent = free_list;
+    nodes[p_node].height = -1;
+    poses[p_node].key = 0;
+    free_list = p_node;
+}
+
+void HurtboxTree::set_fat_bounds(uint32_t p_leaf) {
+    Node &leaf = nodes[p_leaf];
+    get_pose_bounds(poses[p_leaf], leaf.min, leaf.max);
+    for (int i = 0; i < 3; i++) {
+        leaf.min[i] -= margin;
+        leaf.max[i] += margin;
+    }
+}
+
+uint32_t HurtboxTree::create_proxy(const HitboxHistory::Pose &p_pose) {
+    uint32_t leaf = allocate_node();
+    poses[leaf] = p_pose;
+    set_fat_bounds(leaf);
+    insert_leaf(leaf);
+    proxy_count++;
+    return leaf;
+}
+
+void HurtboxTree::destroy_proxy(uint32_t p_proxy) {
+    if (p_proxy >= nodes.size() || nodes[p_proxy].height != 0) {
+        return;
+    }
+    remove_leaf(p_proxy);
+    free_node(p_proxy);
+    proxy_count--;
+}
+
+bool HurtboxTree::move_proxy(uint32_t p_proxy, const HitboxHistory::Pose &p_pose) {
+    if (p_proxy >= nodes.size() || nodes[p_proxy].height != 0) {
+        return false;
+    }
+    poses[p_proxy] = p_pose;
+
+    float min[3], max[3];
+    get_pose_bounds(p_pose, min, max);
+    if (contains(nodes[p_proxy].min, nodes[p_proxy].max, min, max)) {
+        return false;
+    }
+
+    remove_leaf(p_proxy);
+    set_fat_bounds(p_proxy);
+    insert_leaf(p_proxy);
+    reinserts++;
+    return true;
+}
+
+uint32_t HurtboxTree::take_reinsert_count() {
+    uint32_t count = reinserts;
+    reinserts = 0;
+    return count;
+}
+
+void HurtboxTree::refit_upwards(uint32_t p_node) {
+    uint32_t index = p_node;
+    while (index != NULL_NODE) {
+        index = balance(index);
+
+        Node &node = nodes[index];
+        const Node &a = nodes[node.child[0]];
+        const Node &b = nodes[node.child[1]];
+        for (int i = 0; i < 3; i++) {
+            node.min[i] = a.min[i] < b.min[i] ? a.min[i] : b.min[i];
+            node.max[i] = a.max[i] > b.max[i] ? a.max[i] : b.max[i];
+        }
+        node.height = 1 + (a.height > b.height ? a.height : b.height);
+        index = node.parent;
+    }
+}
+
+void HurtboxTree::insert_leaf(uint32_t p_leaf) {
+    if (root == NULL_NODE) {
+        root = p_leaf;
+        nodes[root].parent = NULL_NODE;
+        return;
+    }
+
+    // Walk down towards the sibling whose union grows the tree the least
+    const float *leaf_min = nodes[p_leaf].min;
+    const float *leaf_max = nodes[p_leaf].max;
+    uint32_t index = root;
+    while (!nodes[index].is_leaf()) {
+        const Node &node = nodes[index];
+        float area = surface_area(node.min, node.max);
+        float combined = union_area(node.min, node.max, leaf_min, leaf_max);
+
+        // Cost of making a new parent here, and the cost pushed down to children
+        float cost = 2.0f * combined;
+        float inheritance = 2.0f * (combined - area);
+
+        float child_cost[2];
+        for (int c = 0; c < 2; c++) {
+            const Node &child = nodes[node.child[c]];
+            float grown = union_area(child.min, child.max, leaf_min, leaf_max);
+            child_cost[c] = child.is_leaf() ? grown + inheritance : grown - surface_area(child.min, child.max) + inheritance;
+        }
+
+        if (cost < child_cost[0] && cost < child_cost[1]) {
+            break;
+        }
+        index = child_cost[0] < child_cost[1] ? node.child[0] : node.child[1];
+    }
+
+    // New parent for the leaf and the chosen sibling
+    uint32_t sibling = index;
+    uint32_t old_parent = nodes[sibling].parent;
+    uint32_t parent = allocate_node();
+    nodes[parent].parent = old_parent;
+    nodes[parent].child[0] = sibling;
+    nodes[parent].child[1] = p_leaf;
+    nodes[sibling].parent = parent;
+    nodes[p_leaf].parent = parent;
+
+    if (old_parent == NULL_NODE) {
+        root = parent;
+    } else {
+        Node &grand = nodes[old_parent];
+        grand.child[grand.child[0] == sibling ? 0 : 1] = parent;
+    }
+
+    refit_upwards(parent);
+}
+
+void HurtboxTree::remove_leaf(uint32_t p_leaf) {
+    if (p_leaf == root) {
+        root = NULL_NODE;
+        return;
+    }
+
+    uint32_t parent = nodes[p_leaf].parent;
+    uint32_t grand = nodes[parent].parent;
+    uint32_t sibling = nodes[parent].child[nodes[parent].child[0] == p_leaf ? 1 : 0];
+
+    if (grand == NULL_NODE) {
+        root = sibling;
+        nodes[sibling].parent = NULL_NODE;
+        free_node(parent);
+        return;
+    }
+
+    // The sibling takes the place of the parent
+    Node &g = nodes[grand];
+    g.child[g.child[0] == parent ? 0 : 1] = sibling;
+    nodes[sibling].parent = grand;
+    free_node(parent);
+    refit_upwards(grand);
+}
+
+// Rotates the taller child of p_node up when the children differ in height by
+// more than one. Returns the node now at this position of the tree.
+uint32_t HurtboxTree::balance(uint32_t p_node) {
+    Node &a = nodes[p_node];
+    if (a.is_leaf() || a.height < 2) {
+        return p_node;
+    }
+
+    uint32_t ib = a.child[0];
+    uint32_t ic = a.child[1];
+    int32_t skew = nodes[ic].height - nodes[ib].height;
+    if (skew >= -1 && skew <= 1) {
+        return p_node;
+    }
+
+    // Promote the taller child (up) and give p_node its shorter grandchild
+    int up_side = skew > 1 ? 1 : 0;
+    uint32_t up = a.child[up_side];
+    uint32_t other = a.child[1 - up_side];
+    Node &u = nodes[up];
+    uint32_t f = u.child[0];
+    uint32_t g = u.child[1];
+
+    u.child[0] = p_node;
+    u.parent = a.parent;
+    a.parent = up;
+    if (u.parent == NULL_NODE) {
+        root = up;
+    } else {
+        Node &parent = nodes[u.parent];
+        parent.child[parent.child[0] == p_node ? 0 : 1] = up;
+    }
+
+    // Keep the taller grandchild under up
+    uint32_t keep = nodes[f].height > nodes[g].height ? f : g;
+    uint32_t give = keep == f ? g : f;
+    u.child[1] = keep;
+    a.child[up_side] = give;
+    nodes[give].parent = p_node;
+
+    for (int i = 0; i < 3; i++) {
+        const Node &o = nodes[other];
+        const Node &gv = nodes[give];
+        const Node &k = nodes[keep];
+        a.min[i] = o.min[i] < gv.min[i] ? o.min[i] : gv.min[i];
+        a.max[i] = o.max[i] > gv.max[i] ? o.max[i] : gv.max[i];
+        u.min[i] = a.min[i] < k.min[i] ? a.min[i] : k.min[i];
+        u.max[i] = a.max[i] > k.max[i] ? a.max[i] : k.max[i];
+    }
+    int32_t other_height = nodes[other].height;
+    int32_t give_height = nodes[give].height;
+    a.height = 1 + (other_height > give_height ? other_height : give_height);
+    int32_t keep_height = nodes[keep].height;
+    u.height = 1 + (a.height > keep_height ? a.height : keep_height);
+    return up;
+}
+
+bool HurtboxTree::raycast(const float p_from[3], const float p_to[3], uint64_t p_ignore_key, Hit &r_hit) const {
+    r_hit = Hit();
+    if (root == NULL_NODE) {
+        return false;
+    }
+
+    float direction[3], inv_direction[3];
+    for (int i = 0; i < 3; i++) {
+        direction[i] = p_to[i] - p_from[i];
+        inv_direction[i] = 1.0f / direction[i]; // +-inf on flat axes is handled by the slab test
+    }
+
+    float nearest = 1.0f;
+    uint32_t stack[STACK_SIZE];
+    int top = 0;
+    stack[top++] = root;
+    while (top > 0) {
+        uint32_t index = stack[--top];
+        const Node &node = nodes[index];
+        if (!segment_hits_box(node.min, node.max, p_from, inv_direction, nearest)) {
+            continue;
+        }
+
+        if (node.is_leaf()) {
+            const HitboxHistory::Pose &pose = poses[index];
+            float fraction;
+            if (pose.key != p_ignore_key && HitboxHistory::intersect_pose(pose, p_from, direction, nearest, fraction)) {
+                nearest = fraction;
+                r_hit.key = pose.key;
+                r_hit.proxy = index;
+            }
+            continue;
+        }
+
+        if (top + 2 > STACK_SIZE) {
+            continue; // Unreachable for a balanced tree
+        }
+        stack[top++] = node.child[0];
+        stack[top++] = node.child[1];
+    }
+
+    if (r_hit.proxy == NULL_NODE) {
+        return false;
+    }
+    r_hit.fraction = nearest;
+    for (int i = 0; i < 3; i++) {
+        r_hit.point[i] = p_from[i] + direction[i] * nearest;
+    }
+    return true;
+}
+
+uint32_t HurtboxTree::raycast_batch(const Segment *p_segments, uint32_t p_count, Hit *r_hits) const {
+    uint32_t hits = 0;
+    for (uint32_t i = 0; i < p_count; i++) {
+        const Segment &segment = p_segments[i];
+        if (raycast(segment.from, segment.to, segment.ignore_key, r_hits[i])) {
+            hits++;
+        }
+    }
+    return hits;
+}
+
+int32_t HurtboxTree::compute_height(uint32_t p_node) const {
+    const Node &node = nodes[p_node];
+    if (node.is_leaf()) {
+        return 0;
+    }
+    int32_t a = compute_height(node.child[0]);
+    int32_t b = compute_height(node.child[1]);
+    return 1 + (a > b ? a : b);
+}
+
+bool HurtboxTree::validate() const {
+    if (root == NULL_NODE) {
+        return proxy_count == 0;
+    }
+    if (nodes[root].parent != NULL_NODE) {
+        return false;
+    }
+
+    uint32_t leaves = 0;
+    std::vector<uint32_t> stack;
+    stack.push_back(root);
+    while (!stack.empty()) {
+        uint32_t index = stack.back();
+        stack.pop_back();
+        const Node &node = nodes[index];
+        if (node.is_leaf()) {
+            if (node.height != 0) {
+                return false;
+            }
+            leaves++;
+            continue;
+        }
+
+        for (int c = 0; c < 2; c++) {
+            const Node &child = nodes[node.child[c]];
+            if (child.parent != index || !contains(node.min, node.max, child.min, child.max)) {
+                return false;
+            }
+            stack.push_back(node.child[c]);
+        }
+        int32_t a = nodes[node.child[0]].height;
+        int32_t b = nodes[node.child[1]].height;
+        if (node.height != 1 + (a > b ? a : b)) {
+            return false;
+        }
+    }
+    return leaves == proxy_count && compute_height(root) == nodes[root].height;
+}
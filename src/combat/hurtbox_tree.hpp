@@ -0,0 +1,102 @@
+#ifndef HURTBOX_TREE_H
+#define HURTBOX_TREE_H
+
+#include "hitbox_history.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace godot {
+
+// Dynamic AABB tree of the hurtboxes of damageable entities. Leaves are fat,
+// so a refit only reinserts entities that moved far; segment queries return
+// the nearest oriented hurtbox.
+class HurtboxTree {
+public:
+    static constexpr uint32_t NULL_NODE = 0xFFFFFFFFu;
+
+    struct Segment {
+        float from[3];
+        float to[3];
+        uint64_t ignore_key; // Usually the shooter, 0 ignores nothing
+    };
+
+    struct Hit {
+        uint64_t key = 0; // 0 when nothing was hit
+        uint32_t proxy = NULL_NODE;
+        float fraction = 1.0f; // Along the segment
+        float point[3] = { 0.0f, 0.0f, 0.0f };
+    };
+
+private:
+    struct Node {
+        float min[3];
+        float max[3];
+        uint32_t parent = NULL_NODE;
+        uint32_t child[2] = { NULL_NODE, NULL_NODE }; // NULL_NODE for leaves
+        int32_t height = -1; // 0 for leaves, -1 while free
+        bool is_leaf() const { return child[0] == NULL_NODE; }
+    };
+
+    std::vector<Node> nodes;
+    std::vector<HitboxHistory::Pose> poses; // Indexed by node, set for leaves
+    uint32_t root = NULL_NODE;
+    uint32_t free_list = NULL_NODE; // Linked through Node::parent
+    uint32_t proxy_count = 0;
+    float margin = 0.25f;
+    uint32_t reinserts = 0;
+
+    uint32_t allocate_node();
+    void free_node(uint32_t p_node);
+    void insert_leaf(uint32_t p_leaf);
+    void remove_leaf(uint32_t p_leaf);
+    uint32_t balance(uint32_t p_node);
+    void refit_upwards(uint32_t p_node);
+    void set_fat_bounds(uint32_t p_leaf);
+    int32_t compute_height(uint32_t p_node) const;
+
+public:
+    // Bounds of an oriented hurtbox in world space
+    static void get_pose_bounds(const HitboxHistory::Pose &p_pose, float r_min[3], float r_max[3]);
+
+    void clear();
+    void reserve(uint32_t p_proxies);
+
+    // Proxy ids stay valid until destroyed
+    uint32_t create_proxy(const HitboxHistory::Pose &p_pose);
+    void destroy_proxy(uint32_t p_proxy);
+    // Returns true when the hurtbox left its fat box and was reinserted
+    bool move_proxy(uint32_t p_proxy, const HitboxHistory::Pose &p_pose);
+    const HitboxHistory::Pose &get_pose(uint32_t p_proxy) const { return poses[p_proxy]; }
+
+    // Nearest hurtbox crossed by the segment, skipping p_ignore_key
+    bool raycast(const float p_from[3], const float p_to[3], uint64_t p_ignore_key, Hit &r_hit) const;
+    // One query per segment, r_hits lines up with p_segments. Returns the number of hits.
+    uint32_t raycast_batch(const Segment *p_segments, uint32_t p_count, Hit *r_hits) const;
+
+    // Calls p_func(min, max) with the fat box of every proxy
+    template <typename F>
+    void for_each_fat_box(F p_func) const {
+        for (const Node &node : nodes) {
+            if (node.height == 0) {
+                p_func(node.min, node.max);
+            }
+        }
+    }
+
+    uint32_t get_proxy_count() const { return proxy_count; }
+    int32_t get_height() const { return root == NULL_NODE ? 0 : nodes[root].height; }
+    // Reinsertions since the last call, i.e. how much a refit actually changed
+    uint32_t take_reinsert_count();
+
+    // Distance a hurtbox may move before it is reinserted
+    float get_margin() const { return margin; }
+    void set_margin(float p_margin) { margin = p_margin > 0.0f ? p_margin : 0.0f; }
+
+    // Checks parent links, heights and that every fat box encloses its children
+    bool validate() const;
+};
+
+}
+
+#endif // HURTBOX_TREE_H
@@ -0,0 +1,212 @@
+#include "lag_compensation.hpp"
+#include <godot_cpp/classes/engine.hpp>
+#include <godot_cpp/classes/scene_tree.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/variant/typed_array.hpp>
+
+#include <cmath>
+
+using namespace godot;
+
+LagCompensation* LagCompensation::singleton = nullptr;
+
+// After bodies have moved, before ProjectileManager resolves the tick's shots
+static const int RECORD_PROCESS_PRIORITY = 50;
+
+// Roughly a standing humanoid, used when a body does not provide get_hurtbox()
+static const AABB DEFAULT_HURTBOX = AABB(Vector3(-0.4, 0.0, -0.4), Vector3(0.8, 1.8, 0.8));
+
+LagCompensation::LagCompensation() {
+    singleton = this;
+}
+
+LagCompensation::~LagCompensation() {
+    if (singleton == this) {
+        singleton = nullptr;
+    }
+}
+
+void LagCompensation::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("register_entity", "body", "hurtbox"), &LagCompensation::register_entity);
+    ClassDB::bind_method(D_METHOD("unregister_entity", "body"), &LagCompensation::unregister_entity);
+    ClassDB::bind_method(D_METHOD("rewind_raycast", "time", "origin", "direction", "max_distance", "ignore_body"), &LagCompensation::rewind_raycast_bind, DEFVAL(Variant()));
+    ClassDB::bind_method(D_METHOD("get_oldest_time"), &LagCompensation::get_oldest_time);
+    ClassDB::bind_method(D_METHOD("get_tracked_count"), &LagCompensation::get_tracked_count);
+    ClassDB::bind_static_method("LagCompensation", D_METHOD("get_time"), &LagCompensation::get_time);
+
+    ClassDB::bind_method(D_METHOD("get_history_seconds"), &LagCompensation::get_history_seconds);
+    ClassDB::bind_method(D_METHOD("set_history_seconds", "seconds"), &LagCompensation::set_history_seconds);
+    ClassDB::bind_method(D_METHOD("get_max_entities"), &LagCompensation::get_max_entities);
+    ClassDB::bind_method(D_METHOD("set_max_entities", "max_entities"), &LagCompensation::set_max_entities);
+
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "history_seconds", PROPERTY_HINT_RANGE, "0.05,5.0,0.01,suffix:s"), "set_history_seconds", "get_history_seconds");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "max_entities", PROPERTY_HINT_RANGE, "1,1024,1,or_greater"), "set_max_entities", "get_max_entities");
+}
+
+// Simulated time, so frame stamps stay one tick apart however late a tick runs
+double LagCompensation::get_time() {
+    Engine *engine = Engine::get_singleton();
+    return (double)engine->get_physics_frames() / engine->get_physics_ticks_per_second();
+}
+
+AABB LagCompensation::get_body_hurtbox(Node *p_body) {
+    return p_body && p_body->has_method("get_hurtbox") ? (AABB)p_body->call("get_hurtbox") : DEFAULT_HURTBOX;
+}
+
+void LagCompensation::_ready() {
+    set_physics_process_priority(RECORD_PROCESS_PRIORITY);
+    reset_history();
+
+    // Bodies that entered the tree before us
+    TypedArray<Node> bodies = get_tree()->get_nodes_in_group(GROUP_NAME);
+    for (int i = 0; i < bodies.size(); i++) {
+        Node3D* body = Object::cast_to<Node3D>(bodies[i]);
+        if (body) {
+            register_entity(body, get_body_hurtbox(body));
+        }
+    }
+}
+
+void LagCompensation::_physics_process(double delta) {
+    record_frame();
+}
+
+void LagCompensation::reset_history() {
+    // One frame per tick of the window, plus one so the full window can be bracketed
+    int ticks_per_second = Engine::get_singleton()->get_physics_ticks_per_second();
+    uint32_t frames = (uint32_t)std::ceil(history_seconds * ticks_per_second) + 1;
+
+    // Keep the bodies that are already tracked
+    std::vector<ObjectID> bodies;
+    std::vector<HitboxHistory::Pose> hurtboxes;
+    for (uint32_t slot = 0; slot < slot_body.size(); slot++) {
+        if (!slot_body[slot].is_null()) {
+            bodies.push_back(slot_body[slot]);
+            hurtboxes.push_back(slot_hurtbox[slot]);
+        }
+    }
+
+    history.reset(max_entities, frames);
+    slot_body.assign(max_entities, ObjectID());
+    slot_hurtbox.assign(max_entities, HitboxHistory::Pose());
+    slot_by_body.clear();
+    free_slots.clear();
+    for (int slot = max_entities - 1; slot >= 0; slot--) {
+        free_slots.push_back(slot);
+    }
+
+    for (uint32_t i = 0; i < bodies.size() && !free_slots.empty(); i++) {
+        uint32_t slot = free_slots.back();
+        free_slots.pop_back();
+        slot_body[slot] = bodies[i];
+        slot_hurtbox[slot] = hurtboxes[i];
+        slot_by_body[(uint64_t)bodies[i]] = slot;
+    }
+}
+
+bool LagCompensation::register_entity(Node3D* body, const AABB &hurtbox) {
+    ERR_FAIL_NULL_V(body, false);
+    if (slot_by_body.count(body->get_instance_id())) {
+        return true;
+    }
+    if (free_slots.empty()) {
+        WARN_PRINT_ONCE("LagCompensation: max_entities reached, body is not lag compensated");
+        return false;
+    }
+
+    uint32_t slot = free_slots.back();
+    free_slots.pop_back();
+
+    HitboxHistory::Pose hurtbox_pose;
+    Vector3 center = hurtbox.get_center();
+    Vector3 half_extents = hurtbox.size * 0.5;
+    for (int i = 0; i < 3; i++) {
+        hurtbox_pose.center[i] = center[i];
+        hurtbox_pose.half_extents[i] = half_extents[i];
+    }
+    hurtbox_pose.key = body->get_instance_id();
+
+    slot_body[slot] = body->get_instance_id();
+    slot_hurtbox[slot] = hurtbox_pose;
+    slot_by_body[body->get_instance_id()] = slot;
+    return true;
+}
+
+void LagCompensation::unregister_entity(Node3D* body) {
+    ERR_FAIL_NULL(body);
+    auto it = slot_by_body.find(body->get_instance_id());
+    if (it == slot_by_body.end()) {
+        return;
+    }
+
+    // Past frames keep the body's key, so rewinds still see where it was
+    slot_body[it->second] = ObjectID();
+    free_slots.push_back(it->second);
+    slot_by_body.erase(it);
+}
+
+void LagCompensation::record_frame() {
+    history.begin_frame(get_time());
+
+    for (auto it = slot_by_body.begin(); it != slot_by_body.end();) {
+        uint32_t slot = it->second;
+        Node3D* body = Object::cast_to<Node3D>(ObjectDB::get_instance(slot_body[slot]));
+        if (!body) {
+            // Freed without unregister_entity, e.g. a body picked up from the group
+            slot_body[slot] = ObjectID();
+            free_slots.push_back(slot);
+            it = slot_by_body.erase(it);
+            continue;
+        }
+        ++it;
+
+        // Scale is not part of the pose, hurtboxes are authored in world units
+        Transform3D transform = body->get_global_transform();
+        Quaternion rotation = transform.basis.get_rotation_quaternion();
+
+        HitboxHistory::Pose pose = slot_hurtbox[slot];
+        pose.position[0] = transform.origin.x;
+        pose.position[1] = transform.origin.y;
+        pose.position[2] = transform.origin.z;
+        pose.rotation[0] = rotation.x;
+        pose.rotation[1] = rotation.y;
+        pose.rotation[2] = rotation.z;
+        pose.rotation[3] = rotation.w;
+        history.set_pose(slot, pose);
+    }
+}
+
+bool LagCompensation::rewind_raycast(double time, const Vector3 &origin, const Vector3 &direction, float max_distance, ObjectID ignore_body, HitboxHistory::RayHit &r_hit) const {
+    const float from[3] = { (float)origin.x, (float)origin.y, (float)origin.z };
+    const float dir[3] = { (float)direction.x, (float)direction.y, (float)direction.z };
+    return history.raycast(time, from, dir, max_distance, (uint64_t)ignore_body, r_hit);
+}
+
+Dictionary LagCompensation::rewind_raycast_bind(double time, Vector3 origin, Vector3 direction, double max_distance, Node3D* ignore_body) const {
+    Dictionary result;
+    HitboxHistory::RayHit hit;
+    ObjectID ignore = ignore_body ? ObjectID(ignore_body->get_instance_id()) : ObjectID();
+    if (!rewind_raycast(time, origin, direction.normalized(), max_distance, ignore, hit)) {
+        return result;
+    }
+
+    result["collider_id"] = hit.key;
+    result["collider"] = ObjectDB::get_instance(hit.key);
+    result["position"] = Vector3(hit.point[0], hit.point[1], hit.point[2]);
+    result["distance"] = hit.distance;
+    return result;
+}
+
+void LagCompensation::set_history_seconds(double p_seconds) {
+    history_seconds = MAX(p_seconds, 0.0);
+    if (is_node_ready()) {
+        reset_history();
+    }
+}
+
+void LagCompensation::set_max_entities(int p_max) {
+    max_entities = MAX(p_max, 1);
+    if (is_node_ready()) {
+        reset_history();
+    }
+}
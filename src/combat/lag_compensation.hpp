@@ -0,0 +1,78 @@
+#ifndef LAG_COMPENSATION_H
+#define LAG_COMPENSATION_H
+
+#include <godot_cpp/classes/node.hpp>
+#include <godot_cpp/classes/node3d.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/core/object_id.hpp>
+
+#include "hitbox_history.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+namespace godot {
+
+// Records the hurtbox pose of every tracked body each physics tick and
+// answers rewound ray queries against that history.
+//
+// Bodies join through register_entity, or by being in GROUP_NAME when this
+// node becomes ready; a body may provide a get_hurtbox() method returning its
+// local-space AABB. A freed body gives its slot back on the next tick. Times
+// are in seconds of simulated time: physics frames over ticks per second.
+class LagCompensation : public Node {
+    GDCLASS(LagCompensation, Node)
+
+private:
+    static LagCompensation* singleton;
+
+    HitboxHistory history;
+    double history_seconds = 1.0;
+    int max_entities = 64;
+
+    // Per-slot tracked body and its local hurtbox
+    std::vector<ObjectID> slot_body;
+    std::vector<HitboxHistory::Pose> slot_hurtbox;
+    std::vector<uint32_t> free_slots;
+    std::unordered_map<uint64_t, uint32_t> slot_by_body;
+
+    void reset_history();
+    void record_frame();
+
+public:
+    static constexpr const char *GROUP_NAME = "lag_compensated";
+
+    LagCompensation();
+    ~LagCompensation();
+
+    static void _bind_methods();
+    static LagCompensation* get_singleton() { return singleton; }
+    static double get_time();
+    // The body's get_hurtbox() if it has one, else a standing humanoid
+    static AABB get_body_hurtbox(Node *p_body);
+
+    void _ready() override;
+    void _physics_process(double delta) override;
+
+    bool register_entity(Node3D* body, const AABB &hurtbox);
+    void unregister_entity(Node3D* body);
+    bool is_tracked(ObjectID body_id) const { return slot_by_body.count((uint64_t)body_id) > 0; }
+
+    // Ray against the hurtboxes as they were at p_time; bodies are not moved
+    bool rewind_raycast(double time, const Vector3 &origin, const Vector3 &direction, float max_distance, ObjectID ignore_body, HitboxHistory::RayHit &r_hit) const;
+    Dictionary rewind_raycast_bind(double time, Vector3 origin, Vector3 direction, double max_distance, Node3D* ignore_body) const;
+
+    const HitboxHistory &get_history() const { return history; }
+    double get_oldest_time() const { return history.get_oldest_time(); }
+    int get_tracked_count() const { return slot_by_body.size(); }
+
+    // Property getters/setters
+    double get_history_seconds() const { return history_seconds; }
+    void set_history_seconds(double p_seconds);
+    int get_max_entities() const { return max_entities; }
+    void set_max_entities(int p_max);
+};
+
+}
+
+#endif // LAG_COMPENSATION_H
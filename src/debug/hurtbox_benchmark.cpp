@@ -0,0 +1,289 @@
+#include "hurtbox_benchmark.hpp"
+#include <godot_cpp/classes/engine.hpp>
+#include <godot_cpp/classes/os.hpp>
+#include <godot_cpp/classes/physics_direct_space_state3d.hpp>
+#include <godot_cpp/classes/physics_server3d.hpp>
+#include <godot_cpp/classes/scene_tree.hpp>
+#include <godot_cpp/classes/time.hpp>
+#include <godot_cpp/classes/world3d.hpp>
+#include <godot_cpp/variant/utility_functions.hpp>
+
+#include <cmath>
+#include <cstring>
+
+using namespace godot;
+
+static const char *ARG_PREFIX = "--hurtbox-bench-";
+
+// A standing humanoid with its origin at the feet, as LagCompensation assumes
+static const float HURTBOX_CENTER_Y = 0.9f;
+static const float HURTBOX_HALF_EXTENTS[3] = { 0.4f, 0.9f, 0.4f };
+
+// Anything above edge grazes means the tree answers a different question
+static const double MAX_MISMATCH_RATE = 0.01;
+
+HurtboxBenchmark::HurtboxBenchmark() {
+    target_counts.push_back(64);
+    target_counts.push_back(512);
+    target_counts.push_back(4096);
+}
+
+HurtboxBenchmark::~HurtboxBenchmark() {
+    free_case();
+}
+
+void HurtboxBenchmark::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("get_target_counts"), &HurtboxBenchmark::get_target_counts);
+    ClassDB::bind_method(D_METHOD("set_target_counts", "counts"), &HurtboxBenchmark::set_target_counts);
+    ClassDB::bind_method(D_METHOD("get_segments"), &HurtboxBenchmark::get_segments);
+    ClassDB::bind_method(D_METHOD("set_segments", "segments"), &HurtboxBenchmark::set_segments);
+    ClassDB::bind_method(D_METHOD("get_ticks"), &HurtboxBenchmark::get_ticks);
+    ClassDB::bind_method(D_METHOD("set_ticks", "ticks"), &HurtboxBenchmark::set_ticks);
+    ClassDB::bind_method(D_METHOD("get_collision_layer"), &HurtboxBenchmark::get_collision_layer);
+    ClassDB::bind_method(D_METHOD("set_collision_layer", "layer"), &HurtboxBenchmark::set_collision_layer);
+    ClassDB::bind_method(D_METHOD("get_quit_when_done"), &HurtboxBenchmark::get_quit_when_done);
+    ClassDB::bind_method(D_METHOD("set_quit_when_done", "enable"), &HurtboxBenchmark::set_quit_when_done);
+
+    ADD_PROPERTY(PropertyInfo(Variant::PACKED_INT32_ARRAY, "target_counts"), "set_target_counts", "get_target_counts");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "segments", PROPERTY_HINT_RANGE, "1,100000,1,or_greater"), "set_segments", "get_segments");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "ticks", PROPERTY_HINT_RANGE, "1,1000,1,or_greater"), "set_ticks", "get_ticks");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "collision_layer", PROPERTY_HINT_LAYERS_3D_PHYSICS), "set_collision_layer", "get_collision_layer");
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "quit_when_done"), "set_quit_when_done", "get_quit_when_done");
+}
+
+float HurtboxBenchmark::randf() {
+    // splitmix64, every run casts the same segments
+    uint64_t z = (rng_state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    return (float)(z >> 40) / (float)(1ull << 24);
+}
+
+void HurtboxBenchmark::apply_command_line() {
+    PackedStringArray args = OS::get_singleton()->get_cmdline_user_args();
+    for (int i = 0; i < args.size(); i++) {
+        String arg = args[i];
+        if (!arg.begins_with(ARG_PREFIX) || arg.find("=") < 0) {
+            continue;
+        }
+        String key = arg.get_slice("=", 0).substr(strlen(ARG_PREFIX));
+        String value = arg.get_slice("=", 1);
+
+        if (key == "targets") {
+            PackedInt32Array counts;
+            PackedStringArray items = value.split(",", false);
+            for (int j = 0; j < items.size(); j++) {
+                counts.push_back(MAX(items[j].to_int(), 1));
+            }
+            set_target_counts(counts);
+        } else if (key == "segments") {
+            set_segments(value.to_int());
+        } else if (key == "ticks") {
+            set_ticks(value.to_int());
+        } else {
+            WARN_PRINT("HurtboxBenchmark: Unknown option " + arg);
+        }
+    }
+}
+
+void HurtboxBenchmark::_ready() {
+    if (Engine::get_singleton()->is_editor_hint()) {
+        set_physics_process(false);
+        return;
+    }
+    apply_command_line();
+    query.instantiate();
+    query->set_collide_with_areas(false);
+    query->set_collide_with_bodies(true);
+    query->set_collision_mask(collision_layer);
+    UtilityFunctions::print("HurtboxBenchmark: ", target_counts.size(), " cases, ", segments, " segments per tick for ", ticks, " ticks");
+}
+
+void HurtboxBenchmark::pose_target(uint32_t p_target, double p_time, HitboxHistory::Pose &r_pose) const {
+    // Same layout as the standalone benchmark: constant density, slow circles
+    uint32_t count = bodies.size();
+    float half = 4.0f * std::sqrt((float)count);
+    float phase = p_target * 2.399963f;
+    float x = std::fmod(p_target * 7.31f, 2.0f * half) - half;
+    float z = std::fmod(p_target * 13.17f, 2.0f * half) - half;
+    float yaw = (float)p_time * 0.7f + phase;
+    Vector3 origin = get_global_position();
+
+    r_pose.position[0] = origin.x + x + std::cos((float)p_time * 0.9f + phase) * 3.0f;
+    r_pose.position[1] = origin.y;
+    r_pose.position[2] = origin.z + z + std::sin((float)p_time * 1.1f + phase) * 3.0f;
+    r_pose.rotation[0] = 0.0f;
+    r_pose.rotation[1] = std::sin(yaw * 0.5f);
+    r_pose.rotation[2] = 0.0f;
+    r_pose.rotation[3] = std::cos(yaw * 0.5f);
+    r_pose.center[0] = 0.0f;
+    r_pose.center[1] = HURTBOX_CENTER_Y;
+    r_pose.center[2] = 0.0f;
+    for (int i = 0; i < 3; i++) {
+        r_pose.half_extents[i] = HURTBOX_HALF_EXTENTS[i];
+    }
+    r_pose.key = p_target + 1;
+}
+
+void HurtboxBenchmark::begin_case() {
+    Ref<World3D> world = get_world_3d();
+    ERR_FAIL_COND_MSG(world.is_null(), "HurtboxBenchmark: No 3D world to create targets in.");
+
+    PhysicsServer3D *ps = PhysicsServer3D::get_singleton();
+    shape = ps->box_shape_create();
+    ps->shape_set_data(shape, Vector3(HURTBOX_HALF_EXTENTS[0], HURTBOX_HALF_EXTENTS[1], HURTBOX_HALF_EXTENTS[2]));
+    Transform3D shape_transform(Basis(), Vector3(0, HURTBOX_CENTER_Y, 0));
+
+    uint32_t count = target_counts[case_index];
+    bodies.resize(count);
+    poses.resize(count);
+    proxies.resize(count);
+    target_by_rid.clear();
+    tree.clear();
+    tree.reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+        RID rid = ps->body_create();
+        ps->body_set_mode(rid, PhysicsServer3D::BODY_MODE_KINEMATIC);
+        ps->body_add_shape(rid, shape, shape_transform);
+        ps->body_set_collision_layer(rid, collision_layer);
+        ps->body_set_collision_mask(rid, 0);
+        ps->body_set_space(rid, world->get_space());
+        bodies[i] = rid;
+        target_by_rid[rid.get_id()] = i;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        pose_target(i, 0.0, poses[i]);
+        proxies[i] = tree.create_proxy(poses[i]);
+    }
+    move_targets(0.0);
+    tree.take_reinsert_count();
+
+    segment_list.resize(segments);
+    tree_hits.resize(segments);
+    ray_targets.resize(segments);
+    rng_state = 1;
+    ray_usec = tree_usec = refit_usec = 0;
+    ray_hits = tree_hit_count = mismatches = reinserts = 0;
+    tick = 0;
+}
+
+void HurtboxBenchmark::move_targets(double p_time) {
+    PhysicsServer3D *ps = PhysicsServer3D::get_singleton();
+    for (uint32_t i = 0; i < bodies.size(); i++) {
+        pose_target(i, p_time, poses[i]);
+        const HitboxHistory::Pose &pose = poses[i];
+        Transform3D transform(Basis(Quaternion(pose.rotation[0], pose.rotation[1], pose.rotation[2], pose.rotation[3])),
+                Vector3(pose.position[0], pose.position[1], pose.position[2]));
+        ps->body_set_state(bodies[i], PhysicsServer3D::BODY_STATE_TRANSFORM, transform);
+    }
+
+    // Only the tree side is timed, the server updates its own broadphase as bodies move
+    uint64_t start = Time::get_singleton()->get_ticks_usec();
+    for (uint32_t i = 0; i < bodies.size(); i++) {
+        tree.move_proxy(proxies[i], poses[i]);
+    }
+    refit_usec += Time::get_singleton()->get_ticks_usec() - start;
+}
+
+void HurtboxBenchmark::run_tick() {
+    PhysicsDirectSpaceState3D *space = get_world_3d()->get_direct_space_state();
+    ERR_FAIL_NULL(space);
+
+    // One tick of flight from a few meters before a target, roughly at it
+    uint32_t count = bodies.size();
+    for (HurtboxTree::Segment &segment : segment_list) {
+        const HitboxHistory::Pose &aim = poses[MIN((uint32_t)(randf() * count), count - 1)];
+        Vector3 dir(randf() * 2.0f - 1.0f, (randf() * 2.0f - 1.0f) * 0.1f, randf() * 2.0f - 1.0f);
+        dir = dir.normalized();
+        float travel = 5.0f + randf() * 10.0f;
+        for (int i = 0; i < 3; i++) {
+            float offset = (i == 1 ? 1.2f : 0.0f) + (randf() * 2.0f - 1.0f) * 0.5f;
+            segment.from[i] = aim.position[i] + offset - dir[i] * travel * 0.5f;
+            segment.to[i] = segment.from[i] + dir[i] * travel;
+        }
+        segment.ignore_key = 0;
+    }
+
+    uint64_t start = Time::get_singleton()->get_ticks_usec();
+    for (int s = 0; s < segments; s++) {
+        const HurtboxTree::Segment &segment = segment_list[s];
+        query->set_from(Vector3(segment.from[0], segment.from[1], segment.from[2]));
+        query->set_to(Vector3(segment.to[0], segment.to[1], segment.to[2]));
+        Dictionary result = space->intersect_ray(query);
+        ray_targets[s] = -1;
+        if (!result.is_empty()) {
+            auto it = target_by_rid.find(((RID)result["rid"]).get_id());
+            ray_targets[s] = it != target_by_rid.end() ? (int64_t)it->second : -1;
+        }
+    }
+    uint64_t rays_done = Time::get_singleton()->get_ticks_usec();
+    tree_hit_count += tree.raycast_batch(segment_list.data(), segments, tree_hits.data());
+    uint64_t tree_done = Time::get_singleton()->get_ticks_usec();
+    ray_usec += rays_done - start;
+    tree_usec += tree_done - rays_done;
+
+    // Grazing hits may differ, physics engines round box edges by a small margin
+    for (int s = 0; s < segments; s++) {
+        ray_hits += ray_targets[s] >= 0;
+        int64_t tree_target = tree_hits[s].key != 0 ? (int64_t)tree_hits[s].key - 1 : -1;
+        mismatches += tree_target != ray_targets[s];
+    }
+
+    tick++;
+    move_targets(tick / (double)Engine::get_singleton()->get_physics_ticks_per_second());
+    reinserts += tree.take_reinsert_count();
+}
+
+void HurtboxBenchmark::end_case() {
+    double queries = (double)ticks * segments;
+    double ray_ns = ray_usec * 1000.0 / queries;
+    double tree_ns = tree_usec * 1000.0 / queries;
+    double mismatch_rate = mismatches / queries;
+    any_mismatch = any_mismatch || mismatch_rate > MAX_MISMATCH_RATE;
+    UtilityFunctions::print(vformat("HurtboxBenchmark: %d targets, intersect_ray %.0f ns, tree %.0f ns per segment (%.1fx), refit %.1f us and %.1f reinserts per tick, height %d, hit rate %.3f / %.3f, mismatches %.4f",
+            (int64_t)bodies.size(), ray_ns, tree_ns, tree_ns > 0.0 ? ray_ns / tree_ns : 0.0,
+            refit_usec / (double)ticks, reinserts / (double)ticks, tree.get_height(),
+            ray_hits / queries, tree_hit_count / queries, mismatch_rate));
+    free_case();
+}
+
+void HurtboxBenchmark::free_case() {
+    PhysicsServer3D *ps = PhysicsServer3D::get_singleton();
+    for (const RID &rid : bodies) {
+        ps->free_rid(rid);
+    }
+    bodies.clear();
+    if (shape.is_valid()) {
+        ps->free_rid(shape);
+        shape = RID();
+    }
+    tree.clear();
+    tick = -1;
+}
+
+void HurtboxBenchmark::_physics_process(double delta) {
+    if (finished) {
+        return;
+    }
+
+    // Bodies are created one tick ahead so the space has synced them
+    if (tick < 0) {
+        if (case_index >= target_counts.size()) {
+            finished = true;
+            UtilityFunctions::print(any_mismatch ? "HurtboxBenchmark: FAIL, the tree disagrees with intersect_ray" : "HurtboxBenchmark: done");
+            if (quit_when_done) {
+                get_tree()->quit(any_mismatch ? 1 : 0);
+            }
+            return;
+        }
+        begin_case();
+        return;
+    }
+
+    run_tick();
+    if (tick >= ticks) {
+        end_case();
+        case_index++;
+    }
+}
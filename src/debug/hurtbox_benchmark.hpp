@@ -0,0 +1,96 @@
+#ifndef HURTBOX_BENCHMARK_H
+#define HURTBOX_BENCHMARK_H
+
+#include <godot_cpp/classes/node3d.hpp>
+#include <godot_cpp/classes/physics_ray_query_parameters3d.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#include "../combat/hurtbox_tree.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+namespace godot {
+
+// Compares the hurtbox tree with PhysicsDirectSpaceState3D::intersect_ray,
+// meant for `godot --headless`.
+//
+// For each entry of target_counts, the node creates that many box bodies
+// directly on the PhysicsServer3D in its world, plus a hurtbox tree proxy for
+// each with the same box. Targets walk around an arena sized to keep the
+// density constant. Every physics tick casts the same projectile-length
+// segments through both, timing each side and checking they agree on what was
+// hit, then moves the bodies and refits the tree for the next tick. Results
+// are printed per count; the run quits when done if quit_when_done is set.
+//
+// `-- --hurtbox-bench-targets=64,512,4096 --hurtbox-bench-segments=2000`
+// overrides the properties from the command line.
+class HurtboxBenchmark : public Node3D {
+    GDCLASS(HurtboxBenchmark, Node3D)
+
+private:
+    // Settings
+    PackedInt32Array target_counts;
+    int segments = 2000;
+    int ticks = 60;
+    uint32_t collision_layer = 1u << 19; // Kept apart from gameplay layers
+    bool quit_when_done = true;
+
+    // Current case
+    int case_index = 0;
+    int tick = -1; // -1 until the bodies of the case exist
+    RID shape;
+    std::vector<RID> bodies;
+    std::unordered_map<uint64_t, uint32_t> target_by_rid;
+    std::vector<HitboxHistory::Pose> poses;
+    std::vector<uint32_t> proxies;
+    HurtboxTree tree;
+    Ref<PhysicsRayQueryParameters3D> query;
+    std::vector<HurtboxTree::Segment> segment_list;
+    std::vector<HurtboxTree::Hit> tree_hits;
+    std::vector<int64_t> ray_targets; // -1 for a miss
+    uint64_t rng_state = 1;
+
+    // Totals of the current case
+    uint64_t ray_usec = 0;
+    uint64_t tree_usec = 0;
+    uint64_t refit_usec = 0;
+    uint64_t ray_hits = 0;
+    uint64_t tree_hit_count = 0;
+    uint64_t mismatches = 0;
+    uint64_t reinserts = 0;
+    bool any_mismatch = false;
+    bool finished = false;
+
+    float randf();
+    void apply_command_line();
+    void pose_target(uint32_t p_target, double p_time, HitboxHistory::Pose &r_pose) const;
+    void begin_case();
+    void end_case();
+    void run_tick();
+    void move_targets(double p_time);
+    void free_case();
+
+public:
+    HurtboxBenchmark();
+    ~HurtboxBenchmark();
+
+    static void _bind_methods();
+
+    void _ready() override;
+    void _physics_process(double delta) override;
+
+    PackedInt32Array get_target_counts() const { return target_counts; }
+    void set_target_counts(const PackedInt32Array &p_counts) { target_counts = p_counts; }
+    int get_segments() const { return segments; }
+    void set_segments(int p_segments) { segments = MAX(p_segments, 1); }
+    int get_ticks() const { return ticks; }
+    void set_ticks(int p_ticks) { ticks = MAX(p_ticks, 1); }
+    uint32_t get_collision_layer() const { return collision_layer; }
+    void set_collision_layer(uint32_t p_layer) { collision_layer = p_layer; }
+    bool get_quit_when_done() const { return quit_when_done; }
+    void set_quit_when_done(bool p_enable) { quit_when_done = p_enable; }
+};
+
+}
+
+#endif // HURTBOX_BENCHMARK_H
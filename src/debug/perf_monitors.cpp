@@ -0,0 +1,24 @@
+#include "perf_monitors.hpp"
+#include <godot_cpp/classes/performance.hpp>
+
+namespace godot {
+
+namespace PerfMonitors {
+
+void add(const StringName &p_id, const Callable &p_callable) {
+    Performance *performance = Performance::get_singleton();
+    if (performance && !performance->has_custom_monitor(p_id)) {
+        performance->add_custom_monitor(p_id, p_callable);
+    }
+}
+
+void remove(const StringName &p_id) {
+    Performance *performance = Performance::get_singleton();
+    if (performance && performance->has_custom_monitor(p_id)) {
+        performance->remove_custom_monitor(p_id);
+    }
+}
+
+} // namespace PerfMonitors
+
+}
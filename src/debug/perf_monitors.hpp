@@ -0,0 +1,22 @@
+#ifndef PERF_MONITORS_H
+#define PERF_MONITORS_H
+
+#include <godot_cpp/variant/callable.hpp>
+#include <godot_cpp/variant/string_name.hpp>
+
+namespace godot {
+
+// Thin wrappers around Performance custom monitors. Ids are "Category/Name";
+// the values show up in the debugger's Monitors tab and can be polled from
+// headless runs with Performance.get_custom_monitor(id).
+namespace PerfMonitors {
+
+// No-op when p_id is already registered, e.g. by another instance
+void add(const StringName &p_id, const Callable &p_callable);
+void remove(const StringName &p_id);
+
+} // namespace PerfMonitors
+
+}
+
+#endif // PERF_MONITORS_H
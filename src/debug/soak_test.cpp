@@ -0,0 +1,260 @@
+#include "soak_test.hpp"
+#include "../bots/bot_crowd.hpp"
+#include "../combat/damage_system.hpp"
+#include "../combat/health.hpp"
+#include "../player.hpp"
+#include "../weapons/guns/pistol.hpp"
+#include "../weapons/guns/rifle.hpp"
+#include "../weapons/projectile_manager.hpp"
+#include <godot_cpp/classes/camera3d.hpp>
+#include <godot_cpp/classes/capsule_shape3d.hpp>
+#include <godot_cpp/classes/collision_shape3d.hpp>
+#include <godot_cpp/classes/engine.hpp>
+#include <godot_cpp/classes/os.hpp>
+#include <godot_cpp/classes/performance.hpp>
+#include <godot_cpp/classes/project_settings.hpp>
+#include <godot_cpp/classes/scene_tree.hpp>
+#include <godot_cpp/classes/time.hpp>
+#include <godot_cpp/variant/utility_functions.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+using namespace godot;
+
+static const char *ARG_PREFIX = "--soak-";
+
+static const char *CSV_HEADER = "frame,time_s,frame_ms,process_ms,physics_ms,"
+        "projectile_update_us,projectile_collision_us,bot_update_us,"
+        "projectiles,bot_shots,damage_events,static_memory_bytes,objects";
+
+void SoakTest::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("get_duration"), &SoakTest::get_duration);
+    ClassDB::bind_method(D_METHOD("set_duration", "seconds"), &SoakTest::set_duration);
+    ClassDB::bind_method(D_METHOD("get_warmup"), &SoakTest::get_warmup);
+    ClassDB::bind_method(D_METHOD("set_warmup", "seconds"), &SoakTest::set_warmup);
+    ClassDB::bind_method(D_METHOD("get_player_count"), &SoakTest::get_player_count);
+    ClassDB::bind_method(D_METHOD("set_player_count", "count"), &SoakTest::set_player_count);
+    ClassDB::bind_method(D_METHOD("get_bot_count"), &SoakTest::get_bot_count);
+    ClassDB::bind_method(D_METHOD("set_bot_count", "count"), &SoakTest::set_bot_count);
+    ClassDB::bind_method(D_METHOD("get_max_fps"), &SoakTest::get_max_fps);
+    ClassDB::bind_method(D_METHOD("set_max_fps", "fps"), &SoakTest::set_max_fps);
+    ClassDB::bind_method(D_METHOD("get_max_p99_ms"), &SoakTest::get_max_p99_ms);
+    ClassDB::bind_method(D_METHOD("set_max_p99_ms", "ms"), &SoakTest::set_max_p99_ms);
+    ClassDB::bind_method(D_METHOD("get_csv_path"), &SoakTest::get_csv_path);
+    ClassDB::bind_method(D_METHOD("set_csv_path", "path"), &SoakTest::set_csv_path);
+    ClassDB::bind_method(D_METHOD("get_arena_half_extents"), &SoakTest::get_arena_half_extents);
+    ClassDB::bind_method(D_METHOD("set_arena_half_extents", "extents"), &SoakTest::set_arena_half_extents);
+
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "duration", PROPERTY_HINT_RANGE, "0,3600,1,or_greater,suffix:s"), "set_duration", "get_duration");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "warmup", PROPERTY_HINT_RANGE, "0,60,0.5,suffix:s"), "set_warmup", "get_warmup");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "player_count", PROPERTY_HINT_RANGE, "0,64,1,or_greater"), "set_player_count", "get_player_count");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "bot_count", PROPERTY_HINT_RANGE, "0,4096,1,or_greater"), "set_bot_count", "get_bot_count");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "max_fps", PROPERTY_HINT_RANGE, "0,1000,1"), "set_max_fps", "get_max_fps");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "max_p99_ms", PROPERTY_HINT_RANGE, "0,1000,0.1,suffix:ms"), "set_max_p99_ms", "get_max_p99_ms");
+    ADD_PROPERTY(PropertyInfo(Variant::STRING, "csv_path", PROPERTY_HINT_SAVE_FILE, "*.csv"), "set_csv_path", "get_csv_path");
+    ADD_PROPERTY(PropertyInfo(Variant::VECTOR2, "arena_half_extents", PROPERTY_HINT_NONE, "suffix:m"), "set_arena_half_extents", "get_arena_half_extents");
+}
+
+void SoakTest::apply_command_line() {
+    PackedStringArray args = OS::get_singleton()->get_cmdline_user_args();
+    for (int i = 0; i < args.size(); i++) {
+        String arg = args[i];
+        if (!arg.begins_with(ARG_PREFIX) || arg.find("=") < 0) {
+            continue;
+        }
+        String key = arg.get_slice("=", 0).substr(strlen(ARG_PREFIX));
+        String value = arg.get_slice("=", 1);
+
+        if (key == "duration") {
+            set_duration(value.to_float());
+        } else if (key == "warmup") {
+            set_warmup(value.to_float());
+        } else if (key == "players") {
+            set_player_count(value.to_int());
+        } else if (key == "bots") {
+            set_bot_count(value.to_int());
+        } else if (key == "fps") {
+            set_max_fps(value.to_int());
+        } else if (key == "max-p99-ms") {
+            set_max_p99_ms(value.to_float());
+        } else if (key == "csv") {
+            set_csv_path(value);
+        } else {
+            WARN_PRINT("SoakTest: Unknown option " + arg);
+        }
+    }
+}
+
+void SoakTest::_ready() {
+    if (Engine::get_singleton()->is_editor_hint()) {
+        return;
+    }
+    apply_command_line();
+    if (max_fps > 0) {
+        Engine::get_singleton()->set_max_fps(max_fps);
+    }
+
+    csv = FileAccess::open(csv_path, FileAccess::WRITE);
+    if (csv.is_valid()) {
+        csv->store_line(CSV_HEADER);
+    } else {
+        ERR_PRINT("SoakTest: Cannot write " + csv_path + ", running without a CSV.");
+    }
+
+    spawn_players();
+    if (bot_count > 0) {
+        crowd = memnew(BotCrowd);
+        crowd->set_name("Bots");
+        crowd->set_bot_count(bot_count);
+        crowd->set_arena_half_extents(arena_half_extents);
+        add_child(crowd);
+    }
+
+    UtilityFunctions::print("SoakTest: ", player_count, " players, ", bot_count, " bots for ", duration, " s, p99 limit ", max_p99_ms, " ms");
+    frame_ms.reserve((size_t)(duration * 240.0));
+    start_usec = Time::get_singleton()->get_ticks_usec();
+    last_frame_usec = start_usec;
+}
+
+void SoakTest::spawn_players() {
+    Ref<CapsuleShape3D> capsule;
+    capsule.instantiate();
+    capsule->set_radius(0.4);
+    capsule->set_height(1.8);
+    float ring = MIN(arena_half_extents.x, arena_half_extents.y) * 0.5f;
+
+    for (int i = 0; i < player_count; i++) {
+        float angle = Math_TAU * i / MAX(player_count, 1);
+        Player *player = memnew(Player);
+        player->set_name(vformat("Player%d", i));
+        player->set_position(Vector3(std::sin(angle) * ring, 1.0, std::cos(angle) * ring));
+
+        // Shape and hurtbox both start at the feet
+        CollisionShape3D *shape = memnew(CollisionShape3D);
+        shape->set_shape(capsule);
+        shape->set_position(Vector3(0, 0.9, 0));
+        player->add_child(shape);
+        player->add_child(memnew(Health));
+
+        // The rig Player would otherwise create, with one weapon
+        ScriptedPlayer scripted;
+        scripted.player = player;
+        scripted.rifle = i % 2 == 1;
+        scripted.phase = i * 0.37f;
+        Camera3D *camera = memnew(Camera3D);
+        camera->set_name("Camera3D");
+        player->add_child(camera);
+        WeaponManager *weapon_manager = memnew(WeaponManager);
+        weapon_manager->set_name("WeaponManager");
+        camera->add_child(weapon_manager);
+        weapon_manager->add_child(scripted.rifle ? (Weapon *)memnew(Rifle) : (Weapon *)memnew(Pistol));
+        add_child(player);
+
+        // Start facing the middle of the arena
+        double yaw = angle;
+        player->feed_look(Vector2(-yaw / (player->get_camera_sensitivity() * 0.01), 0.0));
+        players.push_back(scripted);
+    }
+}
+
+void SoakTest::drive_player(ScriptedPlayer &r_scripted, double p_time, double p_delta) {
+    Player *player = r_scripted.player;
+    double t = p_time + r_scripted.phase;
+
+    // Walk for four seconds out of six, strafing left and right
+    bool walking = std::fmod(t, 6.0) < 4.0;
+    bool strafe_left = std::fmod(t, 3.0) < 1.5;
+    player->feed_action(Player::INPUT_FORWARD, walking);
+    player->feed_action(Player::INPUT_LEFT, walking && strafe_left);
+    player->feed_action(Player::INPUT_RIGHT, walking && !strafe_left);
+    player->feed_action(Player::INPUT_JUMP, std::fmod(t, 5.0) < 0.1);
+
+    // Slow sweeps, in mouse pixels
+    player->feed_look(Vector2(120.0 * std::sin(t * 0.8) * p_delta, 30.0 * std::cos(t * 0.6) * p_delta));
+
+    // Pistols tap, rifles fire bursts
+    bool trigger = r_scripted.rifle ? std::fmod(t, 1.5) < 0.8 : std::fmod(t, 0.3) < 0.15;
+    player->feed_action(Player::INPUT_FIRE, trigger);
+}
+
+void SoakTest::_process(double delta) {
+    if (Engine::get_singleton()->is_editor_hint() || finished) {
+        return;
+    }
+    uint64_t now = Time::get_singleton()->get_ticks_usec();
+    double elapsed_ms = (now - last_frame_usec) / 1000.0;
+    double time = (now - start_usec) / 1000000.0;
+    last_frame_usec = now;
+
+    for (ScriptedPlayer &scripted : players) {
+        drive_player(scripted, time, delta);
+    }
+
+    write_row(time, elapsed_ms);
+    if (time >= warmup) {
+        frame_ms.push_back(elapsed_ms);
+    }
+    frame++;
+
+    if (time >= duration) {
+        finish();
+    }
+}
+
+void SoakTest::write_row(double p_time, double p_frame_ms) {
+    if (csv.is_null()) {
+        return;
+    }
+    Performance *performance = Performance::get_singleton();
+    ProjectileManager *projectile_manager = ProjectileManager::get_singleton();
+    DamageSystem *damage_system = DamageSystem::get_singleton();
+
+    csv->store_line(vformat("%d,%.4f,%.3f,%.3f,%.3f,%d,%d,%d,%d,%d,%d,%d,%d",
+            (int64_t)frame, p_time, p_frame_ms,
+            performance->get_monitor(Performance::TIME_PROCESS) * 1000.0,
+            performance->get_monitor(Performance::TIME_PHYSICS_PROCESS) * 1000.0,
+            projectile_manager ? projectile_manager->get_update_usec_last_tick() : 0,
+            projectile_manager ? projectile_manager->get_collision_usec_last_tick() : 0,
+            crowd ? crowd->get_update_usec_last_tick() : 0,
+            projectile_manager ? projectile_manager->get_active_projectile_count() : 0,
+            crowd ? crowd->get_shots_last_tick() : 0,
+            damage_system ? damage_system->get_events_last_flush() : 0,
+            (int64_t)performance->get_monitor(Performance::MEMORY_STATIC),
+            (int64_t)performance->get_monitor(Performance::OBJECT_COUNT)));
+}
+
+void SoakTest::finish() {
+    finished = true;
+    if (csv.is_valid()) {
+        csv->close();
+        csv.unref();
+    }
+
+    if (frame_ms.empty()) {
+        ERR_PRINT("SoakTest: No frames after the warmup, nothing to report.");
+        get_tree()->quit(1);
+        return;
+    }
+
+    std::vector<float> sorted = frame_ms;
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&](double p_fraction) {
+        size_t rank = (size_t)std::ceil(p_fraction * sorted.size());
+        return sorted[MIN(MAX(rank, (size_t)1), sorted.size()) - 1];
+    };
+    double mean = 0.0;
+    for (float ms : sorted) {
+        mean += ms;
+    }
+    mean /= sorted.size();
+
+    float p99 = percentile(0.99);
+    bool passed = p99 <= max_p99_ms;
+    UtilityFunctions::print(vformat("SoakTest: %d frames, mean %.2f ms, p50 %.2f ms, p99 %.2f ms, max %.2f ms",
+            (int64_t)sorted.size(), mean, percentile(0.5), p99, sorted.back()));
+    UtilityFunctions::print(vformat("SoakTest: %s, p99 limit %.2f ms, CSV at %s",
+            passed ? "PASS" : "FAIL", max_p99_ms, ProjectSettings::get_singleton()->globalize_path(csv_path)));
+    get_tree()->quit(passed ? 0 : 1);
+}
@@ -0,0 +1,93 @@
+#ifndef SOAK_TEST_H
+#define SOAK_TEST_H
+
+#include <godot_cpp/classes/file_access.hpp>
+#include <godot_cpp/classes/node3d.hpp>
+#include <godot_cpp/core/class_db.hpp>
+
+#include <vector>
+
+namespace godot {
+
+class BotCrowd;
+class Player;
+
+// Repeatable end-to-end performance run, meant for `godot --headless`.
+//
+// On entering the tree it spawns player_count Players, alternating pistols
+// and rifles, plus a BotCrowd of bot_count bots. The players move, look and
+// fire on fixed scripted patterns through Player.feed_look/feed_action, so
+// every run does the same work. Each frame appends a CSV row with the frame
+// time, engine process and physics times, the extension's own subsystem
+// timings and memory use. After duration seconds the run prints a summary
+// and quits, with exit code 1 if the p99 frame time after the warmup
+// exceeded max_p99_ms.
+//
+// Every property can be overridden from the command line after `--`, e.g.
+// `-- --soak-duration=120 --soak-bots=2000 --soak-csv=user://run.csv`.
+class SoakTest : public Node3D {
+    GDCLASS(SoakTest, Node3D)
+
+private:
+    struct ScriptedPlayer {
+        Player *player = nullptr;
+        bool rifle = false;
+        float phase = 0.0f; // Seconds, keeps the players out of step
+    };
+
+    // Settings
+    double duration = 30.0;
+    double warmup = 2.0; // Seconds not counted towards the percentiles
+    int player_count = 8;
+    int bot_count = 500;
+    int max_fps = 0; // 0 leaves the frame rate uncapped
+    double max_p99_ms = 33.3;
+    String csv_path = "user://soak.csv";
+    Vector2 arena_half_extents = Vector2(30.0, 30.0);
+
+    // Run state
+    std::vector<ScriptedPlayer> players;
+    BotCrowd *crowd = nullptr;
+    Ref<FileAccess> csv;
+    std::vector<float> frame_ms; // After the warmup, for the percentiles
+    uint64_t start_usec = 0;
+    uint64_t last_frame_usec = 0;
+    uint64_t frame = 0;
+    bool finished = false;
+
+    void apply_command_line();
+    void spawn_players();
+    void drive_player(ScriptedPlayer &r_scripted, double p_time, double p_delta);
+    void write_row(double p_time, double p_frame_ms);
+    void finish();
+
+public:
+    SoakTest() {}
+    ~SoakTest() {}
+
+    static void _bind_methods();
+
+    void _ready() override;
+    void _process(double delta) override;
+
+    double get_duration() const { return duration; }
+    void set_duration(double p_seconds) { duration = MAX(p_seconds, 0.0); }
+    double get_warmup() const { return warmup; }
+    void set_warmup(double p_seconds) { warmup = MAX(p_seconds, 0.0); }
+    int get_player_count() const { return player_count; }
+    void set_player_count(int p_count) { player_count = MAX(p_count, 0); }
+    int get_bot_count() const { return bot_count; }
+    void set_bot_count(int p_count) { bot_count = MAX(p_count, 0); }
+    int get_max_fps() const { return max_fps; }
+    void set_max_fps(int p_fps) { max_fps = MAX(p_fps, 0); }
+    double get_max_p99_ms() const { return max_p99_ms; }
+    void set_max_p99_ms(double p_ms) { max_p99_ms = MAX(p_ms, 0.0); }
+    String get_csv_path() const { return csv_path; }
+    void set_csv_path(const String &p_path) { csv_path = p_path; }
+    Vector2 get_arena_half_extents() const { return arena_half_extents; }
+    void set_arena_half_extents(const Vector2 &p_extents) { arena_half_extents = p_extents.abs(); }
+};
+
+}
+
+#endif // SOAK_TEST_H
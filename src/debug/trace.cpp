@@ -0,0 +1,136 @@
+#include "trace.hpp"
+#include "../weapons/projectile_queues.hpp"
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace godot {
+
+namespace Trace {
+
+// One ring per recording thread; the owner is its only producer
+struct ThreadRing {
+    SPMCRing<Event> events;
+    uint32_t thread_index = 0;
+    std::atomic<uint64_t> cleared_before{ 0 }; // Events before this position were dropped by clear()
+};
+
+static std::mutex registry_mutex;
+static std::vector<std::unique_ptr<ThreadRing>> registry;
+static thread_local ThreadRing *thread_ring = nullptr;
+
+static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+static ThreadRing *get_thread_ring() {
+    if (!thread_ring) {
+        std::unique_ptr<ThreadRing> ring(new ThreadRing);
+        ring->events.reset(TRACE_RING_CAPACITY);
+
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        ring->thread_index = registry.size();
+        thread_ring = ring.get();
+        registry.push_back(std::move(ring));
+    }
+    return thread_ring;
+}
+
+bool is_enabled() {
+#ifdef GODOTCON_TRACE
+    return true;
+#else
+    return false;
+#endif
+}
+
+uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void record(EventType p_type, const char *p_name, uint64_t p_timestamp_ns, int64_t p_value) {
+    Event event;
+    event.name = p_name;
+    event.timestamp_ns = p_timestamp_ns;
+    event.value = p_value;
+    event.type = p_type;
+    get_thread_ring()->events.publish(event);
+}
+
+static void append_escaped(std::string &r_json, const char *p_text) {
+    for (const char *c = p_text; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            r_json += '\\';
+        }
+        r_json += *c;
+    }
+}
+
+void write_chrome_json(std::string &r_json) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+
+    r_json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    char buffer[160];
+
+    for (const std::unique_ptr<ThreadRing> &ring : registry) {
+        uint32_t tid = ring->thread_index + 1;
+        std::snprintf(buffer, sizeof(buffer), "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}", first ? "" : ",", tid, ring->thread_index);
+        r_json += buffer;
+        first = false;
+
+        // Start at the oldest event still in the ring, or at the last clear()
+        SPMCRing<Event>::Reader reader;
+        uint64_t published = ring->events.get_published_count();
+        uint64_t oldest = published > TRACE_RING_CAPACITY ? published - TRACE_RING_CAPACITY : 0;
+        uint64_t cleared = ring->cleared_before.load(std::memory_order_relaxed);
+        reader.cursor = oldest > cleared ? oldest : cleared;
+
+        Event event;
+        while (ring->events.read(reader, event)) {
+            double ts = event.timestamp_ns / 1000.0;
+            r_json += ",{\"name\":\"";
+            append_escaped(r_json, event.name);
+            switch (event.type) {
+                case EVENT_SCOPE:
+                    std::snprintf(buffer, sizeof(buffer), "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", tid, ts, event.value / 1000.0);
+                    break;
+                case EVENT_COUNTER:
+                    std::snprintf(buffer, sizeof(buffer), "\",\"ph\":\"C\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"args\":{\"value\":%" PRId64 "}}", tid, ts, event.value);
+                    break;
+                case EVENT_INSTANT:
+                    std::snprintf(buffer, sizeof(buffer), "\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%u,\"ts\":%.3f}", tid, ts);
+                    break;
+            }
+            r_json += buffer;
+        }
+    }
+
+    r_json += "]}\n";
+}
+
+bool write_chrome_json_file(const char *p_path) {
+    std::string json;
+    write_chrome_json(json);
+
+    FILE *file = std::fopen(p_path, "wb");
+    if (!file) {
+        return false;
+    }
+    bool ok = std::fwrite(json.data(), 1, json.size(), file) == json.size();
+    ok = std::fclose(file) == 0 && ok;
+    return ok;
+}
+
+void clear() {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (const std::unique_ptr<ThreadRing> &ring : registry) {
+        ring->cleared_before.store(ring->events.get_published_count(), std::memory_order_relaxed);
+    }
+}
+
+} // namespace Trace
+
+}
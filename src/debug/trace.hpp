@@ -0,0 +1,73 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+#include <string>
+
+// Scoped timing, counter and instant-event tracing, exported as Chrome trace
+// JSON. Compiled in only with GODOTCON_TRACE (`scons trace=yes` or
+// -DGODOTCON_TRACE=ON); otherwise the macros expand to nothing. Each thread
+// records into its own lock-free ring. Names must outlive the trace.
+
+namespace godot {
+
+namespace Trace {
+
+static constexpr uint32_t TRACE_RING_CAPACITY = 1 << 14;
+
+enum EventType : uint8_t {
+    EVENT_SCOPE,
+    EVENT_COUNTER,
+    EVENT_INSTANT,
+};
+
+struct Event {
+    const char *name;
+    uint64_t timestamp_ns;
+    int64_t value; // Duration in ns for scopes, the sample for counters
+    EventType type;
+};
+
+bool is_enabled();
+uint64_t now_ns();
+void record(EventType p_type, const char *p_name, uint64_t p_timestamp_ns, int64_t p_value);
+
+// Chrome trace JSON of every ring. Threads may keep recording meanwhile; the
+// events they write during the export may or may not be included.
+void write_chrome_json(std::string &r_json);
+bool write_chrome_json_file(const char *p_path);
+
+// Drops recorded events, keeping the rings
+void clear();
+
+class Scope {
+    const char *name;
+    uint64_t start;
+
+public:
+    explicit Scope(const char *p_name) :
+            name(p_name), start(now_ns()) {}
+    ~Scope() { record(EVENT_SCOPE, name, start, (int64_t)(now_ns() - start)); }
+};
+
+} // namespace Trace
+
+}
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#ifdef GODOTCON_TRACE
+#define TRACE_SCOPE(m_name) ::godot::Trace::Scope TRACE_CONCAT(_trace_scope_, __LINE__)(m_name)
+#define TRACE_COUNTER(m_name, m_value) ::godot::Trace::record(::godot::Trace::EVENT_COUNTER, m_name, ::godot::Trace::now_ns(), (int64_t)(m_value))
+#define TRACE_INSTANT(m_name) ::godot::Trace::record(::godot::Trace::EVENT_INSTANT, m_name, ::godot::Trace::now_ns(), 0)
+// Diagnostic output that only profiling builds print; the caller includes utility_functions.hpp
+#define TRACE_PRINT(...) ::godot::UtilityFunctions::print(__VA_ARGS__)
+#else
+#define TRACE_SCOPE(m_name) ((void)0)
+#define TRACE_COUNTER(m_name, m_value) ((void)0)
+#define TRACE_INSTANT(m_name) ((void)0)
+#define TRACE_PRINT(...) ((void)0)
+#endif
+
+#endif // TRACE_H
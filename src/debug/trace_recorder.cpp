@@ -0,0 +1,30 @@
+#include "trace_recorder.hpp"
+#include "trace.hpp"
+#include <godot_cpp/classes/project_settings.hpp>
+#include <godot_cpp/core/class_db.hpp>
+
+using namespace godot;
+
+void TraceRecorder::_bind_methods() {
+    ClassDB::bind_static_method("TraceRecorder", D_METHOD("is_enabled"), &TraceRecorder::is_enabled);
+    ClassDB::bind_static_method("TraceRecorder", D_METHOD("dump", "path"), &TraceRecorder::dump);
+    ClassDB::bind_static_method("TraceRecorder", D_METHOD("clear"), &TraceRecorder::clear);
+}
+
+bool TraceRecorder::is_enabled() {
+    return Trace::is_enabled();
+}
+
+Error TraceRecorder::dump(const String &path) {
+    ERR_FAIL_COND_V_MSG(!Trace::is_enabled(), ERR_UNAVAILABLE, "TraceRecorder: Tracing is compiled out, rebuild with trace=yes.");
+
+    String file_path = ProjectSettings::get_singleton()->globalize_path(path);
+    if (!Trace::write_chrome_json_file(file_path.utf8().get_data())) {
+        ERR_FAIL_V_MSG(ERR_FILE_CANT_WRITE, "TraceRecorder: Could not write " + file_path);
+    }
+    return OK;
+}
+
+void TraceRecorder::clear() {
+    Trace::clear();
+}
@@ -0,0 +1,24 @@
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include <godot_cpp/classes/object.hpp>
+#include <godot_cpp/core/class_db.hpp>
+
+namespace godot {
+
+// Script access to the trace rings, e.g. TraceRecorder.dump("user://trace.json").
+// Only profiling builds (GODOTCON_TRACE) record anything.
+class TraceRecorder : public Object {
+    GDCLASS(TraceRecorder, Object)
+
+public:
+    static void _bind_methods();
+
+    static bool is_enabled();
+    static Error dump(const String &path);
+    static void clear();
+};
+
+}
+
+#endif // TRACE_RECORDER_H
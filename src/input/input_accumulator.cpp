@@ -0,0 +1,54 @@
+#include "input_accumulator.hpp"
+
+using namespace godot;
+
+// Scheduled times must stay strictly inside the tick
+static const double LAST_TICK_FRACTION = 1.0 - 1e-6;
+
+void InputAccumulator::add_look(float p_x, float p_y) {
+    look[0] += p_x;
+    look[1] += p_y;
+    look_events++;
+}
+
+uint32_t InputAccumulator::take_look(float r_look[2]) {
+    uint32_t events = look_events;
+    r_look[0] = look[0];
+    r_look[1] = look[1];
+    look[0] = 0.0f;
+    look[1] = 0.0f;
+    look_events = 0;
+    return events;
+}
+
+bool InputAccumulator::set_action(Action p_action, bool p_pressed, uint64_t p_time_usec) {
+    uint32_t bit = 1u << p_action;
+    if (((held & bit) != 0) == p_pressed) {
+        return false;
+    }
+
+    if (p_pressed) {
+        held |= bit;
+        latched |= bit;
+    } else {
+        held &= ~bit;
+    }
+    transition_usec[p_action] = p_time_usec;
+    return true;
+}
+
+void InputAccumulator::begin_tick(uint64_t p_now_usec, uint64_t p_interval_usec) {
+    tick_usec = p_now_usec;
+    tick_interval_usec = p_interval_usec;
+    latched = 0;
+}
+
+double InputAccumulator::get_tick_offset(uint64_t p_time_usec, double p_delta) const {
+    if (tick_interval_usec == 0 || p_time_usec <= tick_usec) {
+        return 0.0;
+    }
+
+    // Input arriving late, e.g. after a hitch, still lands inside the tick
+    double fraction = (double)(p_time_usec - tick_usec) / (double)tick_interval_usec;
+    return (fraction < LAST_TICK_FRACTION ? fraction : LAST_TICK_FRACTION) * p_delta;
+}
@@ -0,0 +1,57 @@
+#ifndef INPUT_ACCUMULATOR_H
+#define INPUT_ACCUMULATOR_H
+
+#include <cstdint>
+
+namespace godot {
+
+// Collects raw input between the points where it is consumed. Mouse motion
+// is summed and presses are latched until the next physics tick, so taps
+// shorter than a tick are not lost. Times are in microseconds.
+class InputAccumulator {
+public:
+    enum Action {
+        ACTION_FORWARD,
+        ACTION_BACK,
+        ACTION_LEFT,
+        ACTION_RIGHT,
+        ACTION_JUMP,
+        ACTION_FIRE,
+        ACTION_MAX,
+    };
+
+private:
+    float look[2] = { 0.0f, 0.0f };
+    uint32_t look_events = 0; // Motion events summed into look
+
+    uint32_t held = 0; // Bit per Action
+    uint32_t latched = 0; // Pressed since the last tick began
+    uint64_t transition_usec[ACTION_MAX] = {};
+
+    uint64_t tick_usec = 0; // When the last physics tick began
+    uint64_t tick_interval_usec = 0;
+
+public:
+    void add_look(float p_x, float p_y);
+    // Sum of the motion since the last call, returns the number of events in it
+    uint32_t take_look(float r_look[2]);
+    uint32_t get_pending_look_events() const { return look_events; }
+
+    // Returns false when the state doesn't change, e.g. for key echoes
+    bool set_action(Action p_action, bool p_pressed, uint64_t p_time_usec);
+    bool is_held(Action p_action) const { return held & (1u << p_action); }
+    // Held now or pressed at any point since the tick began
+    bool was_pressed(Action p_action) const { return (held | latched) & (1u << p_action); }
+    uint64_t get_transition_time(Action p_action) const { return transition_usec[p_action]; }
+
+    // Marks the start of a physics tick and drops the press latches
+    void begin_tick(uint64_t p_now_usec, uint64_t p_interval_usec);
+    // Seconds into the coming tick of length p_delta at which an input at
+    // p_time_usec happened. The tick simulates the interval since the last
+    // one began, so the offset is the fraction of that interval elapsed.
+    double get_tick_offset(uint64_t p_time_usec, double p_delta) const;
+};
+
+}
+
+#endif // INPUT_ACCUMULATOR_H
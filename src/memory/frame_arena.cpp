@@ -0,0 +1,143 @@
+#include "frame_arena.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+using namespace godot;
+
+FrameArena &FrameArena::get_thread_arena() {
+    static thread_local FrameArena arena;
+    return arena;
+}
+
+FrameArena::FrameArena(size_t p_block_size) :
+        block_size(std::max<size_t>(p_block_size, 256)) {}
+
+FrameArena::~FrameArena() {
+    free_blocks();
+}
+
+void FrameArena::free_blocks() {
+    for (const Block &block : blocks) {
+        std::free(block.data);
+    }
+    blocks.clear();
+    current = 0;
+    offset = 0;
+}
+
+bool FrameArena::fits(uint32_t p_block, size_t p_offset, size_t p_size, size_t p_align, size_t &r_start) const {
+    const Block &block = blocks[p_block];
+    uintptr_t base = (uintptr_t)block.data;
+    uintptr_t aligned = (base + p_offset + p_align - 1) & ~(uintptr_t)(p_align - 1);
+    r_start = aligned - base;
+    return r_start + p_size <= block.size;
+}
+
+void *FrameArena::allocate(size_t p_size, size_t p_align) {
+    if (p_size == 0) {
+        p_size = 1;
+    }
+
+    size_t start = 0;
+    if (blocks.empty() || !fits(current, offset, p_size, p_align, start)) {
+        // Waste the tail of the current block; spare blocks from earlier ticks go first
+        if (!blocks.empty()) {
+            used += blocks[current].size - offset;
+        }
+        uint32_t next = blocks.empty() ? 0 : current + 1;
+        while (next < blocks.size() && !fits(next, 0, p_size, p_align, start)) {
+            next++;
+        }
+        if (next >= blocks.size()) {
+            size_t size = std::max(block_size, p_size + p_align);
+            uint8_t *data = (uint8_t *)std::malloc(size);
+            if (!data) {
+                // The extension builds without exceptions, and callers cannot handle null
+                std::abort();
+            }
+            block_allocations++;
+            block_allocations_total++;
+            blocks.push_back({ data, size });
+            next = blocks.size() - 1;
+            fits(next, 0, p_size, p_align, start);
+        }
+        current = next;
+        offset = 0;
+    }
+
+    used += start - offset + p_size;
+    offset = start + p_size;
+    peak = std::max(peak, used);
+    return blocks[current].data + start;
+}
+
+void FrameArena::deallocate(void *p_ptr, size_t p_size) {
+    if (!p_ptr) {
+        return;
+    }
+    if (poison) {
+        memset(p_ptr, POISON_BYTE, p_size);
+    }
+
+    // The newest allocation can be handed back, e.g. a vector's buffer it just outgrew
+    if (!blocks.empty() && (uint8_t *)p_ptr + p_size == blocks[current].data + offset) {
+        offset -= p_size;
+        used -= p_size;
+    }
+}
+
+void FrameArena::rewind(const Mark &p_mark) {
+    if (blocks.empty()) {
+        return;
+    }
+    if (poison) {
+        for (uint32_t i = p_mark.block; i <= current; i++) {
+            size_t from = i == p_mark.block ? p_mark.offset : 0;
+            size_t to = i == current ? offset : blocks[i].size;
+            memset(blocks[i].data + from, POISON_BYTE, to - from);
+        }
+    }
+    current = p_mark.block;
+    offset = p_mark.offset;
+    used = p_mark.used;
+}
+
+void FrameArena::reset() {
+    if (poison) {
+        for (uint32_t i = 0; i <= current && i < blocks.size(); i++) {
+            memset(blocks[i].data, POISON_BYTE, i == current ? offset : blocks[i].size);
+        }
+    }
+
+    // A tick that spilled into several blocks gets one block big enough for all of them
+    if (blocks.size() > 1) {
+        size_t total = get_capacity();
+        free_blocks();
+        block_size = std::max(block_size, total);
+        uint8_t *data = (uint8_t *)std::malloc(block_size);
+        if (data) {
+            blocks.push_back({ data, block_size });
+            block_allocations++;
+            block_allocations_total++;
+        }
+    }
+
+    current = 0;
+    offset = 0;
+    used = 0;
+    peak_last_tick = peak;
+    high_water = std::max(high_water, peak);
+    peak = 0;
+    block_allocations_last_tick = block_allocations;
+    block_allocations = 0;
+}
+
+size_t FrameArena::get_capacity() const {
+    size_t total = 0;
+    for (const Block &block : blocks) {
+        total += block.size;
+    }
+    return total;
+}
@@ -0,0 +1,128 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace godot {
+
+// Linear allocator for data that lives at most one physics tick.
+//
+// Allocation bumps a pointer through a list of blocks; nothing is freed
+// individually except the most recent allocation, which lets a growing vector
+// reuse its old tail. reset() reclaims everything at once. When a tick needed
+// more than one block, reset() merges them into a single block of the total
+// size, so after a few warm-up ticks the arena stops touching the heap.
+//
+// Each thread has its own arena through get_thread_arena(); the thread that
+// owns it resets it. With poisoning on, freed and reset memory is filled with
+// POISON_BYTE so reads of stale scratch show up as garbage at once.
+//
+// get_mark()/rewind() give back the scratch of a single call early. Only
+// rewind when nothing allocated after the mark must outlive the call.
+class FrameArena {
+public:
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+    static constexpr uint8_t POISON_BYTE = 0xDD;
+
+    struct Mark {
+        uint32_t block;
+        size_t offset;
+        size_t used;
+    };
+
+private:
+    struct Block {
+        uint8_t *data;
+        size_t size;
+    };
+
+    std::vector<Block> blocks; // Blocks past `current` are spare
+    uint32_t current = 0;
+    size_t offset = 0; // Into blocks[current]
+    size_t block_size;
+    bool poison = false;
+
+    // Statistics, bytes include alignment padding
+    size_t used = 0;
+    size_t peak = 0;
+    size_t peak_last_tick = 0;
+    size_t high_water = 0;
+    uint32_t block_allocations = 0;
+    uint32_t block_allocations_last_tick = 0;
+    uint64_t block_allocations_total = 0;
+
+    bool fits(uint32_t p_block, size_t p_offset, size_t p_size, size_t p_align, size_t &r_start) const;
+    void free_blocks();
+
+public:
+    static FrameArena &get_thread_arena();
+
+    explicit FrameArena(size_t p_block_size = DEFAULT_BLOCK_SIZE);
+    ~FrameArena();
+    FrameArena(const FrameArena &) = delete;
+    FrameArena &operator=(const FrameArena &) = delete;
+
+    void *allocate(size_t p_size, size_t p_align);
+    void deallocate(void *p_ptr, size_t p_size);
+
+    // Ends the tick: everything allocated since the last reset is invalid
+    void reset();
+
+    Mark get_mark() const { return { current, offset, used }; }
+    void rewind(const Mark &p_mark);
+
+    bool is_poisoning() const { return poison; }
+    void set_poisoning(bool p_enable) { poison = p_enable; }
+
+    size_t get_used() const { return used; }
+    size_t get_capacity() const;
+    size_t get_peak_last_tick() const { return peak_last_tick; }
+    size_t get_high_water() const { return high_water; }
+    // Heap allocations made by the arena itself, zero in steady state
+    uint32_t get_block_allocations_last_tick() const { return block_allocations_last_tick; }
+    uint64_t get_block_allocations_total() const { return block_allocations_total; }
+};
+
+// STL allocator over the frame arena of the calling thread. It holds no
+// state, so containers can be built anywhere (scene loading may happen on
+// another thread) as long as they are grown and released on the thread that
+// resets the arena. Frame memory is reclaimed without running destructors,
+// so only trivially destructible types may live there.
+template <typename T>
+class FrameAllocator {
+public:
+    typedef T value_type;
+    typedef std::true_type is_always_equal;
+
+    FrameAllocator() {}
+    template <typename U>
+    FrameAllocator(const FrameAllocator<U> &) {}
+
+    T *allocate(size_t p_count) {
+        static_assert(std::is_trivially_destructible<T>::value, "FrameAllocator: frame memory is never destroyed element-wise.");
+        return static_cast<T *>(FrameArena::get_thread_arena().allocate(p_count * sizeof(T), alignof(T)));
+    }
+    void deallocate(T *p_ptr, size_t p_count) { FrameArena::get_thread_arena().deallocate(p_ptr, p_count * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const FrameAllocator<U> &) const { return true; }
+    template <typename U>
+    bool operator!=(const FrameAllocator<U> &) const { return false; }
+};
+
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+// Gives the storage of r_vector back before its arena is reset. Members that
+// hold frame memory across calls must do this every tick.
+template <typename T>
+void frame_release(FrameVector<T> &r_vector) {
+    FrameVector<T>().swap(r_vector);
+}
+
+}
+
+#endif // FRAME_ARENA_H
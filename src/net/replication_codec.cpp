@@ -0,0 +1,504 @@
+#include "replication_codec.hpp"
+
+#include <cmath>
+
+using namespace godot;
+
+// ================ BIT STREAMS ================
+
+void BitWriter::begin(std::vector<uint8_t> &r_buffer) {
+    buffer = &r_buffer;
+    buffer->clear();
+    scratch = 0;
+    scratch_bits = 0;
+}
+
+void BitWriter::write(uint32_t p_value, int p_bits) {
+    uint64_t mask = p_bits >= 32 ? 0xFFFFFFFFull : ((1ull << p_bits) - 1);
+    scratch |= ((uint64_t)p_value & mask) << scratch_bits;
+    scratch_bits += p_bits;
+    while (scratch_bits >= 8) {
+        buffer->push_back((uint8_t)scratch);
+        scratch >>= 8;
+        scratch_bits -= 8;
+    }
+}
+
+// Two-bit size class followed by 4, 8, 16 or 32 value bits
+void BitWriter::write_varuint(uint32_t p_value) {
+    if (p_value < (1u << 4)) {
+        write(0, 2);
+        write(p_value, 4);
+    } else if (p_value < (1u << 8)) {
+        write(1, 2);
+        write(p_value, 8);
+    } else if (p_value < (1u << 16)) {
+        write(2, 2);
+        write(p_value, 16);
+    } else {
+        write(3, 2);
+        write(p_value, 32);
+    }
+}
+
+void BitWriter::finish() {
+    if (scratch_bits > 0) {
+        buffer->push_back((uint8_t)scratch);
+    }
+    scratch = 0;
+    scratch_bits = 0;
+}
+
+void BitReader::begin(const uint8_t *p_data, size_t p_size) {
+    data = p_data;
+    size = p_size;
+    byte_pos = 0;
+    scratch = 0;
+    scratch_bits = 0;
+    overflowed = false;
+}
+
+uint32_t BitReader::read(int p_bits) {
+    while (scratch_bits < p_bits) {
+        if (byte_pos >= size) {
+            overflowed = true;
+            return 0;
+        }
+        scratch |= (uint64_t)data[byte_pos++] << scratch_bits;
+        scratch_bits += 8;
+    }
+    uint64_t mask = p_bits >= 32 ? 0xFFFFFFFFull : ((1ull << p_bits) - 1);
+    uint32_t value = (uint32_t)(scratch & mask);
+    scratch >>= p_bits;
+    scratch_bits -= p_bits;
+    return value;
+}
+
+uint32_t BitReader::read_varuint() {
+    static const int widths[4] = { 4, 8, 16, 32 };
+    return read(widths[read(2)]);
+}
+
+// ================ QUANTIZATION ================
+
+static const float POSITION_SCALE = 128.0f;
+static const float ANGLE_SCALE = 65536.0f / 6.28318530718f;
+static const int DIRECTION_BITS = 12;
+static const float DIRECTION_MAX = (float)((1 << DIRECTION_BITS) - 1);
+static const int SPEED_BITS = 14;
+static const float SPEED_SCALE = 8.0f; // 0.125 m/s steps up to 2048 m/s
+static const int RANGE_BITS = 15;
+static const float RANGE_SCALE = 4.0f; // 0.25 m steps up to 8192 m
+static const int DAMAGE_BITS = 10;
+
+static uint16_t quantize_unsigned(float p_value, float p_scale, int p_bits) {
+    float max_value = (float)((1 << p_bits) - 1);
+    float scaled = std::floor(p_value * p_scale + 0.5f);
+    return (uint16_t)(scaled < 0.0f ? 0.0f : (scaled > max_value ? max_value : scaled));
+}
+
+int32_t ReplicationQuantize::position(float p_meters) {
+    return (int32_t)std::floor(p_meters * POSITION_SCALE + 0.5f);
+}
+
+float ReplicationQuantize::position_to_meters(int32_t p_value) {
+    return p_value / POSITION_SCALE;
+}
+
+uint16_t ReplicationQuantize::angle(float p_radians) {
+    return (uint16_t)(int32_t)std::floor(p_radians * ANGLE_SCALE + 0.5f);
+}
+
+float ReplicationQuantize::angle_to_radians(uint16_t p_value) {
+    return (int16_t)p_value / ANGLE_SCALE;
+}
+
+void ReplicationQuantize::direction(const float p_direction[3], uint16_t r_octahedral[2]) {
+    float l1 = std::fabs(p_direction[0]) + std::fabs(p_direction[1]) + std::fabs(p_direction[2]);
+    float x = l1 > 0.0f ? p_direction[0] / l1 : 0.0f;
+    float y = l1 > 0.0f ? p_direction[1] / l1 : 0.0f;
+    if (p_direction[2] < 0.0f) {
+        // Fold the lower hemisphere over the diagonals
+        float fx = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float fy = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = fx;
+        y = fy;
+    }
+    r_octahedral[0] = quantize_unsigned((x + 1.0f) * 0.5f, DIRECTION_MAX, DIRECTION_BITS);
+    r_octahedral[1] = quantize_unsigned((y + 1.0f) * 0.5f, DIRECTION_MAX, DIRECTION_BITS);
+}
+
+void ReplicationQuantize::direction_to_vector(const uint16_t p_octahedral[2], float r_direction[3]) {
+    float x = p_octahedral[0] / DIRECTION_MAX * 2.0f - 1.0f;
+    float y = p_octahedral[1] / DIRECTION_MAX * 2.0f - 1.0f;
+    float z = 1.0f - std::fabs(x) - std::fabs(y);
+    if (z < 0.0f) {
+        float fx = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float fy = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = fx;
+        y = fy;
+    }
+    float length = std::sqrt(x * x + y * y + z * z);
+    r_direction[0] = x / length;
+    r_direction[1] = y / length;
+    r_direction[2] = z / length;
+}
+
+uint16_t ReplicationQuantize::speed(float p_meters_per_second) {
+    return quantize_unsigned(p_meters_per_second, SPEED_SCALE, SPEED_BITS);
+}
+
+float ReplicationQuantize::speed_to_meters_per_second(uint16_t p_value) {
+    return p_value / SPEED_SCALE;
+}
+
+uint16_t ReplicationQuantize::range(float p_meters) {
+    return quantize_unsigned(p_meters, RANGE_SCALE, RANGE_BITS);
+}
+
+float ReplicationQuantize::range_to_meters(uint16_t p_value) {
+    return p_value / RANGE_SCALE;
+}
+
+uint16_t ReplicationQuantize::damage(float p_damage) {
+    return quantize_unsigned(p_damage, 1.0f, DAMAGE_BITS);
+}
+
+float ReplicationQuantize::damage_to_float(uint16_t p_value) {
+    return (float)p_value;
+}
+
+// ================ HISTORY ================
+
+void ReplicationHistory::reset(uint32_t p_size) {
+    frames.assign(p_size > 0 ? p_size : 1, ReplicationFrame());
+    valid.assign(frames.size(), 0);
+}
+
+ReplicationFrame &ReplicationHistory::store(uint32_t p_tick) {
+    size_t slot = p_tick % frames.size();
+    valid[slot] = 1;
+    frames[slot].tick = p_tick;
+    return frames[slot];
+}
+
+const ReplicationFrame *ReplicationHistory::find(uint32_t p_tick) const {
+    size_t slot = p_tick % frames.size();
+    return valid[slot] && frames[slot].tick == p_tick ? &frames[slot] : nullptr;
+}
+
+// ================ PACKET LAYOUT ================
+
+enum PlayerField {
+    FIELD_X = 1 << 0,
+    FIELD_Y = 1 << 1,
+    FIELD_Z = 1 << 2,
+    FIELD_YAW = 1 << 3,
+    FIELD_PITCH = 1 << 4,
+    FIELD_COUNT = 5,
+};
+
+// Smallest encodings, used to reject counts a packet cannot hold before
+// anything is allocated. A varuint takes at least 6 bits.
+static const size_t MIN_PLAYER_BITS = 6 + 1; // Id and an unchanged delta
+static const size_t MIN_REMOVED_BITS = 6;
+static const size_t MIN_SPAWNED_BITS = 6 + 6 + 6 + 3 * 6 + 2 * DIRECTION_BITS + SPEED_BITS + RANGE_BITS + DAMAGE_BITS;
+
+static void write_player_full(BitWriter &r_writer, const QuantizedPlayer &p_player) {
+    r_writer.write_varint(p_player.position[0]);
+    r_writer.write_varint(p_player.position[1]);
+    r_writer.write_varint(p_player.position[2]);
+    r_writer.write(p_player.yaw, 16);
+    r_writer.write(p_player.pitch, 16);
+}
+
+static void read_player_full(BitReader &r_reader, QuantizedPlayer &r_player) {
+    r_player.position[0] = r_reader.read_varint();
+    r_player.position[1] = r_reader.read_varint();
+    r_player.position[2] = r_reader.read_varint();
+    r_player.yaw = (uint16_t)r_reader.read(16);
+    r_player.pitch = (uint16_t)r_reader.read(16);
+}
+
+static void write_player_delta(BitWriter &r_writer, const QuantizedPlayer &p_player, const QuantizedPlayer &p_base) {
+    uint32_t mask = 0;
+    mask |= p_player.position[0] != p_base.position[0] ? FIELD_X : 0;
+    mask |= p_player.position[1] != p_base.position[1] ? FIELD_Y : 0;
+    mask |= p_player.position[2] != p_base.position[2] ? FIELD_Z : 0;
+    mask |= p_player.yaw != p_base.yaw ? FIELD_YAW : 0;
+    mask |= p_player.pitch != p_base.pitch ? FIELD_PITCH : 0;
+
+    r_writer.write_bool(mask != 0);
+    if (mask == 0) {
+        return;
+    }
+    r_writer.write(mask, FIELD_COUNT);
+    for (int axis = 0; axis < 3; axis++) {
+        if (mask & (FIELD_X << axis)) {
+            r_writer.write_varint(p_player.position[axis] - p_base.position[axis]);
+        }
+    }
+    // Angles wrap, the shortest signed difference is sent
+    if (mask & FIELD_YAW) {
+        r_writer.write_varint((int16_t)(p_player.yaw - p_base.yaw));
+    }
+    if (mask & FIELD_PITCH) {
+        r_writer.write_varint((int16_t)(p_player.pitch - p_base.pitch));
+    }
+}
+
+static void read_player_delta(BitReader &r_reader, QuantizedPlayer &r_player, const QuantizedPlayer &p_base) {
+    uint32_t id = r_player.id;
+    r_player = p_base;
+    r_player.id = id;
+
+    if (!r_reader.read_bool()) {
+        return;
+    }
+    uint32_t mask = r_reader.read(FIELD_COUNT);
+    for (int axis = 0; axis < 3; axis++) {
+        if (mask & (FIELD_X << axis)) {
+            r_player.position[axis] = p_base.position[axis] + r_reader.read_varint();
+        }
+    }
+    if (mask & FIELD_YAW) {
+        r_player.yaw = (uint16_t)(p_base.yaw + r_reader.read_varint());
+    }
+    if (mask & FIELD_PITCH) {
+        r_player.pitch = (uint16_t)(p_base.pitch + r_reader.read_varint());
+    }
+}
+
+static void write_projectile(BitWriter &r_writer, const QuantizedProjectile &p_projectile, uint32_t p_tick) {
+    r_writer.write_varuint(p_tick - p_projectile.spawn_tick);
+    r_writer.write_varuint(p_projectile.shooter);
+    r_writer.write_varint(p_projectile.position[0]);
+    r_writer.write_varint(p_projectile.position[1]);
+    r_writer.write_varint(p_projectile.position[2]);
+    r_writer.write(p_projectile.direction[0], DIRECTION_BITS);
+    r_writer.write(p_projectile.direction[1], DIRECTION_BITS);
+    r_writer.write(p_projectile.speed, SPEED_BITS);
+    r_writer.write(p_projectile.range, RANGE_BITS);
+    r_writer.write(p_projectile.damage, DAMAGE_BITS);
+}
+
+static void read_projectile(BitReader &r_reader, QuantizedProjectile &r_projectile, uint32_t p_tick) {
+    r_projectile.spawn_tick = p_tick - r_reader.read_varuint();
+    r_projectile.shooter = r_reader.read_varuint();
+    r_projectile.position[0] = r_reader.read_varint();
+    r_projectile.position[1] = r_reader.read_varint();
+    r_projectile.position[2] = r_reader.read_varint();
+    r_projectile.direction[0] = (uint16_t)r_reader.read(DIRECTION_BITS);
+    r_projectile.direction[1] = (uint16_t)r_reader.read(DIRECTION_BITS);
+    r_projectile.speed = (uint16_t)r_reader.read(SPEED_BITS);
+    r_projectile.range = (uint16_t)r_reader.read(RANGE_BITS);
+    r_projectile.damage = (uint16_t)r_reader.read(DAMAGE_BITS);
+}
+
+// ================ ENCODER ================
+
+void ReplicationEncoder::reset(uint32_t p_history_size) {
+    history.reset(p_history_size);
+    has_ack = false;
+    acked_tick = 0;
+}
+
+void ReplicationEncoder::acknowledge(uint32_t p_tick) {
+    // Acks can arrive out of order, only move forward
+    if (!has_ack || (int32_t)(p_tick - acked_tick) > 0) {
+        acked_tick = p_tick;
+        has_ack = true;
+    }
+}
+
+void ReplicationEncoder::encode(const ReplicationFrame &p_frame, std::vector<uint8_t> &r_packet) {
+    const ReplicationFrame *base = has_ack ? history.find(acked_tick) : nullptr;
+    ReplicationFrame &sent = history.store(p_frame.tick);
+    sent.players = p_frame.players;
+    sent.projectiles.clear();
+
+    writer.begin(r_packet);
+    writer.write(p_frame.tick, 32);
+    writer.write_bool(base != nullptr);
+    if (base) {
+        writer.write_varuint(p_frame.tick - base->tick);
+    }
+
+    // Players, walked in id order alongside the baseline
+    writer.write_varuint(p_frame.players.size());
+    uint32_t previous_id = 0;
+    size_t b = 0;
+    for (const QuantizedPlayer &player : p_frame.players) {
+        writer.write_varuint(player.id - previous_id);
+        previous_id = player.id;
+
+        while (base && b < base->players.size() && base->players[b].id < player.id) {
+            b++;
+        }
+        if (base && b < base->players.size() && base->players[b].id == player.id) {
+            write_player_delta(writer, player, base->players[b]);
+        } else {
+            write_player_full(writer, player);
+        }
+    }
+
+    // Projectiles: ids that left since the baseline, then ids that are new
+    static const std::vector<QuantizedProjectile> empty;
+    const std::vector<QuantizedProjectile> &base_projectiles = base ? base->projectiles : empty;
+    const std::vector<QuantizedProjectile> &projectiles = p_frame.projectiles;
+
+    uint32_t removed_count = 0;
+    uint32_t spawned_count = 0;
+    size_t i = 0;
+    b = 0;
+    while (i < projectiles.size() || b < base_projectiles.size()) {
+        if (b >= base_projectiles.size() || (i < projectiles.size() && projectiles[i].id < base_projectiles[b].id)) {
+            spawned_count++;
+            i++;
+        } else if (i >= projectiles.size() || base_projectiles[b].id < projectiles[i].id) {
+            removed_count++;
+            b++;
+        } else {
+            i++;
+            b++;
+        }
+    }
+
+    writer.write_varuint(removed_count);
+    previous_id = 0;
+    i = 0;
+    for (b = 0; b < base_projectiles.size(); b++) {
+        while (i < projectiles.size() && projectiles[i].id < base_projectiles[b].id) {
+            i++;
+        }
+        if (i >= projectiles.size() || projectiles[i].id != base_projectiles[b].id) {
+            writer.write_varuint(base_projectiles[b].id - previous_id);
+            previous_id = base_projectiles[b].id;
+        }
+    }
+
+    writer.write_varuint(spawned_count);
+    previous_id = 0;
+    b = 0;
+    for (i = 0; i < projectiles.size(); i++) {
+        while (b < base_projectiles.size() && base_projectiles[b].id < projectiles[i].id) {
+            b++;
+        }
+        if (b < base_projectiles.size() && base_projectiles[b].id == projectiles[i].id) {
+            // Known to the receiver, it keeps the spawn record it already has
+            sent.projectiles.push_back(base_projectiles[b]);
+            continue;
+        }
+        writer.write_varuint(projectiles[i].id - previous_id);
+        previous_id = projectiles[i].id;
+        write_projectile(writer, projectiles[i], p_frame.tick);
+        sent.projectiles.push_back(projectiles[i]);
+    }
+
+    writer.finish();
+}
+
+// ================ DECODER ================
+
+void ReplicationDecoder::reset(uint32_t p_history_size) {
+    history.reset(p_history_size);
+    spawned.clear();
+    removed.clear();
+}
+
+bool ReplicationDecoder::decode(const uint8_t *p_packet, size_t p_size, ReplicationFrame &r_frame) {
+    BitReader reader;
+    reader.begin(p_packet, p_size);
+    spawned.clear();
+    removed.clear();
+
+    uint32_t tick = reader.read(32);
+    const ReplicationFrame *base = nullptr;
+    if (reader.read_bool()) {
+        base = history.find(tick - reader.read_varuint());
+        if (!base) {
+            return false;
+        }
+    }
+
+    uint32_t player_count = reader.read_varuint();
+    if (reader.has_overflowed() || player_count > reader.get_bits_left() / MIN_PLAYER_BITS) {
+        return false;
+    }
+
+    r_frame.tick = tick;
+    r_frame.players.resize(player_count);
+    uint32_t previous_id = 0;
+    size_t b = 0;
+    for (QuantizedPlayer &player : r_frame.players) {
+        player.id = previous_id + reader.read_varuint();
+        previous_id = player.id;
+
+        while (base && b < base->players.size() && base->players[b].id < player.id) {
+            b++;
+        }
+        if (base && b < base->players.size() && base->players[b].id == player.id) {
+            read_player_delta(reader, player, base->players[b]);
+        } else {
+            read_player_full(reader, player);
+        }
+        if (reader.has_overflowed()) {
+            return false;
+        }
+    }
+
+    uint32_t removed_count = reader.read_varuint();
+    if (reader.has_overflowed() || removed_count > reader.get_bits_left() / MIN_REMOVED_BITS) {
+        return false;
+    }
+    previous_id = 0;
+    for (uint32_t i = 0; i < removed_count && !reader.has_overflowed(); i++) {
+        previous_id += reader.read_varuint();
+        removed.push_back(previous_id);
+    }
+
+    uint32_t spawned_count = reader.read_varuint();
+    if (reader.has_overflowed() || spawned_count > reader.get_bits_left() / MIN_SPAWNED_BITS) {
+        return false;
+    }
+
+    // Merge the surviving baseline projectiles with the new ones, by id
+    static const std::vector<QuantizedProjectile> empty;
+    const std::vector<QuantizedProjectile> &base_projectiles = base ? base->projectiles : empty;
+    r_frame.projectiles.clear();
+
+    size_t r = 0;
+    b = 0;
+    previous_id = 0;
+    QuantizedProjectile incoming;
+    for (uint32_t n = 0; n <= spawned_count; n++) {
+        bool has_incoming = n < spawned_count;
+        if (has_incoming) {
+            incoming.id = previous_id + reader.read_varuint();
+            previous_id = incoming.id;
+            read_projectile(reader, incoming, tick);
+            if (reader.has_overflowed()) {
+                return false;
+            }
+        }
+
+        while (b < base_projectiles.size() && (!has_incoming || base_projectiles[b].id < incoming.id)) {
+            while (r < removed.size() && removed[r] < base_projectiles[b].id) {
+                r++;
+            }
+            if (r >= removed.size() || removed[r] != base_projectiles[b].id) {
+                r_frame.projectiles.push_back(base_projectiles[b]);
+            }
+            b++;
+        }
+        if (has_incoming) {
+            r_frame.projectiles.push_back(incoming);
+            spawned.push_back(incoming.id);
+        }
+    }
+
+    ReplicationFrame &stored = history.store(tick);
+    stored.players = r_frame.players;
+    stored.projectiles = r_frame.projectiles;
+    return true;
+}
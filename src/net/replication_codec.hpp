@@ -0,0 +1,141 @@
+#ifndef REPLICATION_CODEC_H
+#define REPLICATION_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace godot {
+
+// Bit-packed, delta-compressed snapshots of players and projectiles. Values
+// are quantized first, so both ends hold identical snapshots; projectiles are
+// sent once when they appear and then simulated by the receiver.
+
+class BitWriter {
+    std::vector<uint8_t> *buffer = nullptr;
+    uint64_t scratch = 0;
+    int scratch_bits = 0;
+
+public:
+    void begin(std::vector<uint8_t> &r_buffer);
+    void write(uint32_t p_value, int p_bits); // p_bits in [1, 32]
+    void write_bool(bool p_value) { write(p_value ? 1 : 0, 1); }
+    void write_varuint(uint32_t p_value);
+    void write_varint(int32_t p_value) { write_varuint(((uint32_t)p_value << 1) ^ (uint32_t)(p_value >> 31)); }
+    void finish(); // Flushes the partial byte
+};
+
+class BitReader {
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+    size_t byte_pos = 0;
+    uint64_t scratch = 0;
+    int scratch_bits = 0;
+    bool overflowed = false;
+
+public:
+    void begin(const uint8_t *p_data, size_t p_size);
+    uint32_t read(int p_bits);
+    bool read_bool() { return read(1) != 0; }
+    uint32_t read_varuint();
+    int32_t read_varint() {
+        uint32_t value = read_varuint();
+        return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+    }
+    bool has_overflowed() const { return overflowed; }
+    size_t get_bits_left() const { return (size - byte_pos) * 8 + scratch_bits; }
+};
+
+struct QuantizedPlayer {
+    uint32_t id = 0;
+    int32_t position[3] = { 0, 0, 0 };
+    uint16_t yaw = 0;
+    uint16_t pitch = 0;
+};
+
+struct QuantizedProjectile {
+    uint32_t id = 0;
+    uint32_t spawn_tick = 0;
+    uint32_t shooter = 0; // Player id, 0 for none
+    int32_t position[3] = { 0, 0, 0 };
+    uint16_t direction[2] = { 0, 0 }; // Octahedral encoding
+    uint16_t speed = 0;
+    uint16_t range = 0; // Remaining range at spawn_tick
+    uint16_t damage = 0;
+};
+
+// Both lists must be sorted by id
+struct ReplicationFrame {
+    uint32_t tick = 0;
+    std::vector<QuantizedPlayer> players;
+    std::vector<QuantizedProjectile> projectiles;
+};
+
+namespace ReplicationQuantize {
+// 1/128 m grid, about 8 mm
+int32_t position(float p_meters);
+float position_to_meters(int32_t p_value);
+// Full turn over 16 bits
+uint16_t angle(float p_radians);
+float angle_to_radians(uint16_t p_value);
+void direction(const float p_direction[3], uint16_t r_octahedral[2]);
+void direction_to_vector(const uint16_t p_octahedral[2], float r_direction[3]);
+uint16_t speed(float p_meters_per_second);
+float speed_to_meters_per_second(uint16_t p_value);
+uint16_t range(float p_meters);
+float range_to_meters(uint16_t p_value);
+uint16_t damage(float p_damage);
+float damage_to_float(uint16_t p_value);
+} // namespace ReplicationQuantize
+
+// Fixed ring of past frames, indexed by tick
+class ReplicationHistory {
+    std::vector<ReplicationFrame> frames;
+    std::vector<uint8_t> valid;
+
+public:
+    void reset(uint32_t p_size);
+    ReplicationFrame &store(uint32_t p_tick);
+    const ReplicationFrame *find(uint32_t p_tick) const;
+};
+
+class ReplicationEncoder {
+    ReplicationHistory history;
+    uint32_t acked_tick = 0;
+    bool has_ack = false;
+    BitWriter writer;
+
+public:
+    static constexpr uint32_t NO_BASELINE = 0xFFFFFFFFu;
+
+    void reset(uint32_t p_history_size = 64);
+
+    // Writes the packet for p_frame into r_packet. Projectile records already
+    // known to the receiver are replaced by their baseline copy in the stored
+    // frame, matching what the decoder reconstructs.
+    void encode(const ReplicationFrame &p_frame, std::vector<uint8_t> &r_packet);
+
+    // Receiver confirmed p_tick; later packets are deltas against it
+    void acknowledge(uint32_t p_tick);
+    uint32_t get_baseline_tick() const { return has_ack ? acked_tick : NO_BASELINE; }
+};
+
+class ReplicationDecoder {
+    ReplicationHistory history;
+    std::vector<uint32_t> spawned; // Projectile ids missing from the baseline, may repeat across unacknowledged packets
+    std::vector<uint32_t> removed;
+
+public:
+    void reset(uint32_t p_history_size = 64);
+
+    // Rebuilds the full frame. Fails on a truncated packet, a count the packet
+    // is too short to hold or an unknown baseline.
+    bool decode(const uint8_t *p_packet, size_t p_size, ReplicationFrame &r_frame);
+
+    const std::vector<uint32_t> &get_spawned() const { return spawned; }
+    const std::vector<uint32_t> &get_removed() const { return removed; }
+};
+
+}
+
+#endif // REPLICATION_CODEC_H
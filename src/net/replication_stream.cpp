@@ -0,0 +1,261 @@
+#include "replication_stream.hpp"
+#include "../player.hpp"
+#include "../combat/entities.hpp"
+#include "../weapons/projectile_manager.hpp"
+#include <godot_cpp/classes/scene_tree.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/core/object.hpp>
+#include <godot_cpp/variant/array.hpp>
+#include <godot_cpp/variant/packed_int32_array.hpp>
+#include <godot_cpp/variant/typed_array.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace godot;
+
+ReplicationStream::ReplicationStream() {
+    reset();
+}
+
+ReplicationStream::~ReplicationStream() {}
+
+void ReplicationStream::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("encode_tick"), &ReplicationStream::encode_tick);
+    ClassDB::bind_method(D_METHOD("acknowledge", "tick"), &ReplicationStream::acknowledge);
+    ClassDB::bind_method(D_METHOD("get_player_id", "player"), &ReplicationStream::get_player_id);
+    ClassDB::bind_method(D_METHOD("decode", "packet"), &ReplicationStream::decode);
+    ClassDB::bind_method(D_METHOD("reset"), &ReplicationStream::reset);
+    ClassDB::bind_method(D_METHOD("get_tick"), &ReplicationStream::get_tick);
+    ClassDB::bind_method(D_METHOD("get_baseline_tick"), &ReplicationStream::get_baseline_tick);
+    ClassDB::bind_method(D_METHOD("get_last_packet_size"), &ReplicationStream::get_last_packet_size);
+    ClassDB::bind_method(D_METHOD("get_history_size"), &ReplicationStream::get_history_size);
+    ClassDB::bind_method(D_METHOD("set_history_size", "size"), &ReplicationStream::set_history_size);
+
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "history_size", PROPERTY_HINT_RANGE, "2,1024,1"), "set_history_size", "get_history_size");
+}
+
+void ReplicationStream::reset() {
+    encoder.reset(history_size);
+    decoder.reset(history_size);
+    tick = 0;
+    player_ids.clear();
+    shooter_players.clear();
+    next_player_id = 1;
+    projectile_net_id.clear();
+    projectile_spawn_time.clear();
+    projectile_shooter.clear();
+    projectile_record.clear();
+    next_projectile_id = 1;
+}
+
+void ReplicationStream::set_history_size(int p_size) {
+    history_size = MAX(p_size, 2);
+    reset();
+}
+
+int ReplicationStream::get_baseline_tick() const {
+    uint32_t baseline = encoder.get_baseline_tick();
+    return baseline == ReplicationEncoder::NO_BASELINE ? -1 : (int)baseline;
+}
+
+int ReplicationStream::get_player_id(Node *p_player) {
+    ERR_FAIL_NULL_V(p_player, 0);
+    auto it = player_ids.find(p_player->get_instance_id());
+    if (it != player_ids.end()) {
+        return it->second;
+    }
+    uint32_t id = next_player_id++;
+    player_ids[p_player->get_instance_id()] = id;
+    return id;
+}
+
+uint32_t ReplicationStream::get_shooter_player(uint32_t p_shooter) {
+    if (p_shooter == EntityRegistry::INVALID_HANDLE) {
+        return 0;
+    }
+    auto it = shooter_players.find(p_shooter);
+    if (it != shooter_players.end()) {
+        return it->second;
+    }
+
+    // Weapons are owned by the player holding them
+    uint32_t player = EntityRegistry::get_singleton().find_owner_of_kind(p_shooter, EntityRegistry::KIND_PLAYER);
+    Node *node = Object::cast_to<Node>(Entities::get_object(player));
+    uint32_t id = node ? get_player_id(node) : 0;
+    shooter_players[p_shooter] = id;
+    return id;
+}
+
+void ReplicationStream::gather_players() {
+    frame.players.clear();
+    TypedArray<Node> players = get_tree()->get_nodes_in_group(Player::GROUP_NAME);
+    for (int i = 0; i < players.size(); i++) {
+        Player *player = Object::cast_to<Player>(players[i]);
+        if (!player) {
+            continue;
+        }
+
+        Vector3 position = player->get_global_position();
+        Vector2 look = player->get_look_rotation();
+        QuantizedPlayer record;
+        record.id = get_player_id(player);
+        record.position[0] = ReplicationQuantize::position(position.x);
+        record.position[1] = ReplicationQuantize::position(position.y);
+        record.position[2] = ReplicationQuantize::position(position.z);
+        record.yaw = ReplicationQuantize::angle(look.y);
+        record.pitch = ReplicationQuantize::angle(look.x);
+        frame.players.push_back(record);
+    }
+
+    std::sort(frame.players.begin(), frame.players.end(), [](const QuantizedPlayer &a, const QuantizedPlayer &b) {
+        return a.id < b.id;
+    });
+}
+
+void ReplicationStream::gather_projectiles(const ProjectileManager *p_manager) {
+    frame.projectiles.clear();
+    if (!p_manager) {
+        return;
+    }
+
+    const ProjectilePool &pool = p_manager->get_pool();
+    if (projectile_net_id.size() < pool.get_capacity()) {
+        projectile_net_id.resize(pool.get_capacity(), 0);
+        projectile_spawn_time.resize(pool.get_capacity(), 0.0);
+        projectile_shooter.resize(pool.get_capacity(), 0);
+        projectile_record.resize(pool.get_capacity());
+    }
+
+    double now = pool.get_time();
+    for (uint32_t i = 0; i < pool.get_count(); i++) {
+        uint32_t slot = pool.id[i];
+
+        // A recycled pool id belongs to a different spawn. A shooter that went
+        // away clears the handle mid-flight, which alone is not a new spawn.
+        uint32_t shooter = pool.shooter[i];
+        bool reused = projectile_net_id[slot] == 0 || pool.spawn_time[i] != projectile_spawn_time[slot] || (shooter != projectile_shooter[slot] && shooter != EntityRegistry::INVALID_HANDLE);
+        if (reused) {
+            projectile_net_id[slot] = next_projectile_id++;
+            projectile_spawn_time[slot] = pool.spawn_time[i];
+            projectile_shooter[slot] = shooter;
+
+            // Sent as where it is now and how it moves now. The flight model
+            // only depends on that, so the receiver can run it from this tick.
+            float position[3];
+            float velocity[3];
+            pool.get_position(i, now, position);
+            pool.get_velocity(i, now, velocity);
+            float speed = std::sqrt(velocity[0] * velocity[0] + velocity[1] * velocity[1] + velocity[2] * velocity[2]);
+            float direction[3] = { pool.dir_x[i], pool.dir_y[i], pool.dir_z[i] };
+            if (speed > 1e-4f) {
+                direction[0] = velocity[0] / speed;
+                direction[1] = velocity[1] / speed;
+                direction[2] = velocity[2] / speed;
+            }
+            // Range is spent at launch speed; rescale so it runs out at the same time
+            float remaining = pool.max_range[i] - pool.traveled[i];
+            if (pool.speed[i] > 0.0f) {
+                remaining *= speed / pool.speed[i];
+            }
+
+            QuantizedProjectile &record = projectile_record[slot];
+            record.id = projectile_net_id[slot];
+            record.spawn_tick = tick;
+            record.shooter = get_shooter_player(shooter);
+            record.position[0] = ReplicationQuantize::position(position[0]);
+            record.position[1] = ReplicationQuantize::position(position[1]);
+            record.position[2] = ReplicationQuantize::position(position[2]);
+            ReplicationQuantize::direction(direction, record.direction);
+            record.speed = ReplicationQuantize::speed(speed);
+            record.range = ReplicationQuantize::range(remaining);
+            record.damage = ReplicationQuantize::damage(pool.damage[i]);
+        }
+        frame.projectiles.push_back(projectile_record[slot]);
+    }
+
+    std::sort(frame.projectiles.begin(), frame.projectiles.end(), [](const QuantizedProjectile &a, const QuantizedProjectile &b) {
+        return a.id < b.id;
+    });
+}
+
+PackedByteArray ReplicationStream::encode_tick() {
+    tick++;
+    frame.tick = tick;
+    gather_players();
+    gather_projectiles(ProjectileManager::get_singleton());
+
+    encoder.encode(frame, packet);
+
+    PackedByteArray bytes;
+    bytes.resize(packet.size());
+    if (!packet.empty()) {
+        memcpy(bytes.ptrw(), packet.data(), packet.size());
+    }
+    return bytes;
+}
+
+void ReplicationStream::acknowledge(int p_tick) {
+    ERR_FAIL_COND(p_tick < 0);
+    encoder.acknowledge(p_tick);
+}
+
+Dictionary ReplicationStream::decode(const PackedByteArray &p_packet) {
+    Dictionary result;
+    bool ok = decoder.decode(p_packet.ptr(), p_packet.size(), decoded);
+    result["ok"] = ok;
+    if (!ok) {
+        return result;
+    }
+
+    result["tick"] = decoded.tick;
+
+    Array players;
+    for (const QuantizedPlayer &record : decoded.players) {
+        Dictionary player;
+        player["id"] = record.id;
+        player["position"] = Vector3(ReplicationQuantize::position_to_meters(record.position[0]),
+                ReplicationQuantize::position_to_meters(record.position[1]),
+                ReplicationQuantize::position_to_meters(record.position[2]));
+        player["look_rotation"] = Vector2(ReplicationQuantize::angle_to_radians(record.pitch), ReplicationQuantize::angle_to_radians(record.yaw));
+        players.push_back(player);
+    }
+    result["players"] = players;
+
+    // Only newly seen projectiles are reported, the client simulates the rest
+    Array spawned;
+    const std::vector<uint32_t> &spawned_ids = decoder.get_spawned();
+    size_t cursor = 0;
+    for (const QuantizedProjectile &record : decoded.projectiles) {
+        while (cursor < spawned_ids.size() && spawned_ids[cursor] < record.id) {
+            cursor++;
+        }
+        if (cursor == spawned_ids.size() || spawned_ids[cursor] != record.id) {
+            continue;
+        }
+
+        float direction[3];
+        ReplicationQuantize::direction_to_vector(record.direction, direction);
+        Dictionary projectile;
+        projectile["id"] = record.id;
+        projectile["spawn_tick"] = record.spawn_tick;
+        projectile["shooter"] = record.shooter;
+        projectile["position"] = Vector3(ReplicationQuantize::position_to_meters(record.position[0]),
+                ReplicationQuantize::position_to_meters(record.position[1]),
+                ReplicationQuantize::position_to_meters(record.position[2]));
+        projectile["direction"] = Vector3(direction[0], direction[1], direction[2]);
+        projectile["speed"] = ReplicationQuantize::speed_to_meters_per_second(record.speed);
+        projectile["range"] = ReplicationQuantize::range_to_meters(record.range);
+        projectile["damage"] = ReplicationQuantize::damage_to_float(record.damage);
+        spawned.push_back(projectile);
+    }
+    result["spawned"] = spawned;
+
+    PackedInt32Array removed;
+    for (uint32_t id : decoder.get_removed()) {
+        removed.push_back(id);
+    }
+    result["removed"] = removed;
+    return result;
+}
@@ -0,0 +1,82 @@
+#ifndef REPLICATION_STREAM_H
+#define REPLICATION_STREAM_H
+
+#include <godot_cpp/classes/node.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/core/object_id.hpp>
+#include <godot_cpp/variant/dictionary.hpp>
+#include <godot_cpp/variant/packed_byte_array.hpp>
+
+#include "replication_codec.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+namespace godot {
+
+class ProjectileManager;
+
+// Snapshot replication of players and projectiles over ReplicationEncoder.
+//
+// The server calls encode_tick() once per physics tick and sends the bytes
+// unreliably; the client feeds them to decode() and acknowledges the returned
+// tick back to the server. Players are gathered from Player::GROUP_NAME and
+// projectiles from the ProjectileManager pool. Pool ids are recycled, so
+// projectiles get their own monotonically increasing network ids.
+class ReplicationStream : public Node {
+    GDCLASS(ReplicationStream, Node)
+
+private:
+    ReplicationEncoder encoder;
+    ReplicationDecoder decoder;
+    uint32_t tick = 0;
+    int history_size = 64;
+
+    ReplicationFrame frame;
+    ReplicationFrame decoded;
+    std::vector<uint8_t> packet;
+
+    std::unordered_map<uint64_t, uint32_t> player_ids; // Player ObjectID to network id
+    std::unordered_map<uint32_t, uint32_t> shooter_players; // Shooter entity handle to owning player network id
+    uint32_t next_player_id = 1;
+
+    // Per pool id: the network id, the spawn it belongs to and the record sent
+    // for it. Flight is analytic, so a projectile is only evaluated when it is
+    // first seen and the record is reused until the pool id is recycled.
+    std::vector<uint32_t> projectile_net_id;
+    std::vector<double> projectile_spawn_time;
+    std::vector<uint32_t> projectile_shooter;
+    std::vector<QuantizedProjectile> projectile_record;
+    uint32_t next_projectile_id = 1;
+
+    void gather_players();
+    void gather_projectiles(const ProjectileManager *p_manager);
+    uint32_t get_shooter_player(uint32_t p_shooter);
+
+public:
+    ReplicationStream();
+    ~ReplicationStream();
+
+    static void _bind_methods();
+
+    // Server side
+    PackedByteArray encode_tick();
+    void acknowledge(int p_tick);
+    int get_player_id(Node *p_player);
+
+    // Client side: {ok, tick, players, spawned, removed}
+    Dictionary decode(const PackedByteArray &p_packet);
+
+    void reset();
+    int get_tick() const { return tick; }
+    int get_baseline_tick() const;
+    int get_last_packet_size() const { return packet.size(); }
+
+    // Property getters/setters
+    int get_history_size() const { return history_size; }
+    void set_history_size(int p_size);
+};
+
+}
+
+#endif // REPLICATION_STREAM_H
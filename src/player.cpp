@@ -1,12 +1,40 @@
 #include "player.hpp"
+#include "combat/entities.hpp"
+#include "combat/lag_compensation.hpp"
+#include "debug/perf_monitors.hpp"
+#include "debug/trace.hpp"
 #include <godot_cpp/classes/input.hpp>
 #include <godot_cpp/core/class_db.hpp>
 #include <godot_cpp/classes/input_event_key.hpp>
+#include <godot_cpp/classes/input_event_mouse_button.hpp>
 #include <godot_cpp/classes/input_event_mouse_motion.hpp>
 #include <godot_cpp/classes/engine.hpp>
+#include <godot_cpp/classes/time.hpp>
 
 using namespace godot;
 
+uint64_t Player::input_frame = 0;
+int Player::input_events_in_frame = 0;
+int Player::input_events_last_frame = 0;
+int Player::look_writes_in_frame = 0;
+int Player::look_writes_last_frame = 0;
+int Player::monitor_users = 0;
+
+static bool get_key_action(Key p_keycode, InputAccumulator::Action &r_action) {
+    switch (p_keycode) {
+        case KEY_W: r_action = InputAccumulator::ACTION_FORWARD; return true;
+        case KEY_S: r_action = InputAccumulator::ACTION_BACK; return true;
+        case KEY_A: r_action = InputAccumulator::ACTION_LEFT; return true;
+        case KEY_D: r_action = InputAccumulator::ACTION_RIGHT; return true;
+        case KEY_SPACE: r_action = InputAccumulator::ACTION_JUMP; return true;
+        default: return false;
+    }
+}
+
+static double get_physics_tick_length() {
+    return 1.0 / MAX(Engine::get_singleton()->get_physics_ticks_per_second(), 1);
+}
+
 void Player::_bind_methods() {
     ClassDB::bind_method(D_METHOD("get_speed"), &Player::get_speed);
     ClassDB::bind_method(D_METHOD("set_speed", "speed"), &Player::set_speed);
@@ -16,11 +44,48 @@ void Player::_bind_methods() {
     ClassDB::bind_method(D_METHOD("set_gravity", "gravity"), &Player::set_gravity);
     ClassDB::bind_method(D_METHOD("get_camera_sensitivity"), &Player::get_camera_sensitivity);
     ClassDB::bind_method(D_METHOD("set_camera_sensitivity", "sensitivity"), &Player::set_camera_sensitivity);
+    ClassDB::bind_method(D_METHOD("get_look_rotation"), &Player::get_look_rotation);
+    ClassDB::bind_method(D_METHOD("get_hurtbox"), &Player::get_hurtbox);
+    ClassDB::bind_method(D_METHOD("set_hurtbox", "hurtbox"), &Player::set_hurtbox);
+    ClassDB::bind_method(D_METHOD("feed_look", "relative"), &Player::feed_look);
+    ClassDB::bind_method(D_METHOD("feed_action", "action", "pressed"), &Player::feed_action);
+    ClassDB::bind_static_method("Player", D_METHOD("get_input_events_per_frame"), &Player::get_input_events_per_frame);
+    ClassDB::bind_static_method("Player", D_METHOD("get_look_writes_per_frame"), &Player::get_look_writes_per_frame);
     
     ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "speed"), "set_speed", "get_speed");
     ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "jump_velocity"), "set_jump_velocity", "get_jump_velocity");
     ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "gravity"), "set_gravity", "get_gravity");
     ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "camera_sensitivity"), "set_camera_sensitivity", "get_camera_sensitivity");
+    ADD_PROPERTY(PropertyInfo(Variant::AABB, "hurtbox"), "set_hurtbox", "get_hurtbox");
+
+    BIND_ENUM_CONSTANT(INPUT_FORWARD);
+    BIND_ENUM_CONSTANT(INPUT_BACK);
+    BIND_ENUM_CONSTANT(INPUT_LEFT);
+    BIND_ENUM_CONSTANT(INPUT_RIGHT);
+    BIND_ENUM_CONSTANT(INPUT_JUMP);
+    BIND_ENUM_CONSTANT(INPUT_FIRE);
+    BIND_ENUM_CONSTANT(INPUT_ACTION_MAX);
+}
+
+void Player::_notification(int p_what) {
+    if (p_what == NOTIFICATION_ENTER_TREE) {
+        // Before our children enter, so weapons find us as their owner
+        entity = Entities::register_node(this, EntityRegistry::KIND_PLAYER);
+        if (monitor_users++ == 0) {
+            PerfMonitors::add("Input/Events Per Frame", callable_mp_static(&Player::get_input_events_per_frame));
+            PerfMonitors::add("Input/Look Writes Per Frame", callable_mp_static(&Player::get_look_writes_per_frame));
+        }
+    } else if (p_what == NOTIFICATION_EXIT_TREE) {
+        LagCompensation* lag_compensation = LagCompensation::get_singleton();
+        if (lag_compensation) {
+            lag_compensation->unregister_entity(this);
+        }
+        Entities::unregister(entity);
+        if (--monitor_users == 0) {
+            PerfMonitors::remove("Input/Events Per Frame");
+            PerfMonitors::remove("Input/Look Writes Per Frame");
+        }
+    }
 }
 
 void Player::_ready() {
@@ -30,6 +95,14 @@ void Player::_ready() {
     }
     
     setup_camera();
+    add_to_group(GROUP_NAME);
+
+    // Record our hurtbox so shots can be tested against where we were
+    add_to_group(LagCompensation::GROUP_NAME);
+    LagCompensation* lag_compensation = LagCompensation::get_singleton();
+    if (lag_compensation && lag_compensation->is_node_ready()) {
+        lag_compensation->register_entity(this, hurtbox);
+    }
 
     // Try to find existing WeaponManager first
     weapon_manager = camera->get_node<WeaponManager>("WeaponManager");
@@ -39,49 +112,115 @@ void Player::_ready() {
         camera->add_child(weapon_manager);
         weapon_manager->set_name("WeaponManager");
     }
+
+    // Trigger presses are timestamped here and passed on with their tick offset
+    weapon_manager->set_process_input(false);
     
     // Capture the mouse for first-person controls
     Input::get_singleton()->set_mouse_mode(Input::MOUSE_MODE_CAPTURED);
 }
 
 void Player::_input(const Ref<InputEvent>& event) {
+    TRACE_SCOPE("Player::input");
     // Don't process input when in the editor
     if (Engine::get_singleton()->is_editor_hint()) {
         return;
     }
-    
-    // Handle mouse motion for camera rotation
+    roll_input_frame();
+    input_events_in_frame++;
+
+    // Mouse motion is only summed here, the rotation is written once later
     Ref<InputEventMouseMotion> mouse_motion = event;
     if (mouse_motion.is_valid()) {
         Vector2 relative = mouse_motion->get_relative();
-        
-        // Apply mouse sensitivity and accumulate rotation
-        mouse_rotation.y -= relative.x * camera_sensitivity * 0.01; // Horizontal (yaw)
-        mouse_rotation.x -= relative.y * camera_sensitivity * 0.01; // Vertical (pitch)
-        
-        // Clamp vertical rotation to prevent over-rotation
-        mouse_rotation.x = CLAMP(mouse_rotation.x, Math::deg_to_rad(-max_pitch), Math::deg_to_rad(max_pitch));
-        
-        update_camera_rotation();
-    
+        input.add_look(relative.x, relative.y);
+        return;
+    }
 
-        if (weapon_manager) {
-            weapon_manager->apply_mouse_input(relative);
-        }
+    uint64_t now = Time::get_singleton()->get_ticks_usec();
+
+    // The weapons schedule the shot at the point of the tick the press happened
+    Ref<InputEventMouseButton> mouse_button = event;
+    if (mouse_button.is_valid() && mouse_button->get_button_index() == MOUSE_BUTTON_LEFT) {
+        set_action(InputAccumulator::ACTION_FIRE, mouse_button->is_pressed(), now);
+        return;
     }
-    
-    // Allow escape key to release mouse capture for testing
+
     Ref<InputEventKey> key_event = event;
-    if (key_event.is_valid() && key_event->is_pressed() && key_event->get_keycode() == KEY_ESCAPE) {
-        Input::get_singleton()->set_mouse_mode(Input::MOUSE_MODE_VISIBLE);
+    if (key_event.is_valid()) {
+        InputAccumulator::Action action;
+        if (get_key_action(key_event->get_keycode(), action)) {
+            set_action(action, key_event->is_pressed(), now);
+        }
+
+        // Allow escape key to release mouse capture for testing
+        if (key_event->is_pressed() && key_event->get_keycode() == KEY_ESCAPE) {
+            Input::get_singleton()->set_mouse_mode(Input::MOUSE_MODE_VISIBLE);
+        }
+    }
+}
+
+void Player::set_action(InputAccumulator::Action p_action, bool p_pressed, uint64_t p_time_usec) {
+    if (!input.set_action(p_action, p_pressed, p_time_usec)) {
+        return;
+    }
+    if (p_action == InputAccumulator::ACTION_FIRE && weapon_manager) {
+        weapon_manager->handle_shoot_input(p_pressed, input.get_tick_offset(p_time_usec, get_physics_tick_length()));
+    }
+}
+
+void Player::feed_look(Vector2 relative) {
+    input.add_look(relative.x, relative.y);
+}
+
+void Player::feed_action(InputAction action, bool pressed) {
+    ERR_FAIL_INDEX((int)action, (int)INPUT_ACTION_MAX);
+    set_action((InputAccumulator::Action)action, pressed, Time::get_singleton()->get_ticks_usec());
+}
+
+void Player::_process(double delta) {
+    if (Engine::get_singleton()->is_editor_hint()) {
+        return;
+    }
+    roll_input_frame();
+
+    // Motion that arrived after the physics ticks of this frame, if any
+    apply_look();
+}
+
+void Player::apply_look() {
+    float look[2];
+    uint32_t events = input.take_look(look);
+    if (events == 0) {
+        return;
+    }
+    TRACE_COUNTER("Player::look_events", events);
+
+    // Apply mouse sensitivity and accumulate rotation
+    mouse_rotation.y -= look[0] * camera_sensitivity * 0.01; // Horizontal (yaw)
+    mouse_rotation.x -= look[1] * camera_sensitivity * 0.01; // Vertical (pitch)
+
+    // Clamp vertical rotation to prevent over-rotation
+    mouse_rotation.x = CLAMP(mouse_rotation.x, Math::deg_to_rad(-max_pitch), Math::deg_to_rad(max_pitch));
+
+    update_camera_rotation();
+    look_writes_in_frame++;
+
+    if (weapon_manager) {
+        weapon_manager->apply_mouse_input(Vector2(look[0], look[1]));
     }
 }
 
 void Player::_physics_process(double delta) {
+    TRACE_SCOPE("Player::physics_process");
     // Don't process input when in the editor
     if (Engine::get_singleton()->is_editor_hint()) {
         return;
     }
+    uint64_t now = Time::get_singleton()->get_ticks_usec();
+
+    // Aim and movement this tick see all motion received before it
+    apply_look();
 
     Vector3 velocity = get_velocity();
 
@@ -89,11 +228,10 @@ void Player::_physics_process(double delta) {
     if (!is_on_floor())
         velocity.y -= gravity * delta;
 
-    // Movement input - use direct keyboard input to avoid InputMap errors
-    Input* input = Input::get_singleton();
+    // Movement input from the accumulated key state
     Vector2 input_dir = Vector2(
-        (input->is_key_pressed(KEY_D) ? 1.0f : 0.0f) - (input->is_key_pressed(KEY_A) ? 1.0f : 0.0f),
-        (input->is_key_pressed(KEY_W) ? 1.0f : 0.0f) - (input->is_key_pressed(KEY_S) ? 1.0f : 0.0f)
+        (input.is_held(InputAccumulator::ACTION_RIGHT) ? 1.0f : 0.0f) - (input.is_held(InputAccumulator::ACTION_LEFT) ? 1.0f : 0.0f),
+        (input.is_held(InputAccumulator::ACTION_FORWARD) ? 1.0f : 0.0f) - (input.is_held(InputAccumulator::ACTION_BACK) ? 1.0f : 0.0f)
     ).normalized();
 
     // Use camera's forward direction for movement (only horizontal plane)
@@ -117,10 +255,11 @@ void Player::_physics_process(double delta) {
         weapon_manager->set_movement_state(is_moving);
     }
 
-    // Jump - use direct Space key input
-    if (is_on_floor() && input->is_key_pressed(KEY_SPACE)) {
+    // Jump, a tap released before this tick still counts
+    if (is_on_floor() && input.was_pressed(InputAccumulator::ACTION_JUMP)) {
         velocity.y = jump_velocity;
     }
+    input.begin_tick(now, (uint64_t)(get_physics_tick_length() * 1000000.0));
 
     set_velocity(velocity);
     move_and_slide();
@@ -152,3 +291,27 @@ void Player::update_camera_rotation() {
     // Apply yaw (horizontal rotation) to the player body
     set_rotation(Vector3(0, mouse_rotation.y, 0));
 }
+
+void Player::roll_input_frame() {
+    uint64_t frame = Engine::get_singleton()->get_process_frames();
+    if (frame == input_frame) {
+        return;
+    }
+    // Only the frame just finished is reported, idle frames in between read as zero
+    bool consecutive = frame == input_frame + 1;
+    input_events_last_frame = consecutive ? input_events_in_frame : 0;
+    look_writes_last_frame = consecutive ? look_writes_in_frame : 0;
+    input_events_in_frame = 0;
+    look_writes_in_frame = 0;
+    input_frame = frame;
+}
+
+int Player::get_input_events_per_frame() {
+    roll_input_frame();
+    return input_events_last_frame;
+}
+
+int Player::get_look_writes_per_frame() {
+    roll_input_frame();
+    return look_writes_last_frame;
+}
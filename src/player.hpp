@@ -5,6 +5,7 @@
 #include <godot_cpp/classes/camera3d.hpp>
 #include <godot_cpp/classes/input_event_mouse_motion.hpp>
 #include <godot_cpp/core/class_db.hpp>
+#include "input/input_accumulator.hpp"
 #include "weapons/weapon_manager.hpp"
 
 
@@ -13,6 +14,17 @@ namespace godot {
 class Player : public CharacterBody3D {
     GDCLASS(Player, CharacterBody3D)
 
+public:
+    enum InputAction {
+        INPUT_FORWARD = InputAccumulator::ACTION_FORWARD,
+        INPUT_BACK = InputAccumulator::ACTION_BACK,
+        INPUT_LEFT = InputAccumulator::ACTION_LEFT,
+        INPUT_RIGHT = InputAccumulator::ACTION_RIGHT,
+        INPUT_JUMP = InputAccumulator::ACTION_JUMP,
+        INPUT_FIRE = InputAccumulator::ACTION_FIRE,
+        INPUT_ACTION_MAX = InputAccumulator::ACTION_MAX,
+    };
+
 private:
     double speed = 5.0;
     double gravity = 9.82;
@@ -25,16 +37,46 @@ private:
     double max_pitch = 80.0; // Maximum vertical look angle in degrees
     WeaponManager* weapon_manager = nullptr;
 
+    // Input is gathered in _input and applied once by whichever of the next
+    // physics tick or frame comes first
+    InputAccumulator input;
+    void apply_look();
+    void set_action(InputAccumulator::Action p_action, bool p_pressed, uint64_t p_time_usec);
+
+    // Input work across every player, counted per rendered frame for the monitors
+    static uint64_t input_frame;
+    static int input_events_in_frame;
+    static int input_events_last_frame;
+    static int look_writes_in_frame;
+    static int look_writes_last_frame;
+    static int monitor_users;
+    static void roll_input_frame();
+
+    // Local-space hurtbox recorded for lag compensation (origin at the feet)
+    AABB hurtbox = AABB(Vector3(-0.4, 0.0, -0.4), Vector3(0.8, 1.8, 0.8));
+
+    uint32_t entity = 0; // EntityRegistry handle while in the tree, owner of our weapons
+
 public:
+    // Bodies gathered for replication
+    static constexpr const char *GROUP_NAME = "players";
+
     Player() {}
     ~Player() {}
 
     static void _bind_methods();
 
+    void _notification(int p_what);
     void _ready() override;
+    uint32_t get_entity() const { return entity; }
     void _input(const Ref<InputEvent>& event) override;
+    void _process(double delta) override;
     void _physics_process(double delta) override;
     
+    // Input from a script or test driver instead of devices, same path as real events
+    void feed_look(Vector2 relative);
+    void feed_action(InputAction action, bool pressed);
+
     // Camera methods
     void setup_camera();
     void update_camera_rotation();
@@ -52,9 +94,19 @@ public:
     double get_camera_sensitivity() const { return camera_sensitivity; }
     void set_camera_sensitivity(double p_sensitivity) { camera_sensitivity = p_sensitivity; }
 
-     
+    // X = pitch, Y = yaw, in radians
+    Vector2 get_look_rotation() const { return mouse_rotation; }
+
+    AABB get_hurtbox() const { return hurtbox; }
+    void set_hurtbox(const AABB &p_hurtbox) { hurtbox = p_hurtbox; }
+
+    // Input events received and camera rotation writes in the last frame
+    static int get_input_events_per_frame();
+    static int get_look_writes_per_frame();
 };
 
 }
 
+VARIANT_ENUM_CAST(Player::InputAction);
+
 #endif // PLAYER_H
@@ -8,6 +8,16 @@
 #include "player.hpp"
 #include "weapons/weapon_manager.hpp"
 #include "weapons/guns/pistol.hpp"
+#include "weapons/guns/rifle.hpp"
+#include "weapons/projectile_manager.hpp"
+#include "bots/bot_crowd.hpp"
+#include "combat/health.hpp"
+#include "combat/damage_system.hpp"
+#include "combat/lag_compensation.hpp"
+#include "net/replication_stream.hpp"
+#include "debug/hurtbox_benchmark.hpp"
+#include "debug/soak_test.hpp"
+#include "debug/trace_recorder.hpp"
 
 using namespace godot;
 
@@ -20,6 +30,18 @@ void initialize_gdextension_types(ModuleInitializationLevel p_level)
 	godot::ClassDB::register_class<godot::Weapon>();
 	godot::ClassDB::register_class<godot::WeaponManager>();
 	godot::ClassDB::register_class<godot::Pistol>();
+	godot::ClassDB::register_class<godot::Rifle>();
+	godot::ClassDB::register_class<godot::ProjectileManager>();
+	godot::ClassDB::register_class<godot::Health>();
+	godot::ClassDB::register_class<godot::DamageSystem>();
+	godot::ClassDB::register_class<godot::LagCompensation>();
+	godot::ClassDB::register_class<godot::ReplicationStream>();
+	godot::ClassDB::register_class<godot::BotCrowd>();
+	godot::ClassDB::register_class<godot::TraceRecorder>();
+	godot::ClassDB::register_class<godot::SoakTest>();
+	godot::ClassDB::register_class<godot::HurtboxBenchmark>();
+
+	godot::ProjectileManager::define_project_settings();
 }
 
 void uninitialize_gdextension_types(ModuleInitializationLevel p_level) {
@@ -1,4 +1,5 @@
 #include "pistol.hpp"
+#include "../../debug/trace.hpp"
 #include <godot_cpp/core/class_db.hpp>
 #include <godot_cpp/variant/utility_functions.hpp>
 
@@ -21,7 +22,7 @@ void Pistol::_ready() {
     // Set pistol-specific recoil amplifier
     set_recoil_amplifier(1.2); // Slightly higher recoil than default
     
-    UtilityFunctions::print("Pistol: Ready with recoil amplifier ", get_recoil_amplifier());
+    TRACE_PRINT("Pistol: Ready with recoil amplifier ", get_recoil_amplifier());
 }
 
 void Pistol::setup_first_person_position() {
@@ -0,0 +1,41 @@
+#include "rifle.hpp"
+#include "../../debug/trace.hpp"
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/variant/utility_functions.hpp>
+
+using namespace godot;
+
+Rifle::Rifle() {
+    // Defaults set here so scenes can still override them in the inspector
+    set_fire_mode(FIRE_MODE_HITSCAN);
+    set_automatic(true);
+    set_rounds_per_minute(600.0);
+    set_damage(25.0);
+    set_range(400.0);
+
+    // Climbs for the first ten shots, then sways left and right near the top
+    PackedVector2Array pattern;
+    for (int i = 0; i < 30; i++) {
+        double pitch = 0.45 * MIN(i, 10) + 0.05 * MAX(i - 10, 0);
+        double yaw = i < 10 ? 0.08 * i : 0.8 * Math::cos((i - 10) * 0.45);
+        pattern.push_back(Vector2(pitch, yaw));
+    }
+    set_spray_pattern(pattern);
+}
+
+Rifle::~Rifle() {
+}
+
+void Rifle::_bind_methods() {
+    // No additional methods to bind for rifle
+}
+
+void Rifle::_ready() {
+    // Call parent ready first
+    Weapon::_ready();
+    
+    // Lighter kick per shot, it fires much more often than the pistol
+    set_recoil_amplifier(0.6);
+    
+    TRACE_PRINT("Rifle: Ready at ", get_rounds_per_minute(), " rounds per minute");
+}
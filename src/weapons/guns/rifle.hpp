@@ -0,0 +1,22 @@
+#ifndef RIFLE_H
+#define RIFLE_H
+
+#include "../weapon_manager.hpp"
+
+namespace godot {
+
+// Automatic hitscan rifle
+class Rifle : public Weapon {
+    GDCLASS(Rifle, Weapon)
+
+public:
+    Rifle();
+    ~Rifle();
+    
+    static void _bind_methods();
+    void _ready() override;
+};
+
+}
+
+#endif
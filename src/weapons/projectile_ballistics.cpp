@@ -0,0 +1,76 @@
+#include "projectile_ballistics.hpp"
+
+#include <cmath>
+
+using namespace godot;
+
+// Below this k * t the exponential form cancels badly, use its series instead
+static const float SERIES_THRESHOLD = 1e-3f;
+
+void ProjectileBallistics::get_factors(float p_age, float &r_decay, float &r_gain, float &r_fall) const {
+    float x = drag * p_age;
+    if (x < SERIES_THRESHOLD) {
+        r_decay = 1.0f - x + x * x * 0.5f;
+        r_gain = p_age * (1.0f - x * 0.5f + x * x / 6.0f);
+        r_fall = p_age * p_age * (0.5f - x / 6.0f + x * x / 24.0f);
+        return;
+    }
+    r_decay = std::exp(-x);
+    r_gain = (1.0f - r_decay) / drag;
+    r_fall = (p_age - r_gain) / drag;
+}
+
+void ProjectileBallistics::get_position(const float p_origin[3], const float p_velocity[3], float p_age, float r_position[3]) const {
+    float decay, gain, fall;
+    get_factors(p_age, decay, gain, fall);
+    for (int axis = 0; axis < 3; axis++) {
+        r_position[axis] = p_origin[axis] + p_velocity[axis] * gain + gravity[axis] * fall;
+    }
+}
+
+void ProjectileBallistics::get_velocity(const float p_velocity[3], float p_age, float r_velocity[3]) const {
+    float decay, gain, fall;
+    get_factors(p_age, decay, gain, fall);
+    for (int axis = 0; axis < 3; axis++) {
+        r_velocity[axis] = p_velocity[axis] * decay + gravity[axis] * gain;
+    }
+}
+
+void ProjectileBallistics::get_path_bounds(const float p_origin[3], const float p_velocity[3], float p_from_age, float p_to_age, float r_min[3], float r_max[3]) const {
+    float from[3];
+    float to[3];
+    get_position(p_origin, p_velocity, p_from_age, from);
+    get_position(p_origin, p_velocity, p_to_age, to);
+    for (int axis = 0; axis < 3; axis++) {
+        r_min[axis] = std::fmin(from[axis], to[axis]);
+        r_max[axis] = std::fmax(from[axis], to[axis]);
+    }
+
+    for (int axis = 0; axis < 3; axis++) {
+        float g = gravity[axis];
+        float v = p_velocity[axis];
+        if (g == 0.0f) {
+            continue; // Drag alone never reverses a component
+        }
+
+        // Age at which this component of the velocity crosses zero
+        float turn;
+        if (drag == 0.0f) {
+            turn = -v / g;
+        } else {
+            float decay = g / (g - drag * v);
+            if (!(decay > 0.0f && decay < 1.0f)) {
+                continue;
+            }
+            turn = -std::log(decay) / drag;
+        }
+        if (!(turn > p_from_age && turn < p_to_age)) {
+            continue;
+        }
+
+        float apex[3];
+        get_position(p_origin, p_velocity, turn, apex);
+        r_min[axis] = std::fmin(r_min[axis], apex[axis]);
+        r_max[axis] = std::fmax(r_max[axis], apex[axis]);
+    }
+}
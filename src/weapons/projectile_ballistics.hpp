@@ -0,0 +1,34 @@
+#ifndef PROJECTILE_BALLISTICS_H
+#define PROJECTILE_BALLISTICS_H
+
+namespace godot {
+
+// Closed-form flight under constant gravity and linear drag.
+//
+// With drag k the velocity relaxes towards the terminal velocity g / k:
+//
+//   v(t) = v0 e^(-kt) + g (1 - e^(-kt)) / k
+//   p(t) = p0 + v0 (1 - e^(-kt)) / k + g (t - (1 - e^(-kt)) / k) / k
+//
+// which falls back to p0 + v0 t + g t^2 / 2 without drag. A projectile is
+// fully described by its spawn position, launch velocity and spawn time, so
+// positions are only evaluated when something needs them.
+struct ProjectileBallistics {
+    float gravity[3] = { 0.0f, 0.0f, 0.0f };
+    float drag = 0.0f; // Per second, 0 disables drag
+
+    // Velocity and displacement factors at p_age: v = v0 * r_decay + g * r_gain
+    // and p = p0 + v0 * r_gain + g * r_fall
+    void get_factors(float p_age, float &r_decay, float &r_gain, float &r_fall) const;
+
+    void get_position(const float p_origin[3], const float p_velocity[3], float p_age, float r_position[3]) const;
+    void get_velocity(const float p_velocity[3], float p_age, float r_velocity[3]) const;
+
+    // Exact bounds of the path between two ages. Each velocity component is
+    // monotonic, so only the endpoints and one turning point per axis count.
+    void get_path_bounds(const float p_origin[3], const float p_velocity[3], float p_from_age, float p_to_age, float r_min[3], float r_max[3]) const;
+};
+
+}
+
+#endif // PROJECTILE_BALLISTICS_H
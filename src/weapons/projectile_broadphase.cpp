@@ -0,0 +1,114 @@
+#include "projectile_broadphase.hpp"
+#include "projectile_pool.hpp"
+#include "../combat/hurtbox_tree.hpp"
+
+#include <cmath>
+
+using namespace godot;
+
+static bool boxes_overlap(const float p_min[3], const float p_max[3], const ProjectileBroadphase::Box &p_box, float p_margin) {
+    return p_min[0] <= p_box.max[0] + p_margin && p_max[0] >= p_box.min[0] - p_margin &&
+            p_min[1] <= p_box.max[1] + p_margin && p_max[1] >= p_box.min[1] - p_margin &&
+            p_min[2] <= p_box.max[2] + p_margin && p_max[2] >= p_box.min[2] - p_margin;
+}
+
+void ProjectileBroadphase::add_static(const float p_min[3], const float p_max[3]) {
+    Box box;
+    for (int axis = 0; axis < 3; axis++) {
+        box.min[axis] = p_min[axis];
+        box.max[axis] = p_max[axis];
+        if (!static_boxes.empty()) {
+            static_bounds.min[axis] = std::fmin(static_bounds.min[axis], p_min[axis]);
+            static_bounds.max[axis] = std::fmax(static_bounds.max[axis], p_max[axis]);
+        }
+    }
+    if (static_boxes.empty()) {
+        static_bounds = box;
+    }
+    static_boxes.push_back(box);
+}
+
+void ProjectileBroadphase::add_dynamic(const float p_min[3], const float p_max[3], bool p_hurtbox) {
+    Box box;
+    for (int axis = 0; axis < 3; axis++) {
+        box.min[axis] = p_min[axis];
+        box.max[axis] = p_max[axis];
+    }
+    dynamic_boxes.push_back(box);
+    dynamic_hurtbox.push_back(p_hurtbox ? 1 : 0);
+}
+
+void ProjectileBroadphase::add_hurtboxes(const HurtboxTree &p_tree, bool p_hurtbox) {
+    p_tree.for_each_fat_box([&](const float p_min[3], const float p_max[3]) {
+        add_dynamic(p_min, p_max, p_hurtbox);
+    });
+}
+
+bool ProjectileBroadphase::overlaps(const float p_min[3], const float p_max[3], float p_window) const {
+    float margin = max_target_speed * p_window;
+    for (const Box &box : dynamic_boxes) {
+        if (boxes_overlap(p_min, p_max, box, margin)) {
+            return true;
+        }
+    }
+
+    // Most of the sky is outside the level's bounds altogether
+    if (static_boxes.empty() || !boxes_overlap(p_min, p_max, static_bounds, 0.0f)) {
+        return false;
+    }
+    for (const Box &box : static_boxes) {
+        if (boxes_overlap(p_min, p_max, box, 0.0f)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ProjectileBroadphase::overlaps_world(const float p_min[3], const float p_max[3]) const {
+    if (!is_active()) {
+        return true;
+    }
+    for (uint32_t i = 0; i < dynamic_boxes.size(); i++) {
+        if (!dynamic_hurtbox[i] && boxes_overlap(p_min, p_max, dynamic_boxes[i], 0.0f)) {
+            return true;
+        }
+    }
+
+    if (!boxes_overlap(p_min, p_max, static_bounds, 0.0f)) {
+        return false;
+    }
+    for (const Box &box : static_boxes) {
+        if (boxes_overlap(p_min, p_max, box, 0.0f)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+ProjectileBroadphase::SweepAction ProjectileBroadphase::prepare_sweep(ProjectilePool &r_pool, uint32_t p_dense_index, double p_time, float r_from[3], float r_to[3]) const {
+    double swept = r_pool.swept_time[p_dense_index];
+    if (swept >= p_time) {
+        return SWEEP_IDLE;
+    }
+
+    double expiry = r_pool.get_expiry_time(p_dense_index);
+    if (is_active()) {
+        double end = p_time + lookahead;
+        if (expiry < end) {
+            end = expiry > p_time ? expiry : p_time;
+        }
+
+        float min[3];
+        float max[3];
+        r_pool.get_path_bounds(p_dense_index, swept, end, min, max);
+        if (!overlaps(min, max, (float)(end - swept))) {
+            r_pool.swept_time[p_dense_index] = end;
+            return SWEEP_SKIP;
+        }
+    }
+
+    // A projectile running out of range this tick stops where the range ends
+    r_pool.get_position(p_dense_index, swept, r_from);
+    r_pool.get_position(p_dense_index, expiry < p_time ? expiry : p_time, r_to);
+    return SWEEP_TEST;
+}
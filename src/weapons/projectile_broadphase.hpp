@@ -0,0 +1,72 @@
+#ifndef PROJECTILE_BROADPHASE_H
+#define PROJECTILE_BROADPHASE_H
+
+#include <cstdint>
+#include <vector>
+
+namespace godot {
+
+class HurtboxTree;
+class ProjectilePool;
+
+// Static and moving bounds that let a projectile in open air skip its sweep
+// until the lookahead window ends. Inactive without static boxes.
+class ProjectileBroadphase {
+public:
+    enum SweepAction {
+        SWEEP_IDLE, // Already resolved past the current time
+        SWEEP_SKIP, // Nothing in reach, resolved up to the end of the lookahead
+        SWEEP_TEST, // Raycast the returned segment
+    };
+
+    struct Box {
+        float min[3];
+        float max[3];
+    };
+
+private:
+    std::vector<Box> static_boxes;
+    std::vector<Box> dynamic_boxes;
+    std::vector<uint8_t> dynamic_hurtbox; // Also in the DamageSystem's hurtbox tree
+    Box static_bounds = { { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } };
+
+    float lookahead = 0.25f;
+    float max_target_speed = 20.0f;
+
+public:
+    void clear_static() { static_boxes.clear(); }
+    void add_static(const float p_min[3], const float p_max[3]);
+    void clear_dynamic() {
+        dynamic_boxes.clear();
+        dynamic_hurtbox.clear();
+    }
+    void add_dynamic(const float p_min[3], const float p_max[3], bool p_hurtbox = false);
+    // Every hurtbox in p_tree, as hurtbox boxes when p_tree is also queried
+    void add_hurtboxes(const HurtboxTree &p_tree, bool p_hurtbox);
+
+    bool is_active() const { return !static_boxes.empty(); }
+    uint32_t get_static_count() const { return static_boxes.size(); }
+    uint32_t get_dynamic_count() const { return dynamic_boxes.size(); }
+
+    // Seconds a projectile in open air is left alone
+    float get_lookahead() const { return lookahead; }
+    void set_lookahead(float p_seconds) { lookahead = p_seconds > 0.0f ? p_seconds : 0.0f; }
+    float get_max_target_speed() const { return max_target_speed; }
+    void set_max_target_speed(float p_speed) { max_target_speed = p_speed > 0.0f ? p_speed : 0.0f; }
+
+    // Dynamic boxes are grown by the distance a target covers in p_window seconds
+    bool overlaps(const float p_min[3], const float p_max[3], float p_window) const;
+    // Whether a box at the current time touches anything that only a physics
+    // ray can resolve: static boxes and dynamic boxes that are not hurtboxes.
+    // Always true while the broadphase is inactive.
+    bool overlaps_world(const float p_min[3], const float p_max[3]) const;
+
+    // Decides what projectile p_dense_index needs at p_time. Skipping moves
+    // its swept time forward; testing leaves it to the caller, which sets it
+    // to p_time once the segment r_from -> r_to has been cast.
+    SweepAction prepare_sweep(ProjectilePool &r_pool, uint32_t p_dense_index, double p_time, float r_from[3], float r_to[3]) const;
+};
+
+}
+
+#endif // PROJECTILE_BROADPHASE_H
@@ -0,0 +1,301 @@
+#include "projectile_collision.hpp"
+#include "../combat/damage_system.hpp"
+#include "../combat/entity_registry.hpp"
+#include "../combat/lag_compensation.hpp"
+#include <godot_cpp/classes/collision_object3d.hpp>
+#include <godot_cpp/classes/time.hpp>
+#include <godot_cpp/core/object.hpp>
+
+#include <algorithm>
+
+using namespace godot;
+
+// Segments are resolved in batches of this size. The clock is checked between
+// batches; checking it on every ray would cost more than the check saves.
+static constexpr uint32_t BATCH_SIZE = 32;
+
+// Live hits on bodies resolved elsewhere, by lag-compensated history or the
+// hurtbox tree, are skipped by re-casting past them
+static constexpr int MAX_SKIP_PASSES = 4;
+static constexpr float SKIP_PASS_EPSILON = 0.01f;
+
+ProjectileCollisionStage::ProjectileCollisionStage() {
+    query.instantiate();
+    query->set_collide_with_areas(false);
+    query->set_collide_with_bodies(true);
+}
+
+void ProjectileCollisionStage::bind_shooter(uint32_t p_shooter) {
+    if (p_shooter == exclude_shooter) {
+        return;
+    }
+    exclude_shooter = p_shooter;
+    exclude.clear();
+
+    // The shooter may be a weapon or camera; exclude the body that carries it
+    exclude_body_id = EntityRegistry::get_singleton().get_body(p_shooter);
+    CollisionObject3D *body = exclude_body_id != 0 ? Object::cast_to<CollisionObject3D>(ObjectDB::get_instance(ObjectID(exclude_body_id))) : nullptr;
+    if (body) {
+        exclude.append(body->get_rid());
+    }
+
+    query->set_exclude(exclude);
+}
+
+void ProjectileCollisionStage::begin_tick() {
+    stats = ProjectileCollisionStats();
+}
+
+void ProjectileCollisionStage::release_frame_data() {
+    frame_release(pending);
+    frame_release(hurtbox_segments);
+    frame_release(hurtbox_hits);
+    frame_release(hits);
+    frame_release(hitscan_hits);
+}
+
+void ProjectileCollisionStage::run(PhysicsDirectSpaceState3D *p_space, ProjectilePool &p_pool, const DamageSystem *p_damage_system) {
+    uint64_t start_usec = Time::get_singleton()->get_ticks_usec();
+
+    hits.clear();
+
+    uint32_t count = p_pool.get_count();
+    if (!p_space || count == 0) {
+        return;
+    }
+
+    if (cursor >= count) {
+        cursor = 0;
+    }
+
+    // Shooters may have been freed since the last tick, rebuild exclusions lazily
+    exclude_shooter = 0;
+    exclude_body_id = 0;
+    exclude.clear();
+    query->set_exclude(exclude);
+    query->set_collision_mask(collision_mask);
+
+    const EntityRegistry &registry = EntityRegistry::get_singleton();
+    double now = p_pool.get_time();
+    uint32_t budget = max_raycasts_per_tick > 0 ? max_raycasts_per_tick : count;
+    uint32_t world_segments = 0; // Counted against the budget
+    uint32_t visited = 0;
+
+    while (visited < count && world_segments < budget) {
+        pending.clear();
+        hurtbox_segments.clear();
+        for (; visited < count && world_segments < budget && pending.size() < BATCH_SIZE; visited++) {
+            uint32_t i = cursor + visited;
+            if (i >= count) {
+                i -= count;
+            }
+
+            PendingSegment segment;
+            ProjectileBroadphase::SweepAction action = broadphase.prepare_sweep(p_pool, i, now, segment.from, segment.to);
+            if (action == ProjectileBroadphase::SWEEP_IDLE) {
+                continue;
+            }
+            stats.segments++;
+            if (action == ProjectileBroadphase::SWEEP_SKIP) {
+                stats.skipped++;
+                continue;
+            }
+
+            p_pool.swept_time[i] = now;
+            if (segment.from[0] == segment.to[0] && segment.from[1] == segment.to[1] && segment.from[2] == segment.to[2]) {
+                continue;
+            }
+
+            segment.index = i;
+            segment.world_ray = true;
+            if (p_damage_system) {
+                // Hurtboxes come from the tree, the world only where the broadphase has something
+                float min[3];
+                float max[3];
+                for (int axis = 0; axis < 3; axis++) {
+                    min[axis] = MIN(segment.from[axis], segment.to[axis]);
+                    max[axis] = MAX(segment.from[axis], segment.to[axis]);
+                }
+                segment.world_ray = broadphase.overlaps_world(min, max);
+
+                HurtboxTree::Segment query_segment;
+                for (int axis = 0; axis < 3; axis++) {
+                    query_segment.from[axis] = segment.from[axis];
+                    query_segment.to[axis] = segment.to[axis];
+                }
+                query_segment.ignore_key = registry.get_body(p_pool.shooter[i]);
+                hurtbox_segments.push_back(query_segment);
+            }
+            world_segments += segment.world_ray;
+            pending.push_back(segment);
+        }
+        resolve_pending(p_space, p_pool, p_damage_system);
+
+        if (max_time_usec > 0 && Time::get_singleton()->get_ticks_usec() - start_usec >= max_time_usec) {
+            break;
+        }
+    }
+
+    // Everything not visited keeps its swept time and goes first next tick
+    for (uint32_t rest = visited; rest < count; rest++) {
+        uint32_t i = cursor + rest;
+        if (i >= count) {
+            i -= count;
+        }
+        stats.rays_deferred += p_pool.swept_time[i] < now;
+    }
+    cursor = (cursor + visited) % count;
+
+    // The round-robin start can wrap, keep consumers in index order
+    std::sort(hits.begin(), hits.end(), [](const ProjectileHit &a, const ProjectileHit &b) {
+        return a.projectile_index < b.projectile_index;
+    });
+
+    stats.hits = hits.size();
+    stats.time_usec += Time::get_singleton()->get_ticks_usec() - start_usec;
+}
+
+void ProjectileCollisionStage::resolve_pending(PhysicsDirectSpaceState3D *p_space, ProjectilePool &p_pool, const DamageSystem *p_damage_system) {
+    const HurtboxTree *tree = p_damage_system ? &p_damage_system->get_hurtbox_tree() : nullptr;
+    if (tree && !hurtbox_segments.empty()) {
+        hurtbox_hits.resize(hurtbox_segments.size());
+        stats.hurtbox_queries += hurtbox_segments.size();
+        tree->raycast_batch(hurtbox_segments.data(), hurtbox_segments.size(), hurtbox_hits.data());
+    }
+
+    for (uint32_t k = 0; k < pending.size(); k++) {
+        const PendingSegment &segment = pending[k];
+        uint32_t i = segment.index;
+        Vector3 from(segment.from[0], segment.from[1], segment.from[2]);
+        Vector3 to(segment.to[0], segment.to[1], segment.to[2]);
+        Vector3 direction = (to - from).normalized();
+
+        // The world ray only needs to reach the nearest hurtbox
+        const HurtboxTree::Hit *hurtbox_hit = tree && hurtbox_hits[k].key != 0 ? &hurtbox_hits[k] : nullptr;
+        Vector3 end = hurtbox_hit ? Vector3(hurtbox_hit->point[0], hurtbox_hit->point[1], hurtbox_hit->point[2]) : to;
+
+        Dictionary result;
+        if (segment.world_ray) {
+            bind_shooter(p_pool.shooter[i]);
+            Vector3 ray_from = from;
+            for (int pass = 0; pass < MAX_SKIP_PASSES; pass++) {
+                query->set_from(ray_from);
+                query->set_to(end);
+                result = p_space->intersect_ray(query);
+                stats.rays_cast++;
+
+                // Bodies with a hurtbox are only hit through the tree
+                if (result.is_empty() || !tree || !p_damage_system->has_hurtbox(ObjectID((uint64_t)result["collider_id"]))) {
+                    break;
+                }
+                ray_from = (Vector3)result["position"] + direction * SKIP_PASS_EPSILON;
+                result = Dictionary();
+            }
+        }
+
+        ProjectileHit hit;
+        hit.projectile_index = i;
+        hit.projectile_id = p_pool.id[i];
+        hit.shooter = p_pool.shooter[i];
+        hit.damage = p_pool.damage[i];
+
+        if (!result.is_empty()) {
+            hit.collider_id = ObjectID((uint64_t)result["collider_id"]);
+            hit.point = result["position"];
+            hit.normal = result["normal"];
+        } else if (hurtbox_hit) {
+            hit.collider_id = ObjectID(hurtbox_hit->key);
+            hit.point = end;
+            hit.normal = -direction;
+            stats.hurtbox_hits++;
+        } else {
+            continue;
+        }
+        hits.push_back(hit);
+    }
+}
+
+void ProjectileCollisionStage::run_hitscan(PhysicsDirectSpaceState3D *p_space, const FrameVector<HitscanRequest> &p_batch, const LagCompensation *p_lag_compensation) {
+    uint64_t start_usec = Time::get_singleton()->get_ticks_usec();
+
+    hitscan_hits.clear();
+
+    if (!p_space || p_batch.empty()) {
+        return;
+    }
+
+    // Sorting indices keeps the batch order, and unlike stable_sort needs no heap buffer
+    FrameVector<uint32_t> order(p_batch.size());
+    for (uint32_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&p_batch](uint32_t a, uint32_t b) {
+        return p_batch[a].shooter != p_batch[b].shooter ? p_batch[a].shooter < p_batch[b].shooter : a < b;
+    });
+
+    exclude_shooter = 0;
+    exclude_body_id = 0;
+    exclude.clear();
+    query->set_exclude(exclude);
+    query->set_collision_mask(collision_mask);
+
+    // Hitscan shots are never deferred, a late shot would be a missed shot
+    for (uint32_t i : order) {
+        const HitscanRequest &request = p_batch[i];
+        Vector3 from(request.origin[0], request.origin[1], request.origin[2]);
+        Vector3 direction(request.direction[0], request.direction[1], request.direction[2]);
+        float range = request.range;
+
+        bind_shooter(request.shooter);
+
+        // Historical hurtboxes first; the live ray then only needs to reach them
+        bool rewinding = p_lag_compensation && request.rewind_time > 0.0;
+        HitboxHistory::RayHit rewound;
+        bool rewound_hit = false;
+        if (rewinding) {
+            stats.hitscan_rewound++;
+            rewound_hit = p_lag_compensation->rewind_raycast(request.rewind_time, from, direction, range, ObjectID(exclude_body_id), rewound);
+            if (rewound_hit) {
+                range = rewound.distance;
+            }
+        }
+
+        Dictionary result;
+        Vector3 ray_from = from;
+        for (int pass = 0; pass < MAX_SKIP_PASSES; pass++) {
+            query->set_from(ray_from);
+            query->set_to(from + direction * range);
+            result = p_space->intersect_ray(query);
+            stats.hitscan_rays++;
+
+            // Tracked bodies are only hit through their history
+            if (result.is_empty() || !rewinding || !p_lag_compensation->is_tracked(ObjectID((uint64_t)result["collider_id"]))) {
+                break;
+            }
+            ray_from = (Vector3)result["position"] + direction * SKIP_PASS_EPSILON;
+            result = Dictionary();
+        }
+
+        ProjectileHit hit;
+        hit.projectile_index = i;
+        hit.projectile_id = ProjectilePool::INVALID_ID;
+        hit.shooter = request.shooter;
+        hit.damage = request.damage;
+
+        if (!result.is_empty()) {
+            hit.collider_id = ObjectID((uint64_t)result["collider_id"]);
+            hit.point = result["position"];
+            hit.normal = result["normal"];
+        } else if (rewound_hit) {
+            hit.collider_id = ObjectID(rewound.key);
+            hit.point = Vector3(rewound.point[0], rewound.point[1], rewound.point[2]);
+            hit.normal = -direction;
+        } else {
+            continue;
+        }
+        hitscan_hits.push_back(hit);
+    }
+
+    stats.hitscan_hits = hitscan_hits.size();
+    stats.time_usec += Time::get_singleton()->get_ticks_usec() - start_usec;
+}
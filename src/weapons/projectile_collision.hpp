@@ -0,0 +1,144 @@
+#ifndef PROJECTILE_COLLISION_H
+#define PROJECTILE_COLLISION_H
+
+#include <godot_cpp/classes/physics_direct_space_state3d.hpp>
+#include <godot_cpp/classes/physics_ray_query_parameters3d.hpp>
+#include <godot_cpp/core/object_id.hpp>
+#include <godot_cpp/variant/typed_array.hpp>
+
+#include "../combat/hurtbox_tree.hpp"
+#include "../memory/frame_arena.hpp"
+#include "projectile_broadphase.hpp"
+#include "projectile_pool.hpp"
+
+#include <vector>
+
+namespace godot {
+
+class DamageSystem;
+class LagCompensation;
+
+struct ProjectileHit {
+    uint32_t projectile_index; // Dense pool index at the time of the query
+    uint32_t projectile_id; // Stable pool id
+    ObjectID collider_id;
+    uint32_t shooter; // EntityRegistry handle, stale once the shooter is gone
+    Vector3 point;
+    Vector3 normal;
+    float damage;
+};
+
+// One instant shot, queued from any thread and resolved in the next tick's batch
+struct HitscanRequest {
+    float origin[3];
+    float direction[3]; // Expected to be normalized
+    float range;
+    float damage;
+    uint32_t shooter; // EntityRegistry handle
+    double rewind_time; // LagCompensation time the shot was fired at, 0 tests the present
+};
+
+struct ProjectileCollisionStats {
+    uint32_t segments = 0; // Projectiles that needed a sweep this tick
+    uint32_t skipped = 0; // Left alone by the broadphase until their lookahead ends
+    uint32_t rays_cast = 0;
+    uint32_t rays_deferred = 0; // Pushed to the next tick by the caps
+    uint32_t hits = 0;
+    uint32_t hurtbox_queries = 0; // Segments tested against the hurtbox tree
+    uint32_t hurtbox_hits = 0;
+    uint32_t hitscan_rays = 0;
+    uint32_t hitscan_hits = 0;
+    uint32_t hitscan_rewound = 0; // Shots tested against lag-compensated history
+    uint64_t time_usec = 0;
+};
+
+// Swept-ray collision for every live projectile, run once per physics tick.
+//
+// Each projectile is tested along the segment from where it was at its swept
+// time to where it is now, so projectiles deferred by the per-tick caps sweep
+// their whole missed path on the next tick instead of tunnelling. The
+// broadphase first drops projectiles that cannot reach any collider; those
+// are neither evaluated nor counted against the caps.
+//
+// With a DamageSystem, segments are resolved in batches: first against its
+// hurtbox tree, then with a physics ray only where the broadphase puts world
+// geometry or other bodies along the segment. That ray stops at the hurtbox
+// hit and passes through bodies that have a hurtbox, which the tree resolves.
+class ProjectileCollisionStage {
+private:
+    struct PendingSegment {
+        uint32_t index;
+        float from[3];
+        float to[3];
+        bool world_ray; // Needs a physics ray besides the hurtbox query
+    };
+
+    Ref<PhysicsRayQueryParameters3D> query;
+
+    // Exclusion list of the shooter currently bound to the query
+    uint32_t exclude_shooter = 0;
+    uint64_t exclude_body_id = 0;
+    TypedArray<RID> exclude;
+
+    uint32_t cursor = 0; // Round-robin start so deferred projectiles go first next tick
+    uint32_t max_raycasts_per_tick = 0; // 0 means unlimited
+    uint64_t max_time_usec = 0; // 0 means unlimited
+    uint32_t collision_mask = 0xFFFFFFFF;
+
+    ProjectileBroadphase broadphase;
+
+    // Batch scratch, one entry per tested segment. Like the hits, it lives in
+    // the frame arena and is handed back by release_frame_data().
+    FrameVector<PendingSegment> pending;
+    FrameVector<HurtboxTree::Segment> hurtbox_segments;
+    FrameVector<HurtboxTree::Hit> hurtbox_hits;
+
+    FrameVector<ProjectileHit> hits;
+    FrameVector<ProjectileHit> hitscan_hits;
+    ProjectileCollisionStats stats;
+
+    void bind_shooter(uint32_t p_shooter);
+    void resolve_pending(PhysicsDirectSpaceState3D *p_space, ProjectilePool &p_pool, const DamageSystem *p_damage_system);
+
+public:
+    ProjectileCollisionStage();
+
+    // Resets the stats shared by both passes
+    void begin_tick();
+
+    // Sweeps the pool against p_space, and against the hurtboxes of
+    // p_damage_system when given. Hits are sorted by projectile index.
+    void run(PhysicsDirectSpaceState3D *p_space, ProjectilePool &p_pool, const DamageSystem *p_damage_system = nullptr);
+
+    // Resolves every hitscan shot of the tick in one pass. Shots are visited
+    // in shooter order so the exclusion list is rebuilt once per shooter.
+    // Shots with a rewind time are tested against p_lag_compensation history
+    // for tracked bodies and against the live world for everything else.
+    // Hits carry the batch index and an invalid projectile id.
+    void run_hitscan(PhysicsDirectSpaceState3D *p_space, const FrameVector<HitscanRequest> &p_batch, const LagCompensation *p_lag_compensation = nullptr);
+
+    // Hits stay valid until release_frame_data(), which must be called before
+    // the frame arena of this thread is reset
+    const FrameVector<ProjectileHit> &get_hits() const { return hits; }
+    const FrameVector<ProjectileHit> &get_hitscan_hits() const { return hitscan_hits; }
+    void release_frame_data();
+    const ProjectileCollisionStats &get_stats() const { return stats; }
+
+    ProjectileBroadphase &get_broadphase() { return broadphase; }
+    const ProjectileBroadphase &get_broadphase() const { return broadphase; }
+
+    // Part of the simulation state, the cursor decides which projectiles are deferred
+    uint32_t get_cursor() const { return cursor; }
+    void set_cursor(uint32_t p_cursor) { cursor = p_cursor; }
+
+    uint32_t get_max_raycasts_per_tick() const { return max_raycasts_per_tick; }
+    void set_max_raycasts_per_tick(uint32_t p_max) { max_raycasts_per_tick = p_max; }
+    uint64_t get_max_time_usec() const { return max_time_usec; }
+    void set_max_time_usec(uint64_t p_usec) { max_time_usec = p_usec; }
+    uint32_t get_collision_mask() const { return collision_mask; }
+    void set_collision_mask(uint32_t p_mask) { collision_mask = p_mask; }
+};
+
+}
+
+#endif // PROJECTILE_COLLISION_H
@@ -0,0 +1,249 @@
+#include "projectile_kernels.hpp"
+#include "projectile_pool.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PROJECTILE_KERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit vector instructions in functions that opt into
+// them; MSVC accepts the intrinsics anywhere.
+#if defined(PROJECTILE_KERNELS_X86) && (defined(__GNUC__) || defined(__clang__))
+#define KERNEL_TARGET(m_isa) __attribute__((target(m_isa)))
+#else
+#define KERNEL_TARGET(m_isa)
+#endif
+
+using namespace godot;
+
+ProjectileKernels::Streams ProjectileKernels::get_streams(ProjectilePool &p_pool) {
+    Streams streams;
+    streams.speed = p_pool.speed.data();
+    streams.max_range = p_pool.max_range.data();
+    streams.traveled = p_pool.traveled.data();
+    return streams;
+}
+
+// ================ CPU DETECTION ================
+
+static ProjectileKernels::Isa detect_isa() {
+#if defined(PROJECTILE_KERNELS_X86)
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    int max_leaf = info[0];
+
+    __cpuid(info, 1);
+    bool has_sse2 = (info[3] & (1 << 26)) != 0;
+    bool has_osxsave = (info[2] & (1 << 27)) != 0;
+    bool has_avx = (info[2] & (1 << 28)) != 0;
+
+    bool has_avx2 = false;
+    if (max_leaf >= 7 && has_osxsave && has_avx) {
+        __cpuidex(info, 7, 0);
+        // The OS must also save the YMM registers on context switches
+        bool ymm_enabled = (_xgetbv(0) & 0x6) == 0x6;
+        has_avx2 = ymm_enabled && (info[1] & (1 << 5)) != 0;
+    }
+#else
+    __builtin_cpu_init();
+    bool has_sse2 = __builtin_cpu_supports("sse2");
+    bool has_avx2 = __builtin_cpu_supports("avx2");
+#endif
+    if (has_avx2) {
+        return ProjectileKernels::ISA_AVX2;
+    }
+    if (has_sse2) {
+        return ProjectileKernels::ISA_SSE2;
+    }
+#endif
+    return ProjectileKernels::ISA_SCALAR;
+}
+
+ProjectileKernels::Isa ProjectileKernels::get_best_isa() {
+    static const Isa best = detect_isa();
+    return best;
+}
+
+ProjectileKernels::Isa ProjectileKernels::resolve_isa(Isa p_isa) {
+    Isa best = get_best_isa();
+    return p_isa > best ? best : p_isa;
+}
+
+ProjectileKernels::IntegrateFunc ProjectileKernels::get_integrate_func(Isa p_isa) {
+    switch (resolve_isa(p_isa)) {
+        case ISA_AVX2:
+            return &ProjectileKernels::integrate_avx2;
+        case ISA_SSE2:
+            return &ProjectileKernels::integrate_sse2;
+        case ISA_SCALAR:
+        default:
+            return &ProjectileKernels::integrate_scalar;
+    }
+}
+
+const char *ProjectileKernels::get_isa_name(Isa p_isa) {
+    switch (p_isa) {
+        case ISA_AVX2:
+            return "avx2";
+        case ISA_SSE2:
+            return "sse2";
+        case ISA_SCALAR:
+        default:
+            return "scalar";
+    }
+}
+
+// ================ VALIDATION ================
+
+bool ProjectileKernels::matches_scalar(Isa p_isa) {
+    // Not a multiple of any vector width, so the tail handling is covered too
+    const uint32_t count = 1003;
+    const float delta = 1.0f / 60.0f;
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> speed(40.0f, 400.0f);
+    std::uniform_real_distribution<float> range(50.0f, 300.0f);
+
+    ProjectilePool reference;
+    ProjectilePool candidate;
+    reference.reset(count);
+    candidate.reset(count);
+    for (uint32_t i = 0; i < count; i++) {
+        ProjectilePool::SpawnParams params;
+        float dir[3] = { unit(rng), unit(rng), unit(rng) };
+        float len = std::sqrt(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+        if (len < 1e-3f) {
+            dir[2] = len = 1.0f;
+        }
+        for (int axis = 0; axis < 3; axis++) {
+            params.position[axis] = unit(rng) * 100.0f;
+            params.direction[axis] = dir[axis] / len;
+        }
+        params.speed = speed(rng);
+        params.max_range = range(rng);
+        reference.spawn(params);
+        candidate.spawn(params);
+    }
+
+    Streams ref_streams = get_streams(reference);
+    Streams cand_streams = get_streams(candidate);
+    IntegrateFunc integrate = get_integrate_func(p_isa);
+    std::vector<uint32_t> ref_expired(count);
+    std::vector<uint32_t> cand_expired(count);
+
+    // Long enough for every projectile to pass its range
+    for (int tick = 0; tick < 120; tick++) {
+        uint32_t ref_count = integrate_scalar(ref_streams, 0, count, delta, ref_expired.data());
+        uint32_t cand_count = integrate(cand_streams, 0, count, delta, cand_expired.data());
+        if (ref_count != cand_count || std::memcmp(ref_expired.data(), cand_expired.data(), ref_count * sizeof(uint32_t)) != 0) {
+            return false;
+        }
+        if (std::memcmp(reference.traveled.data(), candidate.traveled.data(), count * sizeof(float)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ================ KERNELS ================
+
+uint32_t ProjectileKernels::integrate_scalar(const Streams &p_streams, uint32_t p_begin, uint32_t p_end, float p_delta, uint32_t *r_expired) {
+    uint32_t expired_count = 0;
+
+    for (uint32_t i = p_begin; i < p_end; i++) {
+        float traveled = p_streams.traveled[i] + p_streams.speed[i] * p_delta;
+        p_streams.traveled[i] = traveled;
+
+        if (traveled >= p_streams.max_range[i]) {
+            r_expired[expired_count++] = i;
+        }
+    }
+
+    return expired_count;
+}
+
+#if defined(PROJECTILE_KERNELS_X86)
+
+static inline int lowest_set_bit(int p_mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward(&index, (unsigned long)p_mask);
+    return (int)index;
+#else
+    return __builtin_ctz((unsigned int)p_mask);
+#endif
+}
+
+KERNEL_TARGET("sse2")
+uint32_t ProjectileKernels::integrate_sse2(const Streams &p_streams, uint32_t p_begin, uint32_t p_end, float p_delta, uint32_t *r_expired) {
+    uint32_t expired_count = 0;
+    const __m128 delta = _mm_set1_ps(p_delta);
+
+    uint32_t i = p_begin;
+    for (; i + 4 <= p_end; i += 4) {
+        __m128 traveled = _mm_add_ps(_mm_loadu_ps(p_streams.traveled + i), _mm_mul_ps(_mm_loadu_ps(p_streams.speed + i), delta));
+        _mm_storeu_ps(p_streams.traveled + i, traveled);
+
+        // Expirations are rare, so only pay for the compaction when a lane fires
+        int mask = _mm_movemask_ps(_mm_cmpge_ps(traveled, _mm_loadu_ps(p_streams.max_range + i)));
+        while (mask) {
+            int lane = lowest_set_bit(mask);
+            r_expired[expired_count++] = i + lane;
+            mask &= mask - 1;
+        }
+    }
+
+    if (i < p_end) {
+        expired_count += integrate_scalar(p_streams, i, p_end, p_delta, r_expired + expired_count);
+    }
+
+    return expired_count;
+}
+
+KERNEL_TARGET("avx2")
+uint32_t ProjectileKernels::integrate_avx2(const Streams &p_streams, uint32_t p_begin, uint32_t p_end, float p_delta, uint32_t *r_expired) {
+    uint32_t expired_count = 0;
+    const __m256 delta = _mm256_set1_ps(p_delta);
+
+    uint32_t i = p_begin;
+    for (; i + 8 <= p_end; i += 8) {
+        __m256 traveled = _mm256_add_ps(_mm256_loadu_ps(p_streams.traveled + i), _mm256_mul_ps(_mm256_loadu_ps(p_streams.speed + i), delta));
+        _mm256_storeu_ps(p_streams.traveled + i, traveled);
+
+        int mask = _mm256_movemask_ps(_mm256_cmp_ps(traveled, _mm256_loadu_ps(p_streams.max_range + i), _CMP_GE_OQ));
+        while (mask) {
+            int lane = lowest_set_bit(mask);
+            r_expired[expired_count++] = i + lane;
+            mask &= mask - 1;
+        }
+    }
+
+    if (i < p_end) {
+        expired_count += integrate_sse2(p_streams, i, p_end, p_delta, r_expired + expired_count);
+    }
+
+    return expired_count;
+}
+
+#else
+
+// No vector path on this architecture, the dispatcher never selects these
+uint32_t ProjectileKernels::integrate_sse2(const Streams &p_streams, uint32_t p_begin, uint32_t p_end, float p_delta, uint32_t *r_expired) {
+    return integrate_scalar(p_streams, p_begin, p_end, p_delta, r_expired);
+}
+
+uint32_t ProjectileKernels::integrate_avx2(const Streams &p_streams, uint32_t p_begin, uint32_t p_end, float p_delta, uint32_t *r_expired) {
+    return integrate_scalar(p_streams, p_begin, p_end, p_delta, r_expired);
+}
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef PROJECTILE_KERNELS_H
+#define PROJECTILE_KERNELS_H
+
+#include <cstdint>
+
+namespace godot {
+
+class ProjectilePool;
+
+// Batch integration kernels for the projectile SoA streams.
+//
+// Positions are analytic (see ProjectileBallistics), so the only per-tick
+// work left is range bookkeeping: each kernel accumulates the traveled
+// distance and writes the dense indices of projectiles that went past their
+// range to r_expired in ascending order. All variants perform the same float
+// operations in the same order, so they produce identical results.
+class ProjectileKernels {
+public:
+    enum Isa {
+        ISA_SCALAR,
+        ISA_SSE2,
+        ISA_AVX2,
+    };
+
+    struct Streams {
+        const float *speed = nullptr;
+        const float *max_range = nullptr;
+        float *traveled = nullptr;
+    };
+
+    // Processes [p_begin, p_end) and returns the number of indices written
+    // to r_expired, which must have room for p_end - p_begin entries.
+    typedef uint32_t (*IntegrateFunc)(const Streams &p_streams, uint32_t p_begin, uint32_t p_end, float p_delta, uint32_t *r_expired);
+
+    static Streams get_streams(ProjectilePool &p_pool);
+
+    // Best instruction set supported by both the build and the running CPU
+    static Isa get_best_isa();
+    // Falls back to the best supported ISA when p_isa is not available
+    static Isa resolve_isa(Isa p_isa);
+    static IntegrateFunc get_integrate_func(Isa p_isa);
+    static const char *get_isa_name(Isa p_isa);
+
+    // Runs p_isa and the scalar kernel side by side over a fixed set of
+    // projectiles and returns whether every tick's output is bit-identical
+    static bool matches_scalar(Isa p_isa);
+
+    static uint32_t integrate_scalar(const Streams &p_streams, uint32_t p_begin, uint32_t p_end, float p_delta, uint32_t *r_expired);
+    static uint32_t integrate_sse2(const Streams &p_streams, uint32_t p_begin, uint32_t p_end, float p_delta, uint32_t *r_expired);
+    static uint32_t integrate_avx2(const Streams &p_streams, uint32_t p_begin, uint32_t p_end, float p_delta, uint32_t *r_expired);
+};
+
+}
+
+#endif // PROJECTILE_KERNELS_H
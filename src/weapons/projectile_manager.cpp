@@ -1,163 +1,1046 @@
 #include "projectile_manager.hpp"
+#include "../bots/bot_crowd.hpp"
+#include "../combat/damage_system.hpp"
+#include "../combat/entities.hpp"
+#include "../combat/lag_compensation.hpp"
+#include "../debug/perf_monitors.hpp"
+#include "../debug/trace.hpp"
+#include <godot_cpp/classes/array_mesh.hpp>
+#include <godot_cpp/classes/box_mesh.hpp>
+#include <godot_cpp/classes/collision_object3d.hpp>
+#include <godot_cpp/classes/collision_shape3d.hpp>
+#include <godot_cpp/classes/project_settings.hpp>
 #include <godot_cpp/classes/rendering_server.hpp>
+#include <godot_cpp/classes/scene_tree.hpp>
+#include <godot_cpp/classes/shape3d.hpp>
+#include <godot_cpp/classes/time.hpp>
+#include <godot_cpp/classes/visual_instance3d.hpp>
 #include <godot_cpp/classes/world3d.hpp>
 #include <godot_cpp/classes/viewport.hpp>
+#include <godot_cpp/classes/worker_thread_pool.hpp>
+#include <godot_cpp/classes/world_boundary_shape3d.hpp>
+#include <godot_cpp/variant/callable_method_pointer.hpp>
+
+#include <cmath>
+#include <cstring>
 
 using namespace godot;
 
 ProjectileManager* ProjectileManager::singleton = nullptr;
 
+static const char *PARALLEL_CHUNK_SIZE_SETTING = "godotcon2024/projectiles/parallel_chunk_size";
+
+// Enough for a few ticks of heavy fire; overflows are counted, never blocked on
+static const uint32_t SPAWN_QUEUE_CAPACITY = 4096;
+static const uint32_t HIT_EVENT_CAPACITY = 4096;
+static const uint32_t HITSCAN_QUEUE_CAPACITY = 4096;
+
+static const uint32_t STATE_MAGIC = 0x52474D50; // "PMGR"
+static const uint32_t STATE_VERSION = 1;
+
+struct ManagerStateHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t physics_tick;
+    uint32_t collision_cursor;
+    uint32_t reserved;
+};
+
+// After weapons, so shots fired this tick resolve this tick; before the DamageSystem flush
+static const int SIMULATION_PROCESS_PRIORITY = 100;
+
 ProjectileManager::ProjectileManager() {
     singleton = this;
+    set_integration_kernel(KERNEL_AUTO);
+    apply_ballistics();
+
+    // Allocated before any weapon can fire, and never resized while producers run
+    spawn_queue.reset(SPAWN_QUEUE_CAPACITY);
+    hitscan_queue.reset(HITSCAN_QUEUE_CAPACITY);
+    hit_events.reset(HIT_EVENT_CAPACITY);
 }
 
 ProjectileManager::~ProjectileManager() {
+    free_projectile_visuals();
     singleton = nullptr;
 }
 
 void ProjectileManager::_bind_methods() {
-    ClassDB::bind_method(D_METHOD("create_projectile"), &ProjectileManager::create_projectile);
+    ClassDB::bind_method(D_METHOD("create_projectile", "start_pos", "direction", "speed", "damage", "shooter", "max_range"), &ProjectileManager::create_projectile, DEFVAL(100.0));
+    ClassDB::bind_method(D_METHOD("queue_hitscan", "origin", "direction", "range", "damage", "shooter"), &ProjectileManager::queue_hitscan);
+    ClassDB::bind_method(D_METHOD("queue_rewound_hitscan", "origin", "direction", "range", "damage", "shooter", "fire_time"), &ProjectileManager::queue_rewound_hitscan);
+    ClassDB::bind_method(D_METHOD("create_projectiles", "origins", "directions", "speeds", "damages", "ranges", "shooter"), &ProjectileManager::create_projectiles);
+    ClassDB::bind_method(D_METHOD("get_projectile_positions"), &ProjectileManager::get_projectile_positions);
+    ClassDB::bind_method(D_METHOD("get_projectile_directions"), &ProjectileManager::get_projectile_directions);
+    ClassDB::bind_method(D_METHOD("get_projectile_ids"), &ProjectileManager::get_projectile_ids);
+    ClassDB::bind_method(D_METHOD("get_active_projectile_count"), &ProjectileManager::get_active_projectile_count);
+
+    ClassDB::bind_method(D_METHOD("get_max_projectiles"), &ProjectileManager::get_max_projectiles);
+    ClassDB::bind_method(D_METHOD("set_max_projectiles", "max_projectiles"), &ProjectileManager::set_max_projectiles);
+    ClassDB::bind_method(D_METHOD("get_pool_full_policy"), &ProjectileManager::get_pool_full_policy);
+    ClassDB::bind_method(D_METHOD("set_pool_full_policy", "policy"), &ProjectileManager::set_pool_full_policy);
+    ClassDB::bind_method(D_METHOD("get_integration_kernel"), &ProjectileManager::get_integration_kernel);
+    ClassDB::bind_method(D_METHOD("set_integration_kernel", "kernel"), &ProjectileManager::set_integration_kernel);
+    ClassDB::bind_method(D_METHOD("get_active_kernel_name"), &ProjectileManager::get_active_kernel_name);
+    ClassDB::bind_method(D_METHOD("get_parallel_update"), &ProjectileManager::get_parallel_update);
+    ClassDB::bind_method(D_METHOD("set_parallel_update", "enable"), &ProjectileManager::set_parallel_update);
+    ClassDB::bind_method(D_METHOD("get_max_raycasts_per_tick"), &ProjectileManager::get_max_raycasts_per_tick);
+    ClassDB::bind_method(D_METHOD("set_max_raycasts_per_tick", "max_raycasts"), &ProjectileManager::set_max_raycasts_per_tick);
+    ClassDB::bind_method(D_METHOD("get_max_collision_time_usec"), &ProjectileManager::get_max_collision_time_usec);
+    ClassDB::bind_method(D_METHOD("set_max_collision_time_usec", "usec"), &ProjectileManager::set_max_collision_time_usec);
+    ClassDB::bind_method(D_METHOD("get_collision_mask"), &ProjectileManager::get_collision_mask);
+    ClassDB::bind_method(D_METHOD("set_collision_mask", "mask"), &ProjectileManager::set_collision_mask);
+    ClassDB::bind_method(D_METHOD("get_broadphase_lookahead"), &ProjectileManager::get_broadphase_lookahead);
+    ClassDB::bind_method(D_METHOD("set_broadphase_lookahead", "seconds"), &ProjectileManager::set_broadphase_lookahead);
+    ClassDB::bind_method(D_METHOD("get_max_target_speed"), &ProjectileManager::get_max_target_speed);
+    ClassDB::bind_method(D_METHOD("set_max_target_speed", "speed"), &ProjectileManager::set_max_target_speed);
+    ClassDB::bind_method(D_METHOD("get_use_hurtbox_tree"), &ProjectileManager::get_use_hurtbox_tree);
+    ClassDB::bind_method(D_METHOD("set_use_hurtbox_tree", "enable"), &ProjectileManager::set_use_hurtbox_tree);
+    ClassDB::bind_method(D_METHOD("refresh_colliders"), &ProjectileManager::refresh_colliders);
+    ClassDB::bind_method(D_METHOD("get_ballistic_gravity"), &ProjectileManager::get_ballistic_gravity);
+    ClassDB::bind_method(D_METHOD("set_ballistic_gravity", "gravity"), &ProjectileManager::set_ballistic_gravity);
+    ClassDB::bind_method(D_METHOD("get_ballistic_drag"), &ProjectileManager::get_ballistic_drag);
+    ClassDB::bind_method(D_METHOD("set_ballistic_drag", "drag"), &ProjectileManager::set_ballistic_drag);
+    ClassDB::bind_method(D_METHOD("get_collision_stats"), &ProjectileManager::get_collision_stats);
+    ClassDB::bind_method(D_METHOD("get_pool_high_water"), &ProjectileManager::get_pool_high_water);
+    ClassDB::bind_method(D_METHOD("get_spawned_last_tick"), &ProjectileManager::get_spawned_last_tick);
+    ClassDB::bind_method(D_METHOD("get_expired_last_tick"), &ProjectileManager::get_expired_last_tick);
+    ClassDB::bind_method(D_METHOD("get_hits_last_tick"), &ProjectileManager::get_hits_last_tick);
+    ClassDB::bind_method(D_METHOD("get_orphaned_last_tick"), &ProjectileManager::get_orphaned_last_tick);
+    ClassDB::bind_method(D_METHOD("get_update_usec_last_tick"), &ProjectileManager::get_update_usec_last_tick);
+    ClassDB::bind_method(D_METHOD("get_collision_usec_last_tick"), &ProjectileManager::get_collision_usec_last_tick);
+    ClassDB::bind_method(D_METHOD("get_frame_arena_peak_bytes"), &ProjectileManager::get_frame_arena_peak_bytes);
+    ClassDB::bind_method(D_METHOD("get_frame_arena_allocations_last_tick"), &ProjectileManager::get_frame_arena_allocations_last_tick);
+    ClassDB::bind_method(D_METHOD("get_queue_stats"), &ProjectileManager::get_queue_stats);
+    ClassDB::bind_method(D_METHOD("update_projectiles", "delta"), &ProjectileManager::update_projectiles);
+    ClassDB::bind_method(D_METHOD("save_state"), &ProjectileManager::save_state);
+    ClassDB::bind_method(D_METHOD("load_state", "state"), &ProjectileManager::load_state);
+    ClassDB::bind_method(D_METHOD("get_projectile_mesh"), &ProjectileManager::get_projectile_mesh);
+    ClassDB::bind_method(D_METHOD("set_projectile_mesh", "mesh"), &ProjectileManager::set_projectile_mesh);
+    ClassDB::bind_method(D_METHOD("get_projectile_material"), &ProjectileManager::get_projectile_material);
+    ClassDB::bind_method(D_METHOD("set_projectile_material", "material"), &ProjectileManager::set_projectile_material);
+    ClassDB::bind_method(D_METHOD("get_projectile_visual_length"), &ProjectileManager::get_projectile_visual_length);
+    ClassDB::bind_method(D_METHOD("set_projectile_visual_length", "length"), &ProjectileManager::set_projectile_visual_length);
+    ClassDB::bind_method(D_METHOD("get_poison_frame_arena"), &ProjectileManager::get_poison_frame_arena);
+    ClassDB::bind_method(D_METHOD("set_poison_frame_arena", "enable"), &ProjectileManager::set_poison_frame_arena);
+
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "max_projectiles", PROPERTY_HINT_RANGE, "1,100000,1,or_greater"), "set_max_projectiles", "get_max_projectiles");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "pool_full_policy", PROPERTY_HINT_ENUM, "Drop,Evict Oldest,Grow"), "set_pool_full_policy", "get_pool_full_policy");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "integration_kernel", PROPERTY_HINT_ENUM, "Auto:-1,Scalar:0,SSE2:1,AVX2:2"), "set_integration_kernel", "get_integration_kernel");
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "parallel_update"), "set_parallel_update", "get_parallel_update");
+
+    ADD_GROUP("Collision", "");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "max_raycasts_per_tick", PROPERTY_HINT_RANGE, "0,100000,1,or_greater"), "set_max_raycasts_per_tick", "get_max_raycasts_per_tick");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "max_collision_time_usec", PROPERTY_HINT_RANGE, "0,100000,1,or_greater,suffix:us"), "set_max_collision_time_usec", "get_max_collision_time_usec");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "collision_mask", PROPERTY_HINT_LAYERS_3D_PHYSICS), "set_collision_mask", "get_collision_mask");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "broadphase_lookahead", PROPERTY_HINT_RANGE, "0.0,2.0,0.01,suffix:s"), "set_broadphase_lookahead", "get_broadphase_lookahead");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "max_target_speed", PROPERTY_HINT_RANGE, "0.0,100.0,0.1,or_greater,suffix:m/s"), "set_max_target_speed", "get_max_target_speed");
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "use_hurtbox_tree"), "set_use_hurtbox_tree", "get_use_hurtbox_tree");
+
+    ADD_GROUP("Ballistics", "ballistic_");
+    ADD_PROPERTY(PropertyInfo(Variant::VECTOR3, "ballistic_gravity"), "set_ballistic_gravity", "get_ballistic_gravity");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "ballistic_drag", PROPERTY_HINT_RANGE, "0.0,5.0,0.001,or_greater,suffix:1/s"), "set_ballistic_drag", "get_ballistic_drag");
+
+    ADD_GROUP("Visuals", "projectile_");
+    ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "projectile_mesh", PROPERTY_HINT_RESOURCE_TYPE, "Mesh"), "set_projectile_mesh", "get_projectile_mesh");
+    ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "projectile_material", PROPERTY_HINT_RESOURCE_TYPE, "Material"), "set_projectile_material", "get_projectile_material");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "projectile_visual_length", PROPERTY_HINT_RANGE, "0.01,10.0,0.01,suffix:m"), "set_projectile_visual_length", "get_projectile_visual_length");
+
+    ADD_GROUP("Debug", "");
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "poison_frame_arena"), "set_poison_frame_arena", "get_poison_frame_arena");
+
+    BIND_ENUM_CONSTANT(POOL_FULL_DROP);
+    BIND_ENUM_CONSTANT(POOL_FULL_EVICT_OLDEST);
+    BIND_ENUM_CONSTANT(POOL_FULL_GROW);
+
+    BIND_ENUM_CONSTANT(KERNEL_AUTO);
+    BIND_ENUM_CONSTANT(KERNEL_SCALAR);
+    BIND_ENUM_CONSTANT(KERNEL_SSE2);
+    BIND_ENUM_CONSTANT(KERNEL_AVX2);
+}
+
+void ProjectileManager::define_project_settings() {
+    ProjectSettings *settings = ProjectSettings::get_singleton();
+    if (!settings->has_setting(PARALLEL_CHUNK_SIZE_SETTING)) {
+        settings->set_setting(PARALLEL_CHUNK_SIZE_SETTING, 2048);
+    }
+    settings->set_initial_value(PARALLEL_CHUNK_SIZE_SETTING, 2048);
+
+    Dictionary info;
+    info["name"] = PARALLEL_CHUNK_SIZE_SETTING;
+    info["type"] = Variant::INT;
+    info["hint"] = PROPERTY_HINT_RANGE;
+    info["hint_string"] = "64,65536,1,or_greater";
+    settings->add_property_info(info);
+}
+
+void ProjectileManager::_notification(int p_what) {
+    if (p_what == NOTIFICATION_ENTER_TREE) {
+        add_monitors();
+        // The property may have been set on a loading thread
+        FrameArena::get_thread_arena().set_poisoning(poison_frame_arena);
+        get_tree()->connect("physics_frame", callable_mp(this, &ProjectileManager::on_physics_frame));
+    } else if (p_what == NOTIFICATION_EXIT_TREE) {
+        remove_monitors();
+        get_tree()->disconnect("physics_frame", callable_mp(this, &ProjectileManager::on_physics_frame));
+        on_physics_frame();
+    }
+}
+
+void ProjectileManager::add_monitors() {
+    PerfMonitors::add("Projectiles/Active", callable_mp(this, &ProjectileManager::get_active_projectile_count));
+    PerfMonitors::add("Projectiles/Pool High Water", callable_mp(this, &ProjectileManager::get_pool_high_water));
+    PerfMonitors::add("Projectiles/Spawns Per Tick", callable_mp(this, &ProjectileManager::get_spawned_last_tick));
+    PerfMonitors::add("Projectiles/Expirations Per Tick", callable_mp(this, &ProjectileManager::get_expired_last_tick));
+    PerfMonitors::add("Projectiles/Hits Per Tick", callable_mp(this, &ProjectileManager::get_hits_last_tick));
+    PerfMonitors::add("Projectiles/Orphaned Per Tick", callable_mp(this, &ProjectileManager::get_orphaned_last_tick));
+    PerfMonitors::add("Projectiles/Update Time (us)", callable_mp(this, &ProjectileManager::get_update_usec_last_tick));
+    PerfMonitors::add("Projectiles/Collision Time (us)", callable_mp(this, &ProjectileManager::get_collision_usec_last_tick));
+    PerfMonitors::add("Memory/Frame Arena Peak (bytes)", callable_mp(this, &ProjectileManager::get_frame_arena_peak_bytes));
+    PerfMonitors::add("Memory/Frame Arena Allocations Per Tick", callable_mp(this, &ProjectileManager::get_frame_arena_allocations_last_tick));
+}
+
+void ProjectileManager::remove_monitors() {
+    PerfMonitors::remove("Projectiles/Active");
+    PerfMonitors::remove("Projectiles/Pool High Water");
+    PerfMonitors::remove("Projectiles/Spawns Per Tick");
+    PerfMonitors::remove("Projectiles/Expirations Per Tick");
+    PerfMonitors::remove("Projectiles/Hits Per Tick");
+    PerfMonitors::remove("Projectiles/Orphaned Per Tick");
+    PerfMonitors::remove("Projectiles/Update Time (us)");
+    PerfMonitors::remove("Projectiles/Collision Time (us)");
+    PerfMonitors::remove("Memory/Frame Arena Peak (bytes)");
+    PerfMonitors::remove("Memory/Frame Arena Allocations Per Tick");
 }
 
 void ProjectileManager::_ready() {
-    // TODO: Get physics space from main scene
-    // physics_space = get_viewport()->get_world_3d()->get_direct_space_state();
-    
+    set_physics_process_priority(SIMULATION_PROCESS_PRIORITY);
+    parallel_chunk_size = MAX((int)ProjectSettings::get_singleton()->get_setting(PARALLEL_CHUNK_SIZE_SETTING, 2048), 64);
+
+    Ref<World3D> world = get_viewport()->find_world_3d();
+    if (world.is_valid()) {
+        physics_space = world->get_direct_space_state();
+    }
+
+    // Initialize projectile pool, all storage is allocated up front
+    pool.set_full_policy((ProjectilePool::FullPolicy)pool_full_policy);
+    pool.reset(max_projectiles);
+    expired.resize(max_projectiles);
+
     setup_projectile_visuals();
-    
-    // Initialize projectile pool
-    active_projectiles.resize(max_projectiles);
-    for (int i = 0; i < max_projectiles; i++) {
-        Dictionary projectile_dict;
-        projectile_dict["active"] = false;
-        active_projectiles[i] = projectile_dict;
+}
+
+void ProjectileManager::set_max_projectiles(int p_max) {
+    p_max = MAX(p_max, 1);
+
+    // Live projectiles keep flying, as when FULL_POLICY_GROW resizes the pool
+    if (is_node_ready()) {
+        ERR_FAIL_COND_MSG(!pool.set_capacity(p_max), vformat("ProjectileManager: Cannot shrink to %d, %d projectiles are in flight.", p_max, pool.get_count()));
+        expired.resize(pool.get_capacity());
+    }
+    max_projectiles = p_max;
+}
+
+void ProjectileManager::set_poison_frame_arena(bool p_enable) {
+    poison_frame_arena = p_enable;
+    FrameArena::get_thread_arena().set_poisoning(p_enable);
+}
+
+// SceneTree emits physics_frame before any node's physics step, so this runs
+// once everything of the previous tick, the DamageSystem flush included, is done
+void ProjectileManager::on_physics_frame() {
+    collision.release_frame_data();
+    frame_release(hitscan_batch);
+    frame_release(released);
+
+    FrameArena &arena = FrameArena::get_thread_arena();
+    arena.reset();
+    frame_arena_peak_bytes = arena.get_peak_last_tick();
+    frame_arena_allocations_last_tick = arena.get_block_allocations_last_tick();
+    TRACE_COUNTER("frame_arena_peak_bytes", frame_arena_peak_bytes);
+}
+
+void ProjectileManager::set_pool_full_policy(PoolFullPolicy p_policy) {
+    pool_full_policy = p_policy;
+    pool.set_full_policy((ProjectilePool::FullPolicy)p_policy);
+}
+
+void ProjectileManager::set_integration_kernel(IntegrationKernel p_kernel) {
+    integration_kernel = p_kernel;
+
+    ProjectileKernels::Isa isa = p_kernel == KERNEL_AUTO ? ProjectileKernels::get_best_isa() : (ProjectileKernels::Isa)p_kernel;
+    integrate_func = ProjectileKernels::get_integrate_func(isa);
+
+#ifdef DEBUG_ENABLED
+    ProjectileKernels::Isa resolved = ProjectileKernels::resolve_isa(isa);
+    if (resolved != ProjectileKernels::ISA_SCALAR && !ProjectileKernels::matches_scalar(resolved)) {
+        ERR_PRINT(String("ProjectileManager: The ") + ProjectileKernels::get_isa_name(resolved) + " kernel disagrees with the scalar path.");
     }
+#endif
+}
+
+void ProjectileManager::set_ballistic_gravity(const Vector3 &p_gravity) {
+    ballistic_gravity = p_gravity;
+    apply_ballistics();
+}
+
+void ProjectileManager::set_ballistic_drag(double p_drag) {
+    ballistic_drag = MAX(p_drag, 0.0);
+    apply_ballistics();
+}
+
+void ProjectileManager::apply_ballistics() {
+    ProjectileBallistics ballistics;
+    ballistics.gravity[0] = ballistic_gravity.x;
+    ballistics.gravity[1] = ballistic_gravity.y;
+    ballistics.gravity[2] = ballistic_gravity.z;
+    ballistics.drag = ballistic_drag;
+    pool.set_ballistics(ballistics);
+}
+
+String ProjectileManager::get_active_kernel_name() const {
+    ProjectileKernels::Isa isa = integration_kernel == KERNEL_AUTO ? ProjectileKernels::get_best_isa() : (ProjectileKernels::Isa)integration_kernel;
+    return ProjectileKernels::get_isa_name(ProjectileKernels::resolve_isa(isa));
 }
 
 void ProjectileManager::create_projectile(Vector3 start_pos, Vector3 direction, double speed, double damage, Node* shooter, double max_range) {
-    // Find next available projectile slot
-    int start_index = next_projectile_index;
-    do {
-        Dictionary projectile_dict = active_projectiles[next_projectile_index];
-        if (!projectile_dict["active"]) {
-            // Found available slot
-            projectile_dict["position"] = start_pos;
-            projectile_dict["direction"] = direction.normalized();
-            projectile_dict["speed"] = speed;
-            projectile_dict["damage"] = damage;
-            projectile_dict["max_range"] = max_range;
-            projectile_dict["traveled_distance"] = 0.0;
-            projectile_dict["shooter"] = Variant(shooter);
-            projectile_dict["active"] = true;
-            
-            // TODO: Create visual representation
-            update_projectile_visual(next_projectile_index);
-            
-            next_projectile_index = (next_projectile_index + 1) % max_projectiles;
-            return;
-        }
-        
-        next_projectile_index = (next_projectile_index + 1) % max_projectiles;
-    } while (next_projectile_index != start_index);
-    
-    // No available slots - oldest projectile gets replaced
-    // TODO: Log warning about projectile limit reached
+    ProjectileData data;
+    data.position = start_pos;
+    data.direction = direction;
+    data.speed = speed;
+    data.damage = damage;
+    data.max_range = max_range;
+    data.shooter = Entities::find_or_register(shooter);
+
+    spawn_projectile(data);
+}
+
+int ProjectileManager::create_projectiles(const PackedVector3Array &origins, const PackedVector3Array &directions, const PackedFloat32Array &speeds, const PackedFloat32Array &damages, const PackedFloat32Array &ranges, Node* shooter) {
+    int64_t count = origins.size();
+    ERR_FAIL_COND_V_MSG(directions.size() != count, 0, "ProjectileManager: origins and directions must have the same size.");
+    ERR_FAIL_COND_V_MSG(speeds.size() != count && speeds.size() != 1, 0, "ProjectileManager: speeds needs one value per projectile or a single value.");
+    ERR_FAIL_COND_V_MSG(damages.size() != count && damages.size() != 1, 0, "ProjectileManager: damages needs one value per projectile or a single value.");
+    ERR_FAIL_COND_V_MSG(ranges.size() != count && ranges.size() != 1, 0, "ProjectileManager: ranges needs one value per projectile or a single value.");
+
+    const Vector3 *origin = origins.ptr();
+    const Vector3 *direction = directions.ptr();
+    const float *speed = speeds.ptr();
+    const float *damage = damages.ptr();
+    const float *range = ranges.ptr();
+    int speed_step = speeds.size() == 1 ? 0 : 1;
+    int damage_step = damages.size() == 1 ? 0 : 1;
+    int range_step = ranges.size() == 1 ? 0 : 1;
+
+    ProjectilePool::SpawnParams params;
+    params.shooter = Entities::find_or_register(shooter);
+
+    int queued = 0;
+    for (int64_t i = 0; i < count; i++) {
+        Vector3 dir = direction[i].normalized();
+        params.position[0] = origin[i].x;
+        params.position[1] = origin[i].y;
+        params.position[2] = origin[i].z;
+        params.direction[0] = dir.x;
+        params.direction[1] = dir.y;
+        params.direction[2] = dir.z;
+        params.speed = speed[i * speed_step];
+        params.damage = damage[i * damage_step];
+        params.max_range = range[i * range_step];
+        if (!spawn_queue.push(params)) {
+            WARN_PRINT_ONCE("ProjectileManager: Spawn queue is full, dropping projectiles");
+            break;
+        }
+        queued++;
+    }
+    return queued;
+}
+
+PackedVector3Array ProjectileManager::get_projectile_positions() const {
+    PackedVector3Array positions;
+    positions.resize(pool.get_count());
+    Vector3 *out = positions.ptrw();
+    for (uint32_t i = 0; i < pool.get_count(); i++) {
+        float position[3];
+        pool.get_position(i, pool.get_time(), position);
+        out[i] = Vector3(position[0], position[1], position[2]);
+    }
+    return positions;
+}
+
+PackedVector3Array ProjectileManager::get_projectile_directions() const {
+    PackedVector3Array directions;
+    directions.resize(pool.get_count());
+    Vector3 *out = directions.ptrw();
+    for (uint32_t i = 0; i < pool.get_count(); i++) {
+        float velocity[3];
+        pool.get_velocity(i, pool.get_time(), velocity);
+        Vector3 direction(velocity[0], velocity[1], velocity[2]);
+        out[i] = direction.is_zero_approx() ? Vector3(pool.dir_x[i], pool.dir_y[i], pool.dir_z[i]) : direction.normalized();
+    }
+    return directions;
+}
+
+PackedInt32Array ProjectileManager::get_projectile_ids() const {
+    PackedInt32Array ids;
+    ids.resize(pool.get_count());
+    if (pool.get_count() > 0) {
+        memcpy(ids.ptrw(), pool.id.data(), pool.get_count() * sizeof(uint32_t));
+    }
+    return ids;
+}
+
+void ProjectileManager::spawn_projectile(const ProjectileData &data) {
+    Vector3 direction = data.direction.normalized();
+
+    ProjectilePool::SpawnParams params;
+    params.position[0] = data.position.x;
+    params.position[1] = data.position.y;
+    params.position[2] = data.position.z;
+    params.direction[0] = direction.x;
+    params.direction[1] = direction.y;
+    params.direction[2] = direction.z;
+    params.speed = data.speed;
+    params.damage = data.damage;
+    params.max_range = data.max_range;
+    params.shooter = data.shooter;
+
+    // The pool is only touched by the simulation, so this is safe from any thread
+    if (!spawn_queue.push(params)) {
+        WARN_PRINT_ONCE("ProjectileManager: Spawn queue is full, dropping projectile");
+    }
+}
+
+void ProjectileManager::queue_shots(const std::vector<ScheduledShot> &shots, bool hitscan, double speed, double damage, double range, uint32_t shooter) {
+    uint32_t dropped = 0;
+
+    for (const ScheduledShot &shot : shots) {
+        Vector3 direction = shot.direction.normalized();
+        if (hitscan) {
+            HitscanRequest request;
+            request.origin[0] = shot.origin.x;
+            request.origin[1] = shot.origin.y;
+            request.origin[2] = shot.origin.z;
+            request.direction[0] = direction.x;
+            request.direction[1] = direction.y;
+            request.direction[2] = direction.z;
+            request.range = range;
+            request.damage = damage;
+            request.shooter = shooter;
+            request.rewind_time = 0.0;
+            dropped += !hitscan_queue.push(request);
+        } else {
+            ProjectilePool::SpawnParams params;
+            params.position[0] = shot.origin.x;
+            params.position[1] = shot.origin.y;
+            params.position[2] = shot.origin.z;
+            params.direction[0] = direction.x;
+            params.direction[1] = direction.y;
+            params.direction[2] = direction.z;
+            params.speed = speed;
+            params.damage = damage;
+            params.max_range = range;
+            params.shooter = shooter;
+            params.delay = shot.delay;
+            dropped += !spawn_queue.push(params);
+        }
+    }
+
+    if (dropped > 0) {
+        WARN_PRINT_ONCE("ProjectileManager: Shot queue is full, dropping shots");
+    }
+}
+
+void ProjectileManager::queue_hitscan(Vector3 origin, Vector3 direction, double range, double damage, Node* shooter) {
+    queue_rewound_hitscan(origin, direction, range, damage, shooter, 0.0);
+}
+
+void ProjectileManager::queue_rewound_hitscan(Vector3 origin, Vector3 direction, double range, double damage, Node* shooter, double fire_time) {
+    direction = direction.normalized();
+
+    HitscanRequest request;
+    request.origin[0] = origin.x;
+    request.origin[1] = origin.y;
+    request.origin[2] = origin.z;
+    request.direction[0] = direction.x;
+    request.direction[1] = direction.y;
+    request.direction[2] = direction.z;
+    request.range = range;
+    request.damage = damage;
+    request.shooter = Entities::find_or_register(shooter);
+    request.rewind_time = fire_time;
+
+    if (!hitscan_queue.push(request)) {
+        WARN_PRINT_ONCE("ProjectileManager: Hitscan queue is full, dropping shot");
+    }
+}
+
+void ProjectileManager::drain_spawn_queue() {
+    spawn_queue.sample_depth();
+
+    ProjectilePool::SpawnParams params;
+    spawned_last_tick = 0;
+    while (spawn_queue.pop(params)) {
+        if (pool.spawn(params) == ProjectilePool::INVALID_ID) {
+            WARN_PRINT_ONCE("ProjectileManager: Projectile pool is full, dropping projectile");
+            continue;
+        }
+        spawned_last_tick++;
+    }
+}
+
+void ProjectileManager::resolve_hitscan() {
+    hitscan_queue.sample_depth();
+
+    hitscan_batch.clear();
+    HitscanRequest request;
+    while (hitscan_queue.pop(request)) {
+        hitscan_batch.push_back(request);
+    }
+
+    collision.run_hitscan(physics_space, hitscan_batch, LagCompensation::get_singleton());
+}
+
+void ProjectileManager::publish_hit_events(const FrameVector<ProjectileHit> &hits) {
+    const EntityRegistry &registry = EntityRegistry::get_singleton();
+    for (const ProjectileHit &hit : hits) {
+        ProjectileHitEvent event;
+        event.tick = physics_tick;
+        event.collider_id = (uint64_t)hit.collider_id;
+        event.shooter_id = registry.get_object(hit.shooter);
+        event.point[0] = hit.point.x;
+        event.point[1] = hit.point.y;
+        event.point[2] = hit.point.z;
+        event.normal[0] = hit.normal.x;
+        event.normal[1] = hit.normal.y;
+        event.normal[2] = hit.normal.z;
+        event.damage = hit.damage;
+        event.projectile_id = hit.projectile_id;
+        hit_events.publish(event);
+    }
 }
 
 void ProjectileManager::_process(double delta) {
+    // Projectiles only move on physics ticks, skip uploads on frames in between
+    if (visuals_dirty) {
+        TRACE_SCOPE("ProjectileManager::update_visuals");
+        update_projectile_visuals();
+    }
+}
+
+void ProjectileManager::_physics_process(double delta) {
+    // The direct space state is only safe to use during the physics step
+    Ref<World3D> world = get_viewport()->find_world_3d();
+    physics_space = world.is_valid() ? world->get_direct_space_state() : nullptr;
+
     update_projectiles(delta);
 }
 
 void ProjectileManager::update_projectiles(double delta) {
-    if (!physics_space) return;
-    
-    for (int i = 0; i < max_projectiles; i++) {
-        Dictionary projectile_dict = active_projectiles[i];
-        if (!projectile_dict["active"]) continue;
-        
-        Vector3 current_pos = projectile_dict["position"];
-        Vector3 direction = projectile_dict["direction"];
-        double speed = projectile_dict["speed"];
-        double max_range = projectile_dict["max_range"];
-        double traveled = projectile_dict["traveled_distance"];
-        
-        // Calculate movement this frame
-        double distance_this_frame = speed * delta;
-        Vector3 new_pos = current_pos + direction * distance_this_frame;
-        
-        // Check range limit
-        double new_traveled = traveled + distance_this_frame;
-        if (new_traveled >= max_range) {
-            cleanup_projectile(i);
+    TRACE_SCOPE("ProjectileManager::update_projectiles");
+    uint64_t start_usec = Time::get_singleton()->get_ticks_usec();
+    physics_tick++;
+    collision.begin_tick();
+    drain_spawn_queue();
+
+    // Shooters that left the tree stop resolving; clear their handles in one pass
+    orphaned_last_tick = EntityRegistry::get_singleton().invalidate_stale(pool.shooter.data(), pool.get_count());
+
+    // Instant shots of the tick go first, in a single batch
+    {
+        TRACE_SCOPE("ProjectileManager::resolve_hitscan");
+        resolve_hitscan();
+    }
+
+    uint32_t count = pool.get_count();
+
+    // The pool may have grown since the last tick
+    if (expired.size() < pool.get_capacity()) {
+        expired.resize(pool.get_capacity());
+    }
+
+    // Positions follow from the clock; only range is accumulated per projectile
+    pool.advance_time(delta);
+    {
+        TRACE_SCOPE("ProjectileManager::integrate");
+        if (parallel_update && count > (uint32_t)parallel_chunk_size) {
+            integrate_parallel((float)delta);
+        } else {
+            integrate_serial((float)delta);
+        }
+    }
+
+    // Sweep every projectile from where it was last tested to where it is now
+    DamageSystem *damage_system = DamageSystem::get_singleton();
+    DamageSystem *hurtboxes = use_hurtbox_tree ? damage_system : nullptr;
+    {
+        TRACE_SCOPE("ProjectileManager::collide");
+        // The broadphase takes the bounds of damageable bodies from the tree too
+        if (damage_system && (hurtboxes || collision.get_broadphase().is_active())) {
+            damage_system->refit_hurtboxes();
+        }
+        update_broadphase();
+        collision.run(physics_space, pool, hurtboxes);
+    }
+    publish_hit_events(collision.get_hitscan_hits());
+    publish_hit_events(collision.get_hits());
+
+    // Damage lands in the DamageSystem batch flush later this tick
+    if (damage_system) {
+        damage_system->queue_hits(collision.get_hitscan_hits());
+        damage_system->queue_hits(collision.get_hits());
+    }
+
+    hits_last_tick = collision.get_hits().size() + collision.get_hitscan_hits().size();
+    release_finished_projectiles();
+    visuals_dirty = true;
+    update_usec_last_tick = Time::get_singleton()->get_ticks_usec() - start_usec;
+
+    TRACE_COUNTER("projectiles_active", pool.get_count());
+    TRACE_COUNTER("projectiles_spawned", spawned_last_tick);
+    TRACE_COUNTER("projectile_hits", hits_last_tick);
+    TRACE_COUNTER("projectiles_orphaned", orphaned_last_tick);
+}
+
+void ProjectileManager::integrate_serial(float delta) {
+    ProjectileKernels::Streams streams = ProjectileKernels::get_streams(pool);
+    expired_count = integrate_func(streams, 0, pool.get_count(), delta, expired.data());
+}
+
+void ProjectileManager::integrate_parallel(float delta) {
+    chunk_streams = ProjectileKernels::get_streams(pool);
+    chunk_count_total = pool.get_count();
+    chunk_delta = delta;
+
+    int chunks = (chunk_count_total + parallel_chunk_size - 1) / parallel_chunk_size;
+    chunk_expired_counts.resize(chunks);
+
+    WorkerThreadPool *thread_pool = WorkerThreadPool::get_singleton();
+    int64_t task = thread_pool->add_group_task(callable_mp(this, &ProjectileManager::_integrate_chunk), chunks, -1, true, "Projectile integration");
+    thread_pool->wait_for_group_task_completion(task);
+
+    // Compact the per-chunk lists in chunk order, keeping indices ascending
+    expired_count = 0;
+    for (int chunk = 0; chunk < chunks; chunk++) {
+        uint32_t begin = chunk * parallel_chunk_size;
+        for (uint32_t i = 0; i < chunk_expired_counts[chunk]; i++) {
+            expired[expired_count++] = expired[begin + i];
+        }
+    }
+}
+
+void ProjectileManager::_integrate_chunk(int chunk) {
+    TRACE_SCOPE("ProjectileManager::integrate_chunk");
+    uint32_t begin = chunk * parallel_chunk_size;
+    uint32_t end = MIN(begin + parallel_chunk_size, chunk_count_total);
+
+    // Chunks only touch their own range of the streams and of `expired`
+    chunk_expired_counts[chunk] = integrate_func(chunk_streams, begin, end, chunk_delta, expired.data() + begin);
+}
+
+void ProjectileManager::release_finished_projectiles() {
+    // Merge the ascending expired and hit lists into one descending, unique list
+    const FrameVector<ProjectileHit> &hits = collision.get_hits();
+    released.clear();
+
+    int e = (int)expired_count - 1;
+    int h = (int)hits.size() - 1;
+    while (e >= 0 || h >= 0) {
+        uint32_t next;
+        if (h < 0 || (e >= 0 && expired[e] >= hits[h].projectile_index)) {
+            next = expired[e--];
+        } else {
+            next = hits[h--].projectile_index;
+        }
+        if (released.empty() || released.back() != next) {
+            released.push_back(next);
+        }
+    }
+
+    // Release from the back so swap-removal never moves an unvisited slot
+    for (uint32_t index : released) {
+        cleanup_projectile(index);
+    }
+}
+
+// Bounds of the solid side of a WorldBoundaryShape3D. Only a plane facing
+// along an axis can be cut down; any other fills the whole world.
+static AABB get_half_space_bounds(const Plane &p_plane) {
+    const real_t extent = 1e6;
+    AABB bounds(Vector3(-extent, -extent, -extent), Vector3(2.0 * extent, 2.0 * extent, 2.0 * extent));
+    for (int axis = 0; axis < 3; axis++) {
+        real_t normal = p_plane.normal[axis];
+        if (Math::abs(normal) < 0.999) {
             continue;
         }
-        
-        // TODO: Perform raycast for collision detection
-        // PhysicsRayQueryParameters3D query;
-        // query->set_from(current_pos);
-        // query->set_to(new_pos);
-        // Ref<PhysicsRayQueryResult3D> result = physics_space->intersect_ray(query);
-        
-        // if (result.is_valid()) {
-        //     // Hit something - TODO: Apply damage and cleanup
-        //     Node3D* hit_body = Object::cast_to<Node3D>(result->get_collider());
-        //     if (hit_body && hit_body != projectile_dict["shooter"]) {
-        //         // TODO: Apply damage to hit target
-        //         cleanup_projectile(i);
-        //         continue;
-        //     }
-        // }
-        
-        // Update projectile position
-        projectile_dict["position"] = new_pos;
-        projectile_dict["traveled_distance"] = new_traveled;
-        
-        // Update visual
-        update_projectile_visual(i);
+        real_t offset = p_plane.d / normal;
+        if (normal > 0.0) {
+            bounds.size[axis] = offset + extent;
+        } else {
+            bounds.position[axis] = offset;
+            bounds.size[axis] = extent - offset;
+        }
     }
+    return bounds;
 }
 
-void ProjectileManager::setup_projectile_visuals() {
-    // TODO: Create material for projectile trails
-    // This could be a simple bright material or a trail effect
-    
-    // TODO: Create mesh for projectile representation
-    // This could be a thin cylinder or quad for the trail
+// World-space bounds of a collider in COLLIDER_GROUP
+static bool get_collider_bounds(Node *p_node, AABB &r_bounds) {
+    bool found = false;
+
+    CollisionObject3D *body = Object::cast_to<CollisionObject3D>(p_node);
+    if (body) {
+        for (int i = 0; i < body->get_child_count(); i++) {
+            CollisionShape3D *shape_node = Object::cast_to<CollisionShape3D>(body->get_child(i));
+            if (!shape_node || shape_node->is_disabled() || shape_node->get_shape().is_null()) {
+                continue;
+            }
+            AABB bounds;
+            Ref<WorldBoundaryShape3D> boundary = shape_node->get_shape();
+            if (boundary.is_valid()) {
+                // Its debug mesh is only a patch of the plane
+                bounds = get_half_space_bounds(shape_node->get_global_transform().xform(boundary->get_plane()));
+            } else {
+                Ref<ArrayMesh> debug_mesh = shape_node->get_shape()->get_debug_mesh();
+                if (debug_mesh.is_null()) {
+                    continue;
+                }
+                bounds = shape_node->get_global_transform().xform(debug_mesh->get_aabb());
+            }
+            r_bounds = found ? r_bounds.merge(bounds) : bounds;
+            found = true;
+        }
+        return found;
+    }
+
+    VisualInstance3D *visual = Object::cast_to<VisualInstance3D>(p_node);
+    if (visual) {
+        r_bounds = visual->get_global_transform().xform(visual->get_aabb());
+        return true;
+    }
+    return false;
 }
 
-void ProjectileManager::update_projectile_visual(int index) {
-    Dictionary projectile_dict = active_projectiles[index];
-    if (!projectile_dict["active"]) return;
-    
-    Vector3 position = projectile_dict["position"];
-    Vector3 direction = projectile_dict["direction"];
-    
-    // TODO: Update visual instance position and rotation
-    // Make the visual trail point in the direction of travel
-    // RenderingServer::get_singleton()->instance_set_transform(visual_instance, transform);
+void ProjectileManager::update_broadphase() {
+    ProjectileBroadphase &broadphase = collision.get_broadphase();
+
+    if (colliders_dirty && is_inside_tree()) {
+        colliders_dirty = false;
+        broadphase.clear_static();
+
+        TypedArray<Node> colliders = get_tree()->get_nodes_in_group(COLLIDER_GROUP);
+        for (int i = 0; i < colliders.size(); i++) {
+            AABB bounds;
+            if (get_collider_bounds(Object::cast_to<Node>(colliders[i]), bounds)) {
+                Vector3 end = bounds.get_end();
+                float min[3] = { (float)bounds.position.x, (float)bounds.position.y, (float)bounds.position.z };
+                float max[3] = { (float)end.x, (float)end.y, (float)end.z };
+                broadphase.add_static(min, max);
+            }
+        }
+    }
+
+    broadphase.clear_dynamic();
+    if (!broadphase.is_active()) {
+        return;
+    }
+
+    // Bot crowds moved earlier this tick, their bodies are not nodes
+    if (is_inside_tree()) {
+        TypedArray<Node> crowds = get_tree()->get_nodes_in_group(BotCrowd::GROUP_NAME);
+        for (int i = 0; i < crowds.size(); i++) {
+            BotCrowd *crowd = Object::cast_to<BotCrowd>(crowds[i]);
+            if (crowd) {
+                crowd->add_broadphase_boxes(broadphase);
+            }
+        }
+    }
+
+    // Every Health body with a hurtbox, whether or not it is lag compensated.
+    // With the tree off, projectiles near them need a physics ray instead.
+    DamageSystem *damage_system = DamageSystem::get_singleton();
+    if (damage_system) {
+        broadphase.add_hurtboxes(damage_system->get_hurtbox_tree(), use_hurtbox_tree);
+    }
+
+    // Other moving targets are the hurtboxes LagCompensation recorded earlier this tick
+    LagCompensation *lag_compensation = LagCompensation::get_singleton();
+    if (!lag_compensation) {
+        return;
+    }
+    const HitboxHistory &history = lag_compensation->get_history();
+    if (history.get_frame_count() == 0) {
+        return;
+    }
+
+    double newest = history.get_newest_time();
+    for (uint32_t slot = 0; slot < history.get_max_entities(); slot++) {
+        HitboxHistory::Pose pose;
+        if (!history.sample_pose(slot, newest, pose) || (damage_system && damage_system->has_hurtbox(ObjectID(pose.key)))) {
+            continue;
+        }
+        Basis basis(Quaternion(pose.rotation[0], pose.rotation[1], pose.rotation[2], pose.rotation[3]));
+        Vector3 center = Vector3(pose.position[0], pose.position[1], pose.position[2]) + basis.xform(Vector3(pose.center[0], pose.center[1], pose.center[2]));
+
+        // The box of a rotated box: each axis spans the absolute projections of the half extents
+        float min[3];
+        float max[3];
+        for (int axis = 0; axis < 3; axis++) {
+            float reach = std::fabs(basis[axis][0]) * pose.half_extents[0] + std::fabs(basis[axis][1]) * pose.half_extents[1] + std::fabs(basis[axis][2]) * pose.half_extents[2];
+            min[axis] = center[axis] - reach;
+            max[axis] = center[axis] + reach;
+        }
+        broadphase.add_dynamic(min, max);
+    }
 }
 
-void ProjectileManager::cleanup_projectile(int index) {
-    Dictionary projectile_dict = active_projectiles[index];
-    projectile_dict["active"] = false;
-    
-    // TODO: Hide visual representation
-    hide_projectile_visual(index);
+Dictionary ProjectileManager::get_collision_stats() const {
+    const ProjectileCollisionStats &stats = collision.get_stats();
+
+    Dictionary result;
+    result["segments"] = stats.segments;
+    result["skipped"] = stats.skipped;
+    result["rays_cast"] = stats.rays_cast;
+    result["rays_deferred"] = stats.rays_deferred;
+    result["hits"] = stats.hits;
+    result["hurtbox_queries"] = stats.hurtbox_queries;
+    result["hurtbox_hits"] = stats.hurtbox_hits;
+    result["hitscan_rays"] = stats.hitscan_rays;
+    result["hitscan_hits"] = stats.hitscan_hits;
+    result["hitscan_rewound"] = stats.hitscan_rewound;
+    result["time_usec"] = stats.time_usec;
+    return result;
+}
+
+PackedByteArray ProjectileManager::save_state() const {
+    ManagerStateHeader header = {};
+    header.magic = STATE_MAGIC;
+    header.version = STATE_VERSION;
+    header.physics_tick = physics_tick;
+    header.collision_cursor = collision.get_cursor();
+
+    PackedByteArray state;
+    state.resize(sizeof(header) + pool.get_state_size());
+    uint8_t *out = state.ptrw();
+    memcpy(out, &header, sizeof(header));
+    pool.write_state(out + sizeof(header));
+    return state;
 }
 
-void ProjectileManager::hide_projectile_visual(int index) {
-    // TODO: Hide or disable the visual representation
+bool ProjectileManager::load_state(const PackedByteArray &state) {
+    ManagerStateHeader header;
+    ERR_FAIL_COND_V_MSG(state.size() < (int64_t)sizeof(header), false, "ProjectileManager: State is too small.");
+
+    const uint8_t *in = state.ptr();
+    memcpy(&header, in, sizeof(header));
+    ERR_FAIL_COND_V_MSG(header.magic != STATE_MAGIC || header.version != STATE_VERSION, false, "ProjectileManager: State has an unknown format.");
+    ERR_FAIL_COND_V_MSG(!pool.read_state(in + sizeof(header), state.size() - sizeof(header)), false, "ProjectileManager: Projectile pool state is corrupt.");
+
+    physics_tick = header.physics_tick;
+    collision.set_cursor(header.collision_cursor);
+    max_projectiles = pool.get_capacity();
+    pool_full_policy = (PoolFullPolicy)pool.get_full_policy();
+
+    // The flight model is part of the state, replays must bend the same way
+    const ProjectileBallistics &ballistics = pool.get_ballistics();
+    ballistic_gravity = Vector3(ballistics.gravity[0], ballistics.gravity[1], ballistics.gravity[2]);
+    ballistic_drag = ballistics.drag;
+
+    // Scratch lists follow the pool capacity, which the state may have changed
+    if (expired.size() < pool.get_capacity()) {
+        expired.resize(pool.get_capacity());
+    }
+
+    visuals_dirty = true;
+    return true;
+}
+
+Dictionary ProjectileManager::get_queue_stats() const {
+    Dictionary result;
+    result["spawn_queue_depth"] = spawn_queue.get_depth();
+    result["spawn_queue_peak_depth"] = spawn_queue.get_peak_depth();
+    result["spawn_queue_capacity"] = spawn_queue.get_capacity();
+    result["spawn_queue_overflows"] = (int64_t)spawn_queue.get_overflow_count();
+    result["spawned_last_tick"] = spawned_last_tick;
+    result["hitscan_queue_depth"] = hitscan_queue.get_depth();
+    result["hitscan_queue_peak_depth"] = hitscan_queue.get_peak_depth();
+    result["hitscan_queue_overflows"] = (int64_t)hitscan_queue.get_overflow_count();
+    result["hit_events_published"] = (int64_t)hit_events.get_published_count();
+    result["hit_events_overwritten"] = (int64_t)hit_events.get_overwrite_count();
+    result["hit_events_capacity"] = hit_events.get_capacity();
+    return result;
+}
+
+void ProjectileManager::set_projectile_mesh(const Ref<Mesh> &p_mesh) {
+    projectile_mesh = p_mesh;
+    if (multimesh.is_valid() && projectile_mesh.is_valid()) {
+        RenderingServer::get_singleton()->multimesh_set_mesh(multimesh, projectile_mesh->get_rid());
+    }
+}
+
+void ProjectileManager::set_projectile_material(const Ref<Material> &p_material) {
+    projectile_material = p_material;
+    if (multimesh_instance.is_valid()) {
+        RenderingServer::get_singleton()->instance_geometry_set_material_override(multimesh_instance, projectile_material.is_valid() ? projectile_material->get_rid() : RID());
+    }
+}
+
+void ProjectileManager::setup_projectile_visuals() {
+    // Default to a bright unshaded tracer
+    if (projectile_material.is_null()) {
+        Ref<StandardMaterial3D> material;
+        material.instantiate();
+        material->set_shading_mode(BaseMaterial3D::SHADING_MODE_UNSHADED);
+        material->set_albedo(Color(1.0, 0.85, 0.4));
+        projectile_material = material;
+    }
+
+    // Unit-length box along Z, stretched to the trail length by the instance transform
+    if (projectile_mesh.is_null()) {
+        Ref<BoxMesh> mesh;
+        mesh.instantiate();
+        mesh->set_size(Vector3(0.02, 0.02, 1.0));
+        projectile_mesh = mesh;
+    }
+
+    setup_optimized_visuals();
 }
 
 void ProjectileManager::setup_optimized_visuals() {
-    // TODO: Create MultiMeshInstance3D for batch rendering
-    // multi_mesh_instance = memnew(MultiMeshInstance3D);
-    // add_child(multi_mesh_instance);
-    
-    // TODO: Set up MultiMesh with max projectile count
-    // Ref<MultiMesh> multi_mesh = memnew(MultiMesh);
-    // multi_mesh->set_transform_format(MultiMesh::TRANSFORM_3D);
-    // multi_mesh->set_instance_count(max_projectiles);
-    // multi_mesh->set_mesh(projectile_mesh);
-    // multi_mesh_instance->set_multimesh(multi_mesh);
-}
\ No newline at end of file
+    Ref<World3D> world = get_viewport()->find_world_3d();
+    if (world.is_null()) return;
+
+    RenderingServer *rs = RenderingServer::get_singleton();
+
+    // One multimesh instance holds every projectile, so they draw in a single call
+    multimesh = rs->multimesh_create();
+    rs->multimesh_set_mesh(multimesh, projectile_mesh->get_rid());
+
+    multimesh_instance = rs->instance_create2(multimesh, world->get_scenario());
+    rs->instance_geometry_set_material_override(multimesh_instance, projectile_material->get_rid());
+    rs->instance_geometry_set_cast_shadows_setting(multimesh_instance, RenderingServer::SHADOW_CASTING_SETTING_OFF);
+
+    multimesh_capacity = 0;
+    multimesh_visible = 0;
+}
+
+void ProjectileManager::free_projectile_visuals() {
+    RenderingServer *rs = RenderingServer::get_singleton();
+    if (!rs) return;
+
+    if (multimesh_instance.is_valid()) {
+        rs->free_rid(multimesh_instance);
+        multimesh_instance = RID();
+    }
+    if (multimesh.is_valid()) {
+        rs->free_rid(multimesh);
+        multimesh = RID();
+    }
+}
+
+void ProjectileManager::update_projectile_visuals() {
+    visuals_dirty = false;
+    if (!multimesh.is_valid()) return;
+
+    RenderingServer *rs = RenderingServer::get_singleton();
+    int count = pool.get_count();
+
+    if (count == 0) {
+        if (multimesh_visible != 0) {
+            rs->multimesh_set_visible_instances(multimesh, 0);
+            multimesh_visible = 0;
+        }
+        return;
+    }
+
+    // The upload must cover the whole allocation, so size it in power-of-two
+    // steps around the live count instead of the pool capacity. Shrinking only
+    // below a quarter avoids reallocating when the count hovers at a boundary.
+    if (count > multimesh_capacity || count < multimesh_capacity / 4) {
+        int new_capacity = 64;
+        while (new_capacity < count) {
+            new_capacity *= 2;
+        }
+        if (new_capacity != multimesh_capacity) {
+            multimesh_capacity = new_capacity;
+            rs->multimesh_allocate_data(multimesh, multimesh_capacity, RenderingServer::MULTIMESH_TRANSFORM_3D);
+            visual_buffer.resize(multimesh_capacity * 12);
+            multimesh_visible = -1; // Reallocation resets the visible count
+        }
+    }
+
+    // Build the transforms straight from the flight model, which is the only
+    // place positions are needed every tick. The basis maps the mesh's Z axis
+    // onto the current flight direction and the trail ends at the tip.
+    float length = projectile_visual_length;
+    float *dst = visual_buffer.ptrw();
+    double now = pool.get_time();
+
+    for (int i = 0; i < count; i++) {
+        float position[3];
+        float velocity[3];
+        pool.get_position(i, now, position);
+        pool.get_velocity(i, now, velocity);
+
+        float dx = velocity[0];
+        float dy = velocity[1];
+        float dz = velocity[2];
+        float speed = std::sqrt(dx * dx + dy * dy + dz * dz);
+        if (speed > 1e-4f) {
+            dx /= speed;
+            dy /= speed;
+            dz /= speed;
+        } else {
+            dx = pool.dir_x[i];
+            dy = pool.dir_y[i];
+            dz = pool.dir_z[i];
+        }
+
+        // Side axis = up x dir, with world X as up when flying nearly vertical
+        float sx, sy, sz;
+        if (std::fabs(dy) < 0.99f) {
+            sx = dz;
+            sy = 0.0f;
+            sz = -dx;
+        } else {
+            sx = 0.0f;
+            sy = -dz;
+            sz = dy;
+        }
+        float inv_len = 1.0f / std::sqrt(sx * sx + sy * sy + sz * sz);
+        sx *= inv_len;
+        sy *= inv_len;
+        sz *= inv_len;
+
+        // Up axis = dir x side
+        float ux = dy * sz - dz * sy;
+        float uy = dz * sx - dx * sz;
+        float uz = dx * sy - dy * sx;
+
+        float *t = dst + i * 12;
+        t[0] = sx;
+        t[1] = ux;
+        t[2] = dx * length;
+        t[3] = position[0] - dx * length * 0.5f;
+        t[4] = sy;
+        t[5] = uy;
+        t[6] = dy * length;
+        t[7] = position[1] - dy * length * 0.5f;
+        t[8] = sz;
+        t[9] = uz;
+        t[10] = dz * length;
+        t[11] = position[2] - dz * length * 0.5f;
+    }
+
+    rs->multimesh_set_buffer(multimesh, visual_buffer);
+    if (count != multimesh_visible) {
+        rs->multimesh_set_visible_instances(multimesh, count);
+        multimesh_visible = count;
+    }
+}
+
+void ProjectileManager::cleanup_projectile(int index) {
+    if (index < 0 || (uint32_t)index >= pool.get_count()) return;
+
+    // Instances past the live count are trimmed on the next upload
+    pool.release_dense(index);
+}
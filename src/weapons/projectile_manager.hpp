@@ -9,62 +9,278 @@
 
 #include <godot_cpp/core/class_db.hpp>
 
+#include "../memory/frame_arena.hpp"
+#include "projectile_collision.hpp"
+#include "projectile_kernels.hpp"
+#include "projectile_pool.hpp"
+#include "projectile_queues.hpp"
+
+#include <vector>
+
 namespace godot {
 
+// Spawn description of a single projectile
 struct ProjectileData {
     Vector3 position;
     Vector3 direction;
     double speed;
     double damage;
     double max_range;
-    double traveled_distance;
-    Node* shooter;
-    bool active;
-    
-    // Visual representation
-    RID visual_instance;  // For rendering the projectile trail
+    uint32_t shooter; // EntityRegistry handle
+};
+
+// One shot of a weapon's burst, fired `delay` seconds after the start of the
+// current physics tick from where the muzzle was at that instant
+struct ScheduledShot {
+    Vector3 origin;
+    Vector3 direction;
+    float delay;
+};
+
+// Fixed-size hit record broadcast to damage/FX consumers on any thread
+struct ProjectileHitEvent {
+    uint64_t tick;
+    uint64_t collider_id;
+    uint64_t shooter_id; // 0 once the shooter is gone
+    float point[3];
+    float normal[3];
+    float damage;
+    uint32_t projectile_id;
 };
 
+typedef MPSCQueue<ProjectilePool::SpawnParams> ProjectileSpawnQueue;
+typedef MPSCQueue<HitscanRequest> HitscanQueue;
+typedef SPMCRing<ProjectileHitEvent> ProjectileHitEventRing;
+
 class ProjectileManager : public Node {
     GDCLASS(ProjectileManager, Node)
 
+public:
+    enum PoolFullPolicy {
+        POOL_FULL_DROP = ProjectilePool::FULL_POLICY_DROP,
+        POOL_FULL_EVICT_OLDEST = ProjectilePool::FULL_POLICY_EVICT_OLDEST,
+        POOL_FULL_GROW = ProjectilePool::FULL_POLICY_GROW,
+    };
+
+    enum IntegrationKernel {
+        KERNEL_AUTO = -1,
+        KERNEL_SCALAR = ProjectileKernels::ISA_SCALAR,
+        KERNEL_SSE2 = ProjectileKernels::ISA_SSE2,
+        KERNEL_AVX2 = ProjectileKernels::ISA_AVX2,
+    };
+
 private:
     static ProjectileManager* singleton;
-    
-    Array active_projectiles;  // Pool of ProjectileData
+
+    ProjectilePool pool;  // Typed SoA storage of live projectiles
     int max_projectiles = 1000; // Performance limit
-    int next_projectile_index = 0;
-    
+    PoolFullPolicy pool_full_policy = POOL_FULL_EVICT_OLDEST;
+
+    // Batch integration kernel, picked at runtime from the CPU features
+    IntegrationKernel integration_kernel = KERNEL_AUTO;
+    ProjectileKernels::IntegrateFunc integrate_func = nullptr;
+
+    // Scratch list of dense indices that expired this tick, sized to the pool
+    std::vector<uint32_t> expired;
+    uint32_t expired_count = 0;
+    FrameVector<uint32_t> released; // Expired and hit projectiles, highest index first
+
+    // Optional parallel integration on the WorkerThreadPool. Each chunk writes
+    // its expirations into its own range of `expired`, which the main thread
+    // compacts in chunk order so results match the serial path exactly.
+    bool parallel_update = false;
+    int parallel_chunk_size = 2048;
+    std::vector<uint32_t> chunk_expired_counts;
+    ProjectileKernels::Streams chunk_streams;
+    uint32_t chunk_count_total = 0;
+    float chunk_delta = 0.0f;
+
+    // Swept-ray collision against the physics world
+    ProjectileCollisionStage collision;
+    bool colliders_dirty = true; // Static broadphase bounds are rebuilt on the next tick
+    bool use_hurtbox_tree = true; // Sweep Health bodies against the DamageSystem's tree
+
+    // Flight model shared by every projectile
+    Vector3 ballistic_gravity = Vector3(0.0, -9.8, 0.0);
+    double ballistic_drag = 0.0;
+    void apply_ballistics();
+
+    // Weapons may fire from any thread; requests are drained at the start of each tick
+    ProjectileSpawnQueue spawn_queue;
+    uint32_t spawned_last_tick = 0;
+
+    // Sampled by the Performance monitors
+    uint32_t hits_last_tick = 0;
+    uint32_t orphaned_last_tick = 0; // Projectiles whose shooter went away this tick
+    uint64_t update_usec_last_tick = 0;
+    void add_monitors();
+    void remove_monitors();
+
+    // Per-tick scratch of the simulation comes from the main thread's frame
+    // arena, which is reset between physics ticks
+    bool poison_frame_arena = false;
+    uint64_t frame_arena_peak_bytes = 0;
+    uint32_t frame_arena_allocations_last_tick = 0; // Heap blocks the arena needed, 0 once warmed up
+    void on_physics_frame();
+
+    // Hitscan shots from every weapon, resolved together in one pass per tick
+    HitscanQueue hitscan_queue;
+    FrameVector<HitscanRequest> hitscan_batch;
+
+    // Hits of every tick, readable without locks through a Reader cursor
+    ProjectileHitEventRing hit_events;
+    uint64_t physics_tick = 0;
+
     // Visual settings
     Ref<Material> projectile_material;
     Ref<Mesh> projectile_mesh;
     double projectile_visual_length = 0.5; // Length of visible trail
-    
+
+    // Batch renderer, every projectile is one instance of a single MultiMesh
+    RID multimesh;
+    RID multimesh_instance;
+    int multimesh_capacity = 0;
+    int multimesh_visible = 0;
+    PackedFloat32Array visual_buffer; // 12 floats per instance, row-major 3x4 transforms
+    bool visuals_dirty = false;
+
     // Physics world for raycasting
     PhysicsDirectSpaceState3D* physics_space = nullptr;
 
 public:
+    // Level geometry in this group feeds the collision broadphase
+    static constexpr const char *COLLIDER_GROUP = "projectile_colliders";
+
     ProjectileManager();
     ~ProjectileManager();
-    
+
     static void _bind_methods();
     static ProjectileManager* get_singleton() { return singleton; }
-    
+
+    void _notification(int p_what);
     void _ready() override;
     void _process(double delta) override;
-    
+    void _physics_process(double delta) override;
+
     // Projectile management
     void create_projectile(Vector3 start_pos, Vector3 direction, double speed, double damage, Node* shooter, double max_range = 100.0);
+
+    // Batch spawn for scripts, one boundary crossing for N projectiles. Speeds,
+    // damages and ranges hold one value per projectile or a single shared
+    // value. Returns how many were queued.
+    int create_projectiles(const PackedVector3Array &origins, const PackedVector3Array &directions, const PackedFloat32Array &speeds, const PackedFloat32Array &damages, const PackedFloat32Array &ranges, Node* shooter);
+
+    // Live projectiles in dense order, the arrays line up index for index.
+    // Positions and flight directions are evaluated at the current time.
+    PackedVector3Array get_projectile_positions() const;
+    PackedVector3Array get_projectile_directions() const;
+    PackedInt32Array get_projectile_ids() const;
+    void spawn_projectile(const ProjectileData &data);
+    void queue_hitscan(Vector3 origin, Vector3 direction, double range, double damage, Node* shooter);
+    // fire_time is LagCompensation::get_time() on the shooter's tick, in
+    // seconds of simulated time rather than wall clock
+    void queue_rewound_hitscan(Vector3 origin, Vector3 direction, double range, double damage, Node* shooter, double fire_time);
+
+    // Every shot a weapon fires in one tick, queued in one call. Must be called
+    // before this tick's update_projectiles, as weapons do from _physics_process.
+    // The shooter is the weapon's EntityRegistry handle.
+    void queue_shots(const std::vector<ScheduledShot> &shots, bool hitscan, double speed, double damage, double range, uint32_t shooter);
+    void drain_spawn_queue();
+    void resolve_hitscan();
+    void publish_hit_events(const FrameVector<ProjectileHit> &hits);
     void update_projectiles(double delta);
+    void update_broadphase();
+    // Static colliders are read once; call after adding or moving level geometry
+    void refresh_colliders() { colliders_dirty = true; }
     void cleanup_projectile(int index);
-    
+    void release_finished_projectiles();
+    void integrate_serial(float delta);
+    void integrate_parallel(float delta);
+    void _integrate_chunk(int chunk);
+
+    static void define_project_settings();
+
+    // Rollback snapshots, taken between physics ticks. Queued spawns and
+    // hitscan shots that have not been drained yet are not part of the state.
+    PackedByteArray save_state() const;
+    bool load_state(const PackedByteArray &state);
+
+    const ProjectilePool &get_pool() const { return pool; }
+    int get_active_projectile_count() const { return pool.get_count(); }
+    int get_pool_high_water() const { return pool.get_high_water(); }
+    int get_spawned_last_tick() const { return spawned_last_tick; }
+    int get_expired_last_tick() const { return expired_count; }
+    int get_hits_last_tick() const { return hits_last_tick; }
+    int get_orphaned_last_tick() const { return orphaned_last_tick; }
+    int get_update_usec_last_tick() const { return update_usec_last_tick; }
+    int get_collision_usec_last_tick() const { return collision.get_stats().time_usec; }
+    int get_frame_arena_peak_bytes() const { return frame_arena_peak_bytes; }
+    int get_frame_arena_allocations_last_tick() const { return frame_arena_allocations_last_tick; }
+
+    // Pool settings
+    int get_max_projectiles() const { return max_projectiles; }
+    void set_max_projectiles(int p_max);
+    PoolFullPolicy get_pool_full_policy() const { return pool_full_policy; }
+    void set_pool_full_policy(PoolFullPolicy p_policy);
+    IntegrationKernel get_integration_kernel() const { return integration_kernel; }
+    void set_integration_kernel(IntegrationKernel p_kernel);
+    String get_active_kernel_name() const;
+    bool get_parallel_update() const { return parallel_update; }
+    void set_parallel_update(bool p_enable) { parallel_update = p_enable; }
+
+    // Collision settings
+    int get_max_raycasts_per_tick() const { return collision.get_max_raycasts_per_tick(); }
+    void set_max_raycasts_per_tick(int p_max) { collision.set_max_raycasts_per_tick(MAX(p_max, 0)); }
+    int get_max_collision_time_usec() const { return collision.get_max_time_usec(); }
+    void set_max_collision_time_usec(int p_usec) { collision.set_max_time_usec(MAX(p_usec, 0)); }
+    uint32_t get_collision_mask() const { return collision.get_collision_mask(); }
+    void set_collision_mask(uint32_t p_mask) { collision.set_collision_mask(p_mask); }
+
+    double get_broadphase_lookahead() const { return collision.get_broadphase().get_lookahead(); }
+    void set_broadphase_lookahead(double p_seconds) { collision.get_broadphase().set_lookahead(p_seconds); }
+    double get_max_target_speed() const { return collision.get_broadphase().get_max_target_speed(); }
+    void set_max_target_speed(double p_speed) { collision.get_broadphase().set_max_target_speed(p_speed); }
+    bool get_use_hurtbox_tree() const { return use_hurtbox_tree; }
+    void set_use_hurtbox_tree(bool p_enable) { use_hurtbox_tree = p_enable; }
+
+    // Ballistics
+    Vector3 get_ballistic_gravity() const { return ballistic_gravity; }
+    void set_ballistic_gravity(const Vector3 &p_gravity);
+    double get_ballistic_drag() const { return ballistic_drag; }
+    void set_ballistic_drag(double p_drag);
+
+    // Valid until the next physics tick starts
+    const FrameVector<ProjectileHit> &get_last_hits() const { return collision.get_hits(); }
+    const FrameVector<ProjectileHit> &get_last_hitscan_hits() const { return collision.get_hitscan_hits(); }
+    Dictionary get_collision_stats() const;
+
+    // Lock-free queues
+    const ProjectileHitEventRing &get_hit_events() const { return hit_events; }
+    Dictionary get_queue_stats() const;
+
+    // Visual settings
+    Ref<Mesh> get_projectile_mesh() const { return projectile_mesh; }
+    void set_projectile_mesh(const Ref<Mesh> &p_mesh);
+    Ref<Material> get_projectile_material() const { return projectile_material; }
+    void set_projectile_material(const Ref<Material> &p_material);
+    double get_projectile_visual_length() const { return projectile_visual_length; }
+    void set_projectile_visual_length(double p_length) { projectile_visual_length = p_length; visuals_dirty = true; }
+
+    // Fills frame memory with a pattern when it is freed or reset, so stale
+    // scratch reads show up as garbage
+    bool get_poison_frame_arena() const { return poison_frame_arena; }
+    void set_poison_frame_arena(bool p_enable);
+
     // Visual management
     void setup_projectile_visuals();
-    void update_projectile_visual(int index);
-    void hide_projectile_visual(int index);
     void setup_optimized_visuals();
+    void update_projectile_visuals();
+    void free_projectile_visuals();
 };
 
 }
 
-#endif
\ No newline at end of file
+VARIANT_ENUM_CAST(ProjectileManager::PoolFullPolicy);
+VARIANT_ENUM_CAST(ProjectileManager::IntegrationKernel);
+
+#endif
@@ -0,0 +1,469 @@
+#include "projectile_pool.hpp"
+
+#include <cstring>
+#include <limits>
+
+using namespace godot;
+
+static const uint32_t STATE_MAGIC = 0x4C4F4F50; // "POOL"
+static const uint32_t STATE_VERSION = 3;
+
+struct PoolStateHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t free_count;
+    uint32_t oldest;
+    uint32_t newest;
+    uint32_t full_policy;
+    uint32_t high_water;
+    uint32_t reserved;
+    uint64_t dropped_total;
+    uint64_t evicted_total;
+    double time;
+    float gravity[3];
+    float drag;
+};
+
+// Bytes per live projectile and per stable id
+static const size_t DENSE_STATE_STRIDE = 10 * sizeof(float) + 2 * sizeof(double) + 2 * sizeof(uint32_t);
+static const size_t SPARSE_STATE_STRIDE = 3 * sizeof(uint32_t);
+
+void ProjectilePool::resize_storage(uint32_t new_capacity) {
+    uint32_t old_capacity = capacity;
+
+    origin_x.resize(new_capacity);
+    origin_y.resize(new_capacity);
+    origin_z.resize(new_capacity);
+    dir_x.resize(new_capacity);
+    dir_y.resize(new_capacity);
+    dir_z.resize(new_capacity);
+    speed.resize(new_capacity);
+    damage.resize(new_capacity);
+    max_range.resize(new_capacity);
+    traveled.resize(new_capacity);
+    spawn_time.resize(new_capacity);
+    swept_time.resize(new_capacity);
+    shooter.resize(new_capacity);
+    id.resize(new_capacity);
+
+    dense_of.resize(new_capacity, INVALID_ID);
+    order_prev.resize(new_capacity, INVALID_ID);
+    order_next.resize(new_capacity, INVALID_ID);
+    free_ids.reserve(new_capacity);
+    state_marks.reserve(new_capacity);
+
+    // Push new ids in reverse so the lowest ones are handed out first
+    for (uint32_t i = new_capacity; i > old_capacity; i--) {
+        free_ids.push_back(i - 1);
+    }
+
+    capacity = new_capacity;
+}
+
+void ProjectilePool::reset(uint32_t p_capacity) {
+    capacity = 0;
+    count = 0;
+    oldest = INVALID_ID;
+    newest = INVALID_ID;
+    high_water = 0;
+    time = 0.0;
+
+    dense_of.clear();
+    order_prev.clear();
+    order_next.clear();
+    free_ids.clear();
+
+    resize_storage(p_capacity);
+}
+
+bool ProjectilePool::set_capacity(uint32_t p_capacity) {
+    if (p_capacity < count) {
+        return false;
+    }
+
+    if (p_capacity < capacity) {
+        free_ids.clear();
+        for (uint32_t i = p_capacity; i > 0; i--) {
+            if (dense_of[i - 1] == INVALID_ID) {
+                free_ids.push_back(i - 1);
+            }
+        }
+
+        // Move ids past the new end onto free ones, in place in the spawn order
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t old_id = id[i];
+            if (old_id < p_capacity) {
+                continue;
+            }
+            uint32_t new_id = free_ids.back();
+            free_ids.pop_back();
+
+            uint32_t prev = order_prev[old_id];
+            uint32_t next = order_next[old_id];
+            order_prev[new_id] = prev;
+            order_next[new_id] = next;
+            if (prev != INVALID_ID) {
+                order_next[prev] = new_id;
+            } else {
+                oldest = new_id;
+            }
+            if (next != INVALID_ID) {
+                order_prev[next] = new_id;
+            } else {
+                newest = new_id;
+            }
+            dense_of[new_id] = i;
+            id[i] = new_id;
+        }
+
+        // Leaves resize_storage only truncating the tables
+        capacity = p_capacity;
+    }
+
+    resize_storage(p_capacity);
+    return true;
+}
+
+void ProjectilePool::clear() {
+    while (count > 0) {
+        release_dense(count - 1);
+    }
+}
+
+void ProjectilePool::link_newest(uint32_t p_id) {
+    order_prev[p_id] = newest;
+    order_next[p_id] = INVALID_ID;
+    if (newest != INVALID_ID) {
+        order_next[newest] = p_id;
+    } else {
+        oldest = p_id;
+    }
+    newest = p_id;
+}
+
+void ProjectilePool::unlink(uint32_t p_id) {
+    uint32_t prev = order_prev[p_id];
+    uint32_t next = order_next[p_id];
+
+    if (prev != INVALID_ID) {
+        order_next[prev] = next;
+    } else {
+        oldest = next;
+    }
+
+    if (next != INVALID_ID) {
+        order_prev[next] = prev;
+    } else {
+        newest = prev;
+    }
+
+    order_prev[p_id] = INVALID_ID;
+    order_next[p_id] = INVALID_ID;
+}
+
+uint32_t ProjectilePool::spawn(const SpawnParams &p_params) {
+    if (free_ids.empty()) {
+        switch (full_policy) {
+            case FULL_POLICY_DROP:
+                dropped_total++;
+                return INVALID_ID;
+            case FULL_POLICY_EVICT_OLDEST:
+                if (oldest == INVALID_ID) {
+                    // Zero-capacity pool, nothing to evict
+                    dropped_total++;
+                    return INVALID_ID;
+                }
+                release(oldest);
+                evicted_total++;
+                break;
+            case FULL_POLICY_GROW:
+                resize_storage(capacity > 0 ? capacity * 2 : 64);
+                break;
+        }
+    }
+
+    uint32_t new_id = free_ids.back();
+    free_ids.pop_back();
+
+    uint32_t slot = count++;
+    origin_x[slot] = p_params.position[0];
+    origin_y[slot] = p_params.position[1];
+    origin_z[slot] = p_params.position[2];
+    dir_x[slot] = p_params.direction[0];
+    dir_y[slot] = p_params.direction[1];
+    dir_z[slot] = p_params.direction[2];
+    speed[slot] = p_params.speed;
+    damage[slot] = p_params.damage;
+    max_range[slot] = p_params.max_range;
+    // Counted from the tick start like everything else, so start behind by the delay
+    traveled[slot] = -p_params.speed * p_params.delay;
+    spawn_time[slot] = time + p_params.delay;
+    swept_time[slot] = spawn_time[slot];
+    shooter[slot] = p_params.shooter;
+    id[slot] = new_id;
+
+    dense_of[new_id] = slot;
+    link_newest(new_id);
+
+    if (count > high_water) {
+        high_water = count;
+    }
+
+    return new_id;
+}
+
+void ProjectilePool::release_dense(uint32_t p_dense_index) {
+    if (p_dense_index >= count) {
+        return;
+    }
+
+    uint32_t released_id = id[p_dense_index];
+    uint32_t last = count - 1;
+
+    if (p_dense_index != last) {
+        // Move the last projectile into the hole to keep the streams packed
+        origin_x[p_dense_index] = origin_x[last];
+        origin_y[p_dense_index] = origin_y[last];
+        origin_z[p_dense_index] = origin_z[last];
+        dir_x[p_dense_index] = dir_x[last];
+        dir_y[p_dense_index] = dir_y[last];
+        dir_z[p_dense_index] = dir_z[last];
+        speed[p_dense_index] = speed[last];
+        damage[p_dense_index] = damage[last];
+        max_range[p_dense_index] = max_range[last];
+        traveled[p_dense_index] = traveled[last];
+        spawn_time[p_dense_index] = spawn_time[last];
+        swept_time[p_dense_index] = swept_time[last];
+        shooter[p_dense_index] = shooter[last];
+        id[p_dense_index] = id[last];
+        dense_of[id[p_dense_index]] = p_dense_index;
+    }
+
+    count = last;
+
+    dense_of[released_id] = INVALID_ID;
+    unlink(released_id);
+    free_ids.push_back(released_id);
+}
+
+void ProjectilePool::release(uint32_t p_id) {
+    if (!is_alive(p_id)) {
+        return;
+    }
+    release_dense(dense_of[p_id]);
+}
+
+void ProjectilePool::get_position(uint32_t p_dense_index, double p_time, float r_position[3]) const {
+    uint32_t i = p_dense_index;
+    float origin[3] = { origin_x[i], origin_y[i], origin_z[i] };
+    float velocity[3] = { dir_x[i] * speed[i], dir_y[i] * speed[i], dir_z[i] * speed[i] };
+    ballistics.get_position(origin, velocity, (float)(p_time - spawn_time[i]), r_position);
+}
+
+void ProjectilePool::get_velocity(uint32_t p_dense_index, double p_time, float r_velocity[3]) const {
+    uint32_t i = p_dense_index;
+    float velocity[3] = { dir_x[i] * speed[i], dir_y[i] * speed[i], dir_z[i] * speed[i] };
+    ballistics.get_velocity(velocity, (float)(p_time - spawn_time[i]), r_velocity);
+}
+
+void ProjectilePool::get_path_bounds(uint32_t p_dense_index, double p_from_time, double p_to_time, float r_min[3], float r_max[3]) const {
+    uint32_t i = p_dense_index;
+    float origin[3] = { origin_x[i], origin_y[i], origin_z[i] };
+    float velocity[3] = { dir_x[i] * speed[i], dir_y[i] * speed[i], dir_z[i] * speed[i] };
+    ballistics.get_path_bounds(origin, velocity, (float)(p_from_time - spawn_time[i]), (float)(p_to_time - spawn_time[i]), r_min, r_max);
+}
+
+double ProjectilePool::get_expiry_time(uint32_t p_dense_index) const {
+    if (speed[p_dense_index] <= 0.0f) {
+        return std::numeric_limits<double>::infinity();
+    }
+    return spawn_time[p_dense_index] + max_range[p_dense_index] / speed[p_dense_index];
+}
+
+size_t ProjectilePool::get_state_size() const {
+    return sizeof(PoolStateHeader) + count * DENSE_STATE_STRIDE + capacity * SPARSE_STATE_STRIDE + free_ids.size() * sizeof(uint32_t);
+}
+
+template <typename T>
+static uint8_t *write_stream(uint8_t *r_out, const std::vector<T> &p_stream, uint32_t p_count) {
+    memcpy(r_out, p_stream.data(), p_count * sizeof(T));
+    return r_out + p_count * sizeof(T);
+}
+
+template <typename T>
+static const uint8_t *read_stream(const uint8_t *p_in, std::vector<T> &r_stream, uint32_t p_count) {
+    memcpy(r_stream.data(), p_in, p_count * sizeof(T));
+    return p_in + p_count * sizeof(T);
+}
+
+void ProjectilePool::write_state(uint8_t *r_buffer) const {
+    PoolStateHeader header = {};
+    header.magic = STATE_MAGIC;
+    header.version = STATE_VERSION;
+    header.count = count;
+    header.capacity = capacity;
+    header.free_count = free_ids.size();
+    header.oldest = oldest;
+    header.newest = newest;
+    header.full_policy = full_policy;
+    header.high_water = high_water;
+    header.dropped_total = dropped_total;
+    header.evicted_total = evicted_total;
+    header.time = time;
+    header.gravity[0] = ballistics.gravity[0];
+    header.gravity[1] = ballistics.gravity[1];
+    header.gravity[2] = ballistics.gravity[2];
+    header.drag = ballistics.drag;
+    memcpy(r_buffer, &header, sizeof(header));
+
+    uint8_t *out = r_buffer + sizeof(header);
+    out = write_stream(out, origin_x, count);
+    out = write_stream(out, origin_y, count);
+    out = write_stream(out, origin_z, count);
+    out = write_stream(out, dir_x, count);
+    out = write_stream(out, dir_y, count);
+    out = write_stream(out, dir_z, count);
+    out = write_stream(out, speed, count);
+    out = write_stream(out, damage, count);
+    out = write_stream(out, max_range, count);
+    out = write_stream(out, traveled, count);
+    out = write_stream(out, spawn_time, count);
+    out = write_stream(out, swept_time, count);
+    out = write_stream(out, shooter, count);
+    out = write_stream(out, id, count);
+
+    out = write_stream(out, dense_of, capacity);
+    out = write_stream(out, order_prev, capacity);
+    out = write_stream(out, order_next, capacity);
+    write_stream(out, free_ids, free_ids.size());
+}
+
+static uint32_t read_id(const uint8_t *p_stream, uint32_t p_index) {
+    uint32_t value;
+    memcpy(&value, p_stream + p_index * sizeof(uint32_t), sizeof(value));
+    return value;
+}
+
+// Checks the id streams of a snapshot in place. Dense ids and dense_of must
+// be inverse permutations, the spawn order must link every live id exactly
+// once and the free list must hold every other id exactly once.
+static bool is_valid_state(const PoolStateHeader &p_header, const uint8_t *p_streams, std::vector<uint8_t> &r_marks) {
+    const uint32_t count = p_header.count;
+    const uint32_t capacity = p_header.capacity;
+    const uint32_t invalid = ProjectilePool::INVALID_ID;
+    const uint8_t *ids = p_streams + count * (DENSE_STATE_STRIDE - sizeof(uint32_t));
+    const uint8_t *dense = ids + count * sizeof(uint32_t);
+    const uint8_t *prev = dense + capacity * sizeof(uint32_t);
+    const uint8_t *next = prev + capacity * sizeof(uint32_t);
+    const uint8_t *free_list = next + capacity * sizeof(uint32_t);
+
+    if (p_header.full_policy > ProjectilePool::FULL_POLICY_GROW) {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t stable_id = read_id(ids, i);
+        if (stable_id >= capacity || read_id(dense, stable_id) != i) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < capacity; i++) {
+        uint32_t dense_index = read_id(dense, i);
+        uint32_t prev_id = read_id(prev, i);
+        uint32_t next_id = read_id(next, i);
+        if (dense_index == invalid) {
+            if (prev_id != invalid || next_id != invalid) {
+                return false;
+            }
+        } else if (dense_index >= count || (prev_id != invalid && prev_id >= capacity) || (next_id != invalid && next_id >= capacity)) {
+            return false;
+        }
+    }
+
+    // Walk the spawn order; a cycle or a dead id cuts it short
+    uint32_t current = p_header.oldest;
+    uint32_t previous = invalid;
+    for (uint32_t i = 0; i < count; i++) {
+        if (current >= capacity || read_id(dense, current) == invalid || read_id(prev, current) != previous) {
+            return false;
+        }
+        previous = current;
+        current = read_id(next, current);
+    }
+    if (current != invalid || p_header.newest != previous) {
+        return false;
+    }
+
+    r_marks.assign(capacity, 0);
+    for (uint32_t i = 0; i < p_header.free_count; i++) {
+        uint32_t free_id = read_id(free_list, i);
+        if (free_id >= capacity || read_id(dense, free_id) != invalid || r_marks[free_id]) {
+            return false;
+        }
+        r_marks[free_id] = 1;
+    }
+    return true;
+}
+
+bool ProjectilePool::read_state(const uint8_t *p_buffer, size_t p_size) {
+    if (p_size < sizeof(PoolStateHeader)) {
+        return false;
+    }
+
+    PoolStateHeader header;
+    memcpy(&header, p_buffer, sizeof(header));
+    if (header.magic != STATE_MAGIC || header.version != STATE_VERSION || header.count > header.capacity ||
+            header.free_count != header.capacity - header.count) {
+        return false;
+    }
+    size_t expected = sizeof(header) + header.count * DENSE_STATE_STRIDE + header.capacity * SPARSE_STATE_STRIDE + header.free_count * sizeof(uint32_t);
+    if (p_size != expected) {
+        return false;
+    }
+
+    if (!is_valid_state(header, p_buffer + sizeof(header), state_marks)) {
+        return false;
+    }
+
+    // Only a capacity change allocates
+    if (header.capacity != capacity) {
+        reset(header.capacity);
+    }
+
+    count = header.count;
+    oldest = header.oldest;
+    newest = header.newest;
+    full_policy = (FullPolicy)header.full_policy;
+    high_water = header.high_water;
+    dropped_total = header.dropped_total;
+    evicted_total = header.evicted_total;
+    time = header.time;
+    ballistics.gravity[0] = header.gravity[0];
+    ballistics.gravity[1] = header.gravity[1];
+    ballistics.gravity[2] = header.gravity[2];
+    ballistics.drag = header.drag;
+
+    const uint8_t *in = p_buffer + sizeof(header);
+    in = read_stream(in, origin_x, count);
+    in = read_stream(in, origin_y, count);
+    in = read_stream(in, origin_z, count);
+    in = read_stream(in, dir_x, count);
+    in = read_stream(in, dir_y, count);
+    in = read_stream(in, dir_z, count);
+    in = read_stream(in, speed, count);
+    in = read_stream(in, damage, count);
+    in = read_stream(in, max_range, count);
+    in = read_stream(in, traveled, count);
+    in = read_stream(in, spawn_time, count);
+    in = read_stream(in, swept_time, count);
+    in = read_stream(in, shooter, count);
+    in = read_stream(in, id, count);
+
+    in = read_stream(in, dense_of, capacity);
+    in = read_stream(in, order_prev, capacity);
+    in = read_stream(in, order_next, capacity);
+    free_ids.resize(header.free_count);
+    read_stream(in, free_ids, header.free_count);
+    return true;
+}
@@ -0,0 +1,134 @@
+#ifndef PROJECTILE_POOL_H
+#define PROJECTILE_POOL_H
+
+#include "projectile_ballistics.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace godot {
+
+// Structure-of-arrays storage for in-flight projectiles. Live projectiles are
+// packed in [0, get_count()); each also has a stable id, linked in spawn order
+// so the oldest can be evicted in O(1). Positions come from ProjectileBallistics.
+class ProjectilePool {
+public:
+    enum FullPolicy {
+        FULL_POLICY_DROP, // Refuse the new projectile
+        FULL_POLICY_EVICT_OLDEST, // Recycle the longest-lived projectile
+        FULL_POLICY_GROW, // Double the capacity
+    };
+
+    static constexpr uint32_t INVALID_ID = 0xFFFFFFFFu;
+
+    struct SpawnParams {
+        float position[3] = { 0.0f, 0.0f, 0.0f };
+        float direction[3] = { 0.0f, 0.0f, -1.0f }; // Expected to be normalized
+        float speed = 0.0f;
+        float damage = 0.0f;
+        float max_range = 0.0f;
+        uint32_t shooter = 0; // EntityRegistry handle, 0 for none
+        // Seconds after the current pool time at which it was fired, so shots
+        // scheduled inside a tick start their flight at the right instant
+        float delay = 0.0f;
+    };
+
+    // Dense per-projectile streams, valid in [0, get_count()).
+    std::vector<float> origin_x, origin_y, origin_z; // Spawn position
+    std::vector<float> dir_x, dir_y, dir_z; // Launch direction
+    std::vector<float> speed; // Launch speed
+    std::vector<float> damage;
+    std::vector<float> max_range;
+    std::vector<float> traveled; // Distance flown at launch speed, ends the flight at max_range
+    std::vector<double> spawn_time;
+    std::vector<double> swept_time; // Collision is resolved up to this time
+    std::vector<uint32_t> shooter; // EntityRegistry handle, cleared when the shooter goes away
+    std::vector<uint32_t> id; // Stable id of the projectile in each dense slot
+
+private:
+    // Sparse tables indexed by stable id
+    std::vector<uint32_t> dense_of;
+    std::vector<uint32_t> order_prev;
+    std::vector<uint32_t> order_next;
+    std::vector<uint32_t> free_ids;
+    std::vector<uint8_t> state_marks; // Scratch for validating a snapshot
+
+    uint32_t oldest = INVALID_ID;
+    uint32_t newest = INVALID_ID;
+
+    uint32_t count = 0;
+    uint32_t capacity = 0;
+    FullPolicy full_policy = FULL_POLICY_EVICT_OLDEST;
+
+    double time = 0.0; // Seconds of simulated flight since reset
+    ProjectileBallistics ballistics;
+
+    // Statistics
+    uint32_t high_water = 0;
+    uint64_t dropped_total = 0;
+    uint64_t evicted_total = 0;
+
+    void resize_storage(uint32_t new_capacity);
+    void link_newest(uint32_t p_id);
+    void unlink(uint32_t p_id);
+
+public:
+    ProjectilePool() {}
+
+    // Drop every projectile and reallocate storage for p_capacity entries.
+    void reset(uint32_t p_capacity);
+    void clear();
+    // Keeps every live projectile, in the same spawn order. Fails when asked
+    // for fewer slots than there are live projectiles; when shrinking, those
+    // whose id no longer fits get a new one.
+    bool set_capacity(uint32_t p_capacity);
+
+    // Returns the stable id of the new projectile, or INVALID_ID when the
+    // pool is full and the policy is FULL_POLICY_DROP.
+    uint32_t spawn(const SpawnParams &p_params);
+
+    // Both run in O(1). Releasing a dense slot moves the last projectile into
+    // it, so callers releasing several slots must go from highest to lowest.
+    void release_dense(uint32_t p_dense_index);
+    void release(uint32_t p_id);
+
+    bool is_alive(uint32_t p_id) const { return p_id < capacity && dense_of[p_id] != INVALID_ID; }
+    uint32_t get_dense_index(uint32_t p_id) const { return p_id < capacity ? dense_of[p_id] : INVALID_ID; }
+
+    uint32_t get_count() const { return count; }
+    uint32_t get_capacity() const { return capacity; }
+    uint32_t get_high_water() const { return high_water; }
+    uint64_t get_dropped_total() const { return dropped_total; }
+    uint64_t get_evicted_total() const { return evicted_total; }
+
+    FullPolicy get_full_policy() const { return full_policy; }
+    void set_full_policy(FullPolicy p_policy) { full_policy = p_policy; }
+
+    // Changing the ballistics bends the remaining path of live projectiles too
+    const ProjectileBallistics &get_ballistics() const { return ballistics; }
+    void set_ballistics(const ProjectileBallistics &p_ballistics) { ballistics = p_ballistics; }
+
+    double get_time() const { return time; }
+    void advance_time(double p_delta) { time += p_delta; }
+
+    // Evaluated on demand from the spawn parameters
+    void get_position(uint32_t p_dense_index, double p_time, float r_position[3]) const;
+    void get_velocity(uint32_t p_dense_index, double p_time, float r_velocity[3]) const;
+    void get_path_bounds(uint32_t p_dense_index, double p_from_time, double p_to_time, float r_min[3], float r_max[3]) const;
+    // When traveled reaches max_range; infinite for a projectile at rest
+    double get_expiry_time(uint32_t p_dense_index) const;
+
+    // Binary snapshot of the complete pool, including ids, free list and
+    // spawn order, so a restored pool replays exactly like the original.
+    // Only live projectiles are written; restoring into a pool of the same
+    // capacity does not allocate. A snapshot whose ids or links do not line up
+    // is rejected and leaves the pool untouched.
+    size_t get_state_size() const;
+    void write_state(uint8_t *r_buffer) const;
+    bool read_state(const uint8_t *p_buffer, size_t p_size);
+};
+
+}
+
+#endif // PROJECTILE_POOL_H
@@ -0,0 +1,270 @@
+#ifndef PROJECTILE_QUEUES_H
+#define PROJECTILE_QUEUES_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+namespace godot {
+
+// Lock-free queues between gameplay threads and the projectile simulation.
+//
+// Both queues are bounded, allocate only in reset() and hold fixed-size
+// trivially copyable records. reset() is not thread-safe and must happen
+// while no other thread touches the queue.
+
+static constexpr size_t QUEUE_CACHE_LINE = 64;
+
+// Bounded multi-producer/single-consumer queue.
+//
+// Every cell carries a sequence number telling producers and the consumer
+// whose turn it is, so producers only contend on one CAS of the enqueue
+// position. A full queue rejects the record and counts an overflow instead of
+// blocking the producer.
+template <typename T>
+class MPSCQueue {
+    static_assert(std::is_trivially_copyable<T>::value, "MPSCQueue records must be trivially copyable");
+
+    struct Cell {
+        std::atomic<uint64_t> sequence;
+        T data;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    uint64_t mask = 0;
+
+    alignas(QUEUE_CACHE_LINE) std::atomic<uint64_t> enqueue_pos{ 0 };
+    alignas(QUEUE_CACHE_LINE) std::atomic<uint64_t> dequeue_pos{ 0 };
+    std::atomic<uint64_t> overflows{ 0 };
+    uint64_t peak_depth = 0; // Consumer side only
+
+public:
+    MPSCQueue() {}
+    MPSCQueue(const MPSCQueue &) = delete;
+    MPSCQueue &operator=(const MPSCQueue &) = delete;
+
+    // Capacity is rounded up to a power of two
+    void reset(uint32_t p_capacity) {
+        uint64_t capacity = 1;
+        while (capacity < p_capacity) {
+            capacity <<= 1;
+        }
+
+        cells.reset(new Cell[capacity]);
+        mask = capacity - 1;
+        for (uint64_t i = 0; i < capacity; i++) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        enqueue_pos.store(0, std::memory_order_relaxed);
+        dequeue_pos.store(0, std::memory_order_relaxed);
+        overflows.store(0, std::memory_order_relaxed);
+        peak_depth = 0;
+    }
+
+    // Safe from any thread. Returns false and counts an overflow when full.
+    bool push(const T &p_value) {
+        if (!cells) {
+            overflows.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        uint64_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        Cell *cell;
+        while (true) {
+            cell = &cells[pos & mask];
+            uint64_t sequence = cell->sequence.load(std::memory_order_acquire);
+            int64_t diff = (int64_t)sequence - (int64_t)pos;
+            if (diff == 0) {
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // The consumer has not freed this cell yet
+                overflows.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->data = p_value;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer thread only
+    bool pop(T &r_value) {
+        if (!cells) {
+            return false;
+        }
+
+        uint64_t pos = dequeue_pos.load(std::memory_order_relaxed);
+        Cell *cell = &cells[pos & mask];
+        if (cell->sequence.load(std::memory_order_acquire) != pos + 1) {
+            return false;
+        }
+
+        r_value = cell->data;
+        cell->sequence.store(pos + mask + 1, std::memory_order_release);
+        dequeue_pos.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Consumer thread only. Samples the depth before a drain for the peak counter.
+    uint32_t sample_depth() {
+        uint32_t depth = get_depth();
+        if (depth > peak_depth) {
+            peak_depth = depth;
+        }
+        return depth;
+    }
+
+    // Approximate while producers are active
+    uint32_t get_depth() const {
+        uint64_t head = enqueue_pos.load(std::memory_order_relaxed);
+        uint64_t tail = dequeue_pos.load(std::memory_order_relaxed);
+        return head > tail ? (uint32_t)(head - tail) : 0;
+    }
+    uint32_t get_peak_depth() const { return (uint32_t)peak_depth; }
+    uint32_t get_capacity() const { return cells ? (uint32_t)(mask + 1) : 0; }
+    uint64_t get_overflow_count() const { return overflows.load(std::memory_order_relaxed); }
+};
+
+// Bounded single-producer/multi-consumer broadcast ring.
+//
+// The producer never waits: it overwrites the oldest record once the ring is
+// full. Each consumer owns a Reader cursor and sees every record in order
+// unless it falls more than a full ring behind, in which case it skips ahead
+// and the skipped records are added to its overflow counter. Records are
+// stored as relaxed atomic words guarded by a per-slot sequence (a seqlock),
+// so a torn read is detected and discarded rather than returned.
+template <typename T>
+class SPMCRing {
+    static_assert(std::is_trivially_copyable<T>::value, "SPMCRing records must be trivially copyable");
+    static_assert(sizeof(T) % sizeof(uint32_t) == 0, "SPMCRing records must be a multiple of 4 bytes");
+
+    static constexpr size_t WORDS = sizeof(T) / sizeof(uint32_t);
+
+    struct Slot {
+        std::atomic<uint64_t> sequence; // 2 * position + 1 while writing, 2 * position + 2 once published
+        std::atomic<uint32_t> words[WORDS];
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    uint64_t mask = 0;
+
+    alignas(QUEUE_CACHE_LINE) std::atomic<uint64_t> head{ 0 };
+    std::atomic<uint64_t> overwrites{ 0 }; // Publishes that reused a slot after the ring wrapped
+
+public:
+    struct Reader {
+        uint64_t cursor = 0;
+        uint64_t lost = 0; // Records this consumer missed by falling behind
+    };
+
+    SPMCRing() {}
+    SPMCRing(const SPMCRing &) = delete;
+    SPMCRing &operator=(const SPMCRing &) = delete;
+
+    // Capacity is rounded up to a power of two
+    void reset(uint32_t p_capacity) {
+        uint64_t capacity = 1;
+        while (capacity < p_capacity) {
+            capacity <<= 1;
+        }
+
+        slots.reset(new Slot[capacity]);
+        mask = capacity - 1;
+        for (uint64_t i = 0; i < capacity; i++) {
+            slots[i].sequence.store(0, std::memory_order_relaxed);
+        }
+        head.store(0, std::memory_order_relaxed);
+        overwrites.store(0, std::memory_order_relaxed);
+    }
+
+    // Producer thread only
+    void publish(const T &p_value) {
+        if (!slots) {
+            return;
+        }
+
+        uint32_t buffer[WORDS];
+        memcpy(buffer, &p_value, sizeof(T));
+
+        uint64_t pos = head.load(std::memory_order_relaxed);
+        Slot &slot = slots[pos & mask];
+        if (pos > mask) {
+            overwrites.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        slot.sequence.store(2 * pos + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; i++) {
+            slot.words[i].store(buffer[i], std::memory_order_relaxed);
+        }
+        slot.sequence.store(2 * pos + 2, std::memory_order_release);
+        head.store(pos + 1, std::memory_order_release);
+    }
+
+    // A reader that only sees records published from now on
+    Reader make_reader() const {
+        Reader reader;
+        reader.cursor = head.load(std::memory_order_acquire);
+        return reader;
+    }
+
+    // Safe from any thread, as long as each Reader is used by one thread at a time
+    bool read(Reader &r_reader, T &r_value) const {
+        if (!slots) {
+            return false;
+        }
+
+        while (true) {
+            uint64_t published = head.load(std::memory_order_acquire);
+            if (r_reader.cursor >= published) {
+                return false;
+            }
+
+            uint64_t capacity = mask + 1;
+            if (published - r_reader.cursor > capacity) {
+                r_reader.lost += published - r_reader.cursor - capacity;
+                r_reader.cursor = published - capacity;
+            }
+
+            const Slot &slot = slots[r_reader.cursor & mask];
+            uint64_t expected = 2 * r_reader.cursor + 2;
+            uint64_t before = slot.sequence.load(std::memory_order_acquire);
+            if (before == expected) {
+                uint32_t buffer[WORDS];
+                for (size_t i = 0; i < WORDS; i++) {
+                    buffer[i] = slot.words[i].load(std::memory_order_relaxed);
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.sequence.load(std::memory_order_relaxed) == expected) {
+                    memcpy(&r_value, buffer, sizeof(T));
+                    r_reader.cursor++;
+                    return true;
+                }
+            }
+
+            // The producer lapped us on this slot, drop the record and move on
+            r_reader.lost++;
+            r_reader.cursor++;
+        }
+    }
+
+    uint32_t get_depth(const Reader &p_reader) const {
+        uint64_t published = head.load(std::memory_order_acquire);
+        uint64_t pending = published > p_reader.cursor ? published - p_reader.cursor : 0;
+        return (uint32_t)(pending < mask + 1 ? pending : mask + 1);
+    }
+    uint32_t get_capacity() const { return slots ? (uint32_t)(mask + 1) : 0; }
+    uint64_t get_published_count() const { return head.load(std::memory_order_relaxed); }
+    uint64_t get_overwrite_count() const { return overwrites.load(std::memory_order_relaxed); }
+};
+
+}
+
+#endif // PROJECTILE_QUEUES_H
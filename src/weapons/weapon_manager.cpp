@@ -1,18 +1,86 @@
 #include "weapon_manager.hpp"
+#include "projectile_manager.hpp"
+#include "../combat/entities.hpp"
+#include "../debug/perf_monitors.hpp"
+#include "../debug/trace.hpp"
 #include <godot_cpp/classes/input_event_mouse_motion.hpp>
 #include <godot_cpp/classes/input_event_mouse_button.hpp>
 #include <godot_cpp/core/class_db.hpp>
 #include <godot_cpp/variant/utility_functions.hpp>
 #include <godot_cpp/classes/mesh_instance3d.hpp>
+#include <godot_cpp/classes/time.hpp>
+#include <godot_cpp/variant/callable_method_pointer.hpp>
+
+#include <cstring>
 
 using namespace godot;
 
+// Snapshot layouts, copied as-is into the PackedByteArray
+struct WeaponState {
+    uint32_t magic;
+    uint32_t version;
+    double shot_age[Weapon::MAX_RECOIL_SHOTS];
+    double shot_cooldown;
+    double time_since_shot;
+    int32_t shot_count;
+    int32_t spray_index;
+    double press_offset;
+    double release_offset;
+    uint8_t trigger_held;
+    uint8_t press_pending;
+    uint8_t reserved[6];
+};
+
+struct WeaponManagerState {
+    uint32_t magic;
+    uint32_t version;
+    real_t target_sway[2];
+    real_t current_sway[2];
+    double bob_time;
+    double bob_offset;
+    uint8_t is_moving;
+    uint8_t reserved[7];
+};
+
+static const uint32_t WEAPON_STATE_MAGIC = 0x4E504557; // "WEPN"
+static const uint32_t WEAPON_MANAGER_STATE_MAGIC = 0x52474D57; // "WMGR"
+static const uint32_t STATE_VERSION = 3;
+
+// Runs after the weapons so the recoil layer sees this frame's kick
+static const int VIEWMODEL_PROCESS_PRIORITY = 1;
+
+// Below this a decaying layer snaps to zero and counts as settled
+static const double LAYER_SETTLE_EPSILON = 1e-5;
+
+template <typename T>
+static PackedByteArray pack_state(const T &p_state) {
+    PackedByteArray bytes;
+    bytes.resize(sizeof(T));
+    memcpy(bytes.ptrw(), &p_state, sizeof(T));
+    return bytes;
+}
+
+template <typename T>
+static bool unpack_state(const PackedByteArray &p_bytes, uint32_t p_magic, T &r_state) {
+    if (p_bytes.size() != (int64_t)sizeof(T)) {
+        return false;
+    }
+    memcpy(&r_state, p_bytes.ptr(), sizeof(T));
+    return r_state.magic == p_magic && r_state.version == STATE_VERSION;
+}
+
 // ================ WEAPON CLASS ================
 
+uint64_t Weapon::shot_window_start_usec = 0;
+int Weapon::shots_in_window = 0;
+int Weapon::shots_last_window = 0;
+
 Weapon::Weapon() {
     recoil_amplifier = 1.0;
-    is_in_recoil = false;
-    current_recoil_time = 0.0;
+    shot_count = 0;
+    time_since_shot = spray_recovery_time;
+    memset(shot_age, 0, sizeof(shot_age));
+    bake_recoil_tables();
 }
 
 Weapon::~Weapon() {}
@@ -22,6 +90,82 @@ void Weapon::_bind_methods() {
     ClassDB::bind_method(D_METHOD("setup_pistol_parts"), &Weapon::setup_pistol_parts);
     ClassDB::bind_method(D_METHOD("get_recoil_amplifier"), &Weapon::get_recoil_amplifier);
     ClassDB::bind_method(D_METHOD("set_recoil_amplifier", "amplifier"), &Weapon::set_recoil_amplifier);
+    ClassDB::bind_method(D_METHOD("get_recoil_duration"), &Weapon::get_recoil_duration);
+    ClassDB::bind_method(D_METHOD("set_recoil_duration", "duration"), &Weapon::set_recoil_duration);
+    ClassDB::bind_method(D_METHOD("get_recoil_max_stack"), &Weapon::get_recoil_max_stack);
+    ClassDB::bind_method(D_METHOD("set_recoil_max_stack", "max_stack"), &Weapon::set_recoil_max_stack);
+    ClassDB::bind_method(D_METHOD("get_recoil_curve", "part"), &Weapon::get_recoil_curve);
+    ClassDB::bind_method(D_METHOD("set_recoil_curve", "part", "curve"), &Weapon::set_recoil_curve);
+    ClassDB::bind_method(D_METHOD("get_recoil_slide_curve"), &Weapon::get_recoil_slide_curve);
+    ClassDB::bind_method(D_METHOD("set_recoil_slide_curve", "curve"), &Weapon::set_recoil_slide_curve);
+    ClassDB::bind_method(D_METHOD("get_recoil_hammer_curve"), &Weapon::get_recoil_hammer_curve);
+    ClassDB::bind_method(D_METHOD("set_recoil_hammer_curve", "curve"), &Weapon::set_recoil_hammer_curve);
+    ClassDB::bind_method(D_METHOD("get_recoil_trigger_curve"), &Weapon::get_recoil_trigger_curve);
+    ClassDB::bind_method(D_METHOD("set_recoil_trigger_curve", "curve"), &Weapon::set_recoil_trigger_curve);
+    ClassDB::bind_method(D_METHOD("get_recoil_kick_curve"), &Weapon::get_recoil_kick_curve);
+    ClassDB::bind_method(D_METHOD("set_recoil_kick_curve", "curve"), &Weapon::set_recoil_kick_curve);
+    ClassDB::bind_method(D_METHOD("bake_recoil_tables"), &Weapon::bake_recoil_tables);
+    ClassDB::bind_method(D_METHOD("get_spray_pattern"), &Weapon::get_spray_pattern);
+    ClassDB::bind_method(D_METHOD("set_spray_pattern", "pattern"), &Weapon::set_spray_pattern);
+    ClassDB::bind_method(D_METHOD("get_spray_recovery_time"), &Weapon::get_spray_recovery_time);
+    ClassDB::bind_method(D_METHOD("set_spray_recovery_time", "time"), &Weapon::set_spray_recovery_time);
+    ClassDB::bind_method(D_METHOD("get_spray_index"), &Weapon::get_spray_index);
+    ClassDB::bind_method(D_METHOD("set_trigger_held", "held", "tick_offset"), &Weapon::set_trigger_held, DEFVAL(0.0));
+    ClassDB::bind_static_method("Weapon", D_METHOD("get_shots_per_second"), &Weapon::get_shots_per_second);
+    ClassDB::bind_method(D_METHOD("get_recoil_kick"), &Weapon::get_recoil_kick);
+    ClassDB::bind_method(D_METHOD("is_recoiling"), &Weapon::is_recoiling);
+    ClassDB::bind_method(D_METHOD("save_state"), &Weapon::save_state);
+    ClassDB::bind_method(D_METHOD("load_state", "state"), &Weapon::load_state);
+
+    ClassDB::bind_method(D_METHOD("get_fire_mode"), &Weapon::get_fire_mode);
+    ClassDB::bind_method(D_METHOD("set_fire_mode", "mode"), &Weapon::set_fire_mode);
+    ClassDB::bind_method(D_METHOD("get_damage"), &Weapon::get_damage);
+    ClassDB::bind_method(D_METHOD("set_damage", "damage"), &Weapon::set_damage);
+    ClassDB::bind_method(D_METHOD("get_range"), &Weapon::get_range);
+    ClassDB::bind_method(D_METHOD("set_range", "range"), &Weapon::set_range);
+    ClassDB::bind_method(D_METHOD("get_projectile_speed"), &Weapon::get_projectile_speed);
+    ClassDB::bind_method(D_METHOD("set_projectile_speed", "speed"), &Weapon::set_projectile_speed);
+    ClassDB::bind_method(D_METHOD("get_rounds_per_minute"), &Weapon::get_rounds_per_minute);
+    ClassDB::bind_method(D_METHOD("set_rounds_per_minute", "rpm"), &Weapon::set_rounds_per_minute);
+    ClassDB::bind_method(D_METHOD("get_automatic"), &Weapon::get_automatic);
+    ClassDB::bind_method(D_METHOD("set_automatic", "automatic"), &Weapon::set_automatic);
+
+    ADD_GROUP("Firing", "");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "fire_mode", PROPERTY_HINT_ENUM, "Hitscan,Projectile"), "set_fire_mode", "get_fire_mode");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "damage", PROPERTY_HINT_RANGE, "0,1000,0.1,or_greater"), "set_damage", "get_damage");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "range", PROPERTY_HINT_RANGE, "1,5000,1,or_greater,suffix:m"), "set_range", "get_range");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "projectile_speed", PROPERTY_HINT_RANGE, "1,2000,1,or_greater,suffix:m/s"), "set_projectile_speed", "get_projectile_speed");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "rounds_per_minute", PROPERTY_HINT_RANGE, "1,2000,1,or_greater"), "set_rounds_per_minute", "get_rounds_per_minute");
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "automatic"), "set_automatic", "get_automatic");
+
+    ADD_GROUP("Recoil", "recoil_");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "recoil_duration", PROPERTY_HINT_RANGE, "0.01,2,0.01,suffix:s"), "set_recoil_duration", "get_recoil_duration");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "recoil_max_stack", PROPERTY_HINT_RANGE, "1,10,0.1"), "set_recoil_max_stack", "get_recoil_max_stack");
+    ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "recoil_slide_curve", PROPERTY_HINT_RESOURCE_TYPE, "Curve"), "set_recoil_slide_curve", "get_recoil_slide_curve");
+    ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "recoil_hammer_curve", PROPERTY_HINT_RESOURCE_TYPE, "Curve"), "set_recoil_hammer_curve", "get_recoil_hammer_curve");
+    ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "recoil_trigger_curve", PROPERTY_HINT_RESOURCE_TYPE, "Curve"), "set_recoil_trigger_curve", "get_recoil_trigger_curve");
+    ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "recoil_kick_curve", PROPERTY_HINT_RESOURCE_TYPE, "Curve"), "set_recoil_kick_curve", "get_recoil_kick_curve");
+
+    ADD_GROUP("Spray", "spray_");
+    ADD_PROPERTY(PropertyInfo(Variant::PACKED_VECTOR2_ARRAY, "spray_pattern"), "set_spray_pattern", "get_spray_pattern");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "spray_recovery_time", PROPERTY_HINT_RANGE, "0,2,0.01,suffix:s"), "set_spray_recovery_time", "get_spray_recovery_time");
+
+    BIND_ENUM_CONSTANT(FIRE_MODE_HITSCAN);
+    BIND_ENUM_CONSTANT(FIRE_MODE_PROJECTILE);
+    BIND_ENUM_CONSTANT(RECOIL_PART_SLIDE);
+    BIND_ENUM_CONSTANT(RECOIL_PART_HAMMER);
+    BIND_ENUM_CONSTANT(RECOIL_PART_TRIGGER);
+    BIND_ENUM_CONSTANT(RECOIL_PART_KICK);
+    BIND_ENUM_CONSTANT(RECOIL_PART_MAX);
+}
+
+void Weapon::_notification(int p_what) {
+    // The player holding us enters the tree first and owns our shots
+    if (p_what == NOTIFICATION_ENTER_TREE) {
+        entity = Entities::register_node(this, EntityRegistry::KIND_WEAPON, Entities::find_ancestor(this, EntityRegistry::KIND_PLAYER));
+    } else if (p_what == NOTIFICATION_EXIT_TREE) {
+        Entities::unregister(entity);
+    }
 }
 
 void Weapon::_ready() {
@@ -29,11 +173,77 @@ void Weapon::_ready() {
 }
 
 void Weapon::_process(double delta) {
-    if (is_in_recoil) {
+    if (shot_count > 0) {
+        TRACE_SCOPE("Weapon::update_recoil");
         update_recoil(delta);
     }
 }
 
+void Weapon::_physics_process(double delta) {
+    // Shots due during this tick are placed at their exact time within it and
+    // fired from the muzzle pose interpolated between the last tick and now
+    Transform3D aim = get_aim_transform();
+    if (!has_previous_aim) {
+        previous_aim = aim;
+        has_previous_aim = true;
+    }
+
+    double interval = 60.0 / rounds_per_minute;
+    double next_shot = MAX(shot_cooldown, 0.0); // Seconds into this tick
+    double last_shot = -1.0;
+    shot_batch.clear();
+
+    auto schedule = [&](double time) {
+        float fraction = delta > 0.0 ? (float)(time / delta) : 1.0f;
+        add_shot(previous_aim.interpolate_with(aim, fraction), time, last_shot >= 0.0 ? time - last_shot : time_since_shot + time);
+        last_shot = time;
+    };
+
+    // A press fires once even on semi-automatic weapons, if the cooldown allows
+    if (press_pending) {
+        press_pending = false;
+        next_shot = MAX(next_shot, press_offset);
+        if (next_shot < delta) {
+            schedule(next_shot);
+            next_shot += interval;
+        }
+    }
+
+    // Automatic weapons keep firing at their cyclic rate while the trigger is
+    // held, including the part of the tick before a release
+    double fire_end = trigger_held ? delta : MIN(release_offset, delta);
+    if (automatic) {
+        while (next_shot < fire_end) {
+            schedule(next_shot);
+            next_shot += interval;
+        }
+    }
+    press_offset = 0.0;
+    release_offset = 0.0;
+
+    shot_cooldown = MAX(next_shot - delta, 0.0);
+    time_since_shot = last_shot >= 0.0 ? delta - last_shot : time_since_shot + delta;
+    previous_aim = aim;
+    flush_shots();
+}
+
+void Weapon::set_trigger_held(bool held, double tick_offset) {
+    bool pressed = held && !trigger_held;
+    bool released = !held && trigger_held;
+    trigger_held = held;
+    tick_offset = MAX(tick_offset, 0.0);
+
+    // Fired by the scheduler on the next physics tick, at the time of the
+    // press if the cooldown has run out by then
+    if (pressed && !press_pending && shot_cooldown <= tick_offset) {
+        press_pending = true;
+        press_offset = tick_offset;
+    }
+    if (released) {
+        release_offset = tick_offset;
+    }
+}
+
 void Weapon::setup_pistol_parts() {
     // Find pistol parts in the scene - try multiple possible names
     pistol_root = this;
@@ -54,113 +264,264 @@ void Weapon::setup_pistol_parts() {
     if (!pistol_trigger) pistol_trigger = Object::cast_to<Node3D>(get_node_or_null("Pistol_Trigger"));
     
     // Print what we found for debugging
-    UtilityFunctions::print("Weapon: Setup pistol parts complete");
-    UtilityFunctions::print("  Slide found: ", pistol_slide != nullptr ? "Yes" : "No");
-    UtilityFunctions::print("  Hammer found: ", pistol_hammer != nullptr ? "Yes" : "No");
-    UtilityFunctions::print("  Trigger found: ", pistol_trigger != nullptr ? "Yes" : "No");
+    TRACE_PRINT("Weapon: Setup pistol parts complete");
+    TRACE_PRINT("  Slide found: ", pistol_slide != nullptr ? "Yes" : "No");
+    TRACE_PRINT("  Hammer found: ", pistol_hammer != nullptr ? "Yes" : "No");
+    TRACE_PRINT("  Trigger found: ", pistol_trigger != nullptr ? "Yes" : "No");
     
+#ifdef GODOTCON_TRACE
     // If no parts found, list all children for debugging
     if (!pistol_slide && !pistol_hammer && !pistol_trigger) {
-        UtilityFunctions::print("Available child nodes:");
+        TRACE_PRINT("Available child nodes:");
         for (int i = 0; i < get_child_count(); i++) {
             Node* child = get_child(i);
-            UtilityFunctions::print("  - ", child->get_name());
+            TRACE_PRINT("  - ", child->get_name());
         }
     }
+#endif
+}
+
+void Weapon::roll_shot_window(uint64_t now_usec) {
+    uint64_t elapsed = now_usec - shot_window_start_usec;
+    if (elapsed < 1000000) {
+        return;
+    }
+    // A window with no shots at all reads as zero, not as the last busy one
+    shots_last_window = elapsed < 2000000 ? shots_in_window : 0;
+    shots_in_window = 0;
+    shot_window_start_usec = now_usec;
+}
+
+int Weapon::get_shots_per_second() {
+    roll_shot_window(Time::get_singleton()->get_ticks_usec());
+    return shots_last_window;
 }
 
 void Weapon::fire() {
-    play_recoil_animation();
+    TRACE_SCOPE("Weapon::fire");
+    if (!is_inside_tree()) return;
+
+    // Immediate single shot outside the scheduler, e.g. from a script
+    shot_cooldown += 60.0 / rounds_per_minute;
+    shot_batch.clear();
+    add_shot(get_aim_transform(), 0.0, time_since_shot);
+    time_since_shot = 0.0;
+    flush_shots();
 }
 
-void Weapon::play_recoil_animation() {
-    if (is_in_recoil) {
-        reset_parts(); // Reset if already recoiling
-    }
-    
-    // Calculate scaled values
-    Vector3 slide_kick = base_slide_distance * recoil_amplifier;
-    Vector3 hammer_kick = base_hammer_rotation * recoil_amplifier;
-    Vector3 trigger_kick = base_trigger_pull * recoil_amplifier;
-    Vector3 weapon_kick = base_weapon_kick * recoil_amplifier;
-    
-    // Apply recoil to parts
-    if (pistol_slide) {
-        Vector3 pos = pistol_slide->get_position();
-        pistol_slide->set_position(pos + slide_kick);
+Transform3D Weapon::get_aim_transform() const {
+    // Aim along the holder (camera or weapon manager), not the kicked-back weapon model
+    Node3D* aim = Object::cast_to<Node3D>(get_parent());
+    if (!aim) aim = const_cast<Weapon*>(this);
+    return aim->get_global_transform();
+}
+
+void Weapon::add_shot(const Transform3D &muzzle, double delay, double since_last_shot) {
+    // A pause long enough to recover restarts the spray from its first shot
+    if (since_last_shot >= spray_recovery_time) {
+        spray_index = 0;
     }
-    
-    if (pistol_hammer) {
-        Vector3 rot = pistol_hammer->get_rotation_degrees();
-        pistol_hammer->set_rotation_degrees(rot + hammer_kick);
+
+    Vector3 direction = -muzzle.basis.get_column(2);
+
+    // Past its last entry the pattern holds the final offset
+    if (!spray_pattern.is_empty()) {
+        Vector2 offset = spray_pattern[MIN(spray_index, (int)spray_pattern.size() - 1)];
+        Vector3 right = muzzle.basis.get_column(0).normalized();
+        Vector3 up = muzzle.basis.get_column(1).normalized();
+        direction = direction.rotated(right, Math::deg_to_rad(offset.x)).rotated(up, -Math::deg_to_rad(offset.y));
     }
-    
-    if (pistol_trigger) {
-        Vector3 pos = pistol_trigger->get_position();
-        pistol_trigger->set_position(pos + trigger_kick);
+    spray_index++;
+
+    ScheduledShot shot;
+    shot.origin = muzzle.origin;
+    shot.direction = direction;
+    shot.delay = delay;
+    shot_batch.push_back(shot);
+    push_recoil_shot();
+}
+
+void Weapon::flush_shots() {
+    if (shot_batch.empty()) return;
+    TRACE_SCOPE("Weapon::flush_shots");
+
+    roll_shot_window(Time::get_singleton()->get_ticks_usec());
+    shots_in_window += shot_batch.size();
+    apply_recoil_pose();
+
+    // The whole burst of the tick goes to the projectile system in one call
+    ProjectileManager* projectile_manager = ProjectileManager::get_singleton();
+    if (projectile_manager) {
+        projectile_manager->queue_shots(shot_batch, fire_mode == FIRE_MODE_HITSCAN, projectile_speed, damage, range, entity);
     }
-    
-    if (pistol_root) {
-        Vector3 rot = pistol_root->get_rotation_degrees();
-        pistol_root->set_rotation_degrees(rot + weapon_kick);
+    shot_batch.clear();
+}
+
+void Weapon::play_recoil_animation() {
+    push_recoil_shot();
+    apply_recoil_pose();
+}
+
+void Weapon::push_recoil_shot() {
+    // Overlapping shots add up instead of snapping the parts back to rest
+    if (shot_count == MAX_RECOIL_SHOTS) {
+        memmove(shot_age, shot_age + 1, (MAX_RECOIL_SHOTS - 1) * sizeof(double));
+        shot_count--;
     }
-    
-    is_in_recoil = true;
-    current_recoil_time = 0.0;
-    
-    UtilityFunctions::print("Weapon: Recoil animation started with amplifier ", recoil_amplifier);
+    shot_age[shot_count++] = 0.0;
 }
 
 void Weapon::update_recoil(double delta) {
-    current_recoil_time += delta;
-    
-    if (current_recoil_time >= recoil_duration) {
+    for (int i = 0; i < shot_count; i++) {
+        shot_age[i] += delta;
+    }
+
+    // Shots age together, so the finished ones are at the front
+    int finished = 0;
+    while (finished < shot_count && shot_age[finished] >= recoil_duration) {
+        finished++;
+    }
+    if (finished == shot_count) {
         reset_parts();
         return;
     }
-    
-    // Smooth return to rest position
-    double progress = current_recoil_time / recoil_duration;
-    double ease_out = 1.0 - (1.0 - progress) * (1.0 - progress);
-    
-    Vector3 slide_kick = base_slide_distance * recoil_amplifier;
-    Vector3 hammer_kick = base_hammer_rotation * recoil_amplifier;
-    Vector3 trigger_kick = base_trigger_pull * recoil_amplifier;
-    Vector3 weapon_kick = base_weapon_kick * recoil_amplifier;
-    
+    if (finished > 0) {
+        memmove(shot_age, shot_age + finished, (shot_count - finished) * sizeof(double));
+        shot_count -= finished;
+    }
+
+    apply_recoil_pose();
+}
+
+float Weapon::sample_recoil(int part) const {
+    const float *table = recoil_tables[part];
+    float scale = (RECOIL_TABLE_SIZE - 1) / recoil_duration;
+    float total = 0.0f;
+    for (int i = 0; i < shot_count; i++) {
+        float x = shot_age[i] * scale;
+        int index = (int)x;
+        if (index >= RECOIL_TABLE_SIZE - 1) {
+            total += table[RECOIL_TABLE_SIZE - 1];
+        } else {
+            total += table[index] + (table[index + 1] - table[index]) * (x - index);
+        }
+    }
+    return MIN(total, (float)recoil_max_stack);
+}
+
+void Weapon::apply_recoil_pose() {
     if (pistol_slide) {
-        Vector3 target = slide_kick * (1.0 - ease_out);
-        pistol_slide->set_position(target);
+        pistol_slide->set_position(base_slide_distance * recoil_amplifier * sample_recoil(RECOIL_PART_SLIDE));
     }
-    
     if (pistol_hammer) {
-        Vector3 target = hammer_kick * (1.0 - ease_out);
-        pistol_hammer->set_rotation_degrees(target);
+        pistol_hammer->set_rotation_degrees(base_hammer_rotation * recoil_amplifier * sample_recoil(RECOIL_PART_HAMMER));
     }
-    
     if (pistol_trigger) {
-        Vector3 target = trigger_kick * (1.0 - ease_out);
-        pistol_trigger->set_position(target);
+        pistol_trigger->set_position(base_trigger_pull * recoil_amplifier * sample_recoil(RECOIL_PART_TRIGGER));
     }
-    
-    if (pistol_root) {
-        Vector3 target = weapon_kick * (1.0 - ease_out);
-        pistol_root->set_rotation_degrees(target);
+    if (pistol_root && !viewmodel_managed) {
+        pistol_root->set_rotation_degrees(get_recoil_kick());
+    }
+}
+
+Vector3 Weapon::get_recoil_kick() const {
+    if (shot_count == 0) {
+        return Vector3();
+    }
+    return base_weapon_kick * recoil_amplifier * sample_recoil(RECOIL_PART_KICK);
+}
+
+void Weapon::bake_recoil_table(int part) {
+    const Ref<Curve> &curve = recoil_curves[part];
+    for (int i = 0; i < RECOIL_TABLE_SIZE; i++) {
+        float t = (float)i / (RECOIL_TABLE_SIZE - 1);
+        recoil_tables[part][i] = curve.is_valid() ? (float)curve->sample_baked(t) : (1.0f - t) * (1.0f - t);
+    }
+}
+
+void Weapon::bake_recoil_tables() {
+    for (int part = 0; part < RECOIL_PART_MAX; part++) {
+        bake_recoil_table(part);
+    }
+}
+
+Ref<Curve> Weapon::get_recoil_curve(RecoilPart part) const {
+    ERR_FAIL_INDEX_V(part, RECOIL_PART_MAX, Ref<Curve>());
+    return recoil_curves[part];
+}
+
+void Weapon::set_recoil_curve(RecoilPart part, const Ref<Curve> &curve) {
+    ERR_FAIL_INDEX(part, RECOIL_PART_MAX);
+
+    // Rebake when the curve is edited, e.g. in the inspector
+    Callable rebake = callable_mp(this, &Weapon::bake_recoil_tables);
+    if (recoil_curves[part].is_valid() && recoil_curves[part]->is_connected("changed", rebake)) {
+        recoil_curves[part]->disconnect("changed", rebake);
+    }
+    recoil_curves[part] = curve;
+    if (curve.is_valid() && !curve->is_connected("changed", rebake)) {
+        curve->connect("changed", rebake);
+    }
+    bake_recoil_table(part);
+}
+
+void Weapon::set_viewmodel_managed(bool managed) {
+    viewmodel_managed = managed;
+}
+
+PackedByteArray Weapon::save_state() const {
+    WeaponState state = {};
+    state.magic = WEAPON_STATE_MAGIC;
+    state.version = STATE_VERSION;
+    memcpy(state.shot_age, shot_age, sizeof(shot_age));
+    state.shot_cooldown = shot_cooldown;
+    state.time_since_shot = time_since_shot;
+    state.shot_count = shot_count;
+    state.spray_index = spray_index;
+    state.press_offset = press_offset;
+    state.release_offset = release_offset;
+    state.trigger_held = trigger_held;
+    state.press_pending = press_pending;
+    return pack_state(state);
+}
+
+bool Weapon::load_state(const PackedByteArray &state_bytes) {
+    WeaponState state;
+    ERR_FAIL_COND_V_MSG(!unpack_state(state_bytes, WEAPON_STATE_MAGIC, state), false, "Weapon: Invalid state.");
+    ERR_FAIL_COND_V_MSG(state.shot_count < 0 || state.shot_count > MAX_RECOIL_SHOTS, false, "Weapon: Invalid state.");
+
+    shot_cooldown = state.shot_cooldown;
+    time_since_shot = state.time_since_shot;
+    spray_index = state.spray_index;
+    press_offset = state.press_offset;
+    release_offset = state.release_offset;
+    trigger_held = state.trigger_held;
+    press_pending = state.press_pending;
+
+    // Part transforms are a function of the shot ages, rebuild them
+    if (state.shot_count > 0) {
+        memcpy(shot_age, state.shot_age, sizeof(shot_age));
+        shot_count = state.shot_count;
+        apply_recoil_pose();
+    } else {
+        reset_parts();
     }
+    return true;
 }
 
 void Weapon::reset_parts() {
     if (pistol_slide) pistol_slide->set_position(Vector3(0, 0, 0));
     if (pistol_hammer) pistol_hammer->set_rotation_degrees(Vector3(0, 0, 0));
     if (pistol_trigger) pistol_trigger->set_position(Vector3(0, 0, 0));
-    if (pistol_root) pistol_root->set_rotation_degrees(Vector3(0, 0, 0));
+    if (pistol_root && !viewmodel_managed) pistol_root->set_rotation_degrees(Vector3(0, 0, 0));
     
-    is_in_recoil = false;
-    current_recoil_time = 0.0;
+    shot_count = 0;
 }
 
 // ================ WEAPON MANAGER CLASS ================
 
+int WeaponManager::monitor_users = 0;
+
 WeaponManager::WeaponManager() {
     sway_intensity = 1.0;
     sway_smoothness = 5.0;
@@ -175,8 +536,12 @@ WeaponManager::~WeaponManager() {}
 void WeaponManager::_bind_methods() {
     ClassDB::bind_method(D_METHOD("apply_mouse_input", "mouse_delta"), &WeaponManager::apply_mouse_input);
     ClassDB::bind_method(D_METHOD("set_movement_state", "moving"), &WeaponManager::set_movement_state);
-    ClassDB::bind_method(D_METHOD("handle_shoot_input", "pressed"), &WeaponManager::handle_shoot_input);
+    ClassDB::bind_method(D_METHOD("handle_shoot_input", "pressed", "tick_offset"), &WeaponManager::handle_shoot_input, DEFVAL(0.0));
     ClassDB::bind_method(D_METHOD("set_weapon_recoil_amplifier", "weapon_index", "amplifier"), &WeaponManager::set_weapon_recoil_amplifier);
+    ClassDB::bind_method(D_METHOD("get_weapon_count"), &WeaponManager::get_weapon_count);
+    ClassDB::bind_method(D_METHOD("is_layer_active", "layer"), &WeaponManager::is_layer_active);
+    ClassDB::bind_method(D_METHOD("save_state"), &WeaponManager::save_state);
+    ClassDB::bind_method(D_METHOD("load_state", "state"), &WeaponManager::load_state);
     
     ClassDB::bind_method(D_METHOD("get_sway_intensity"), &WeaponManager::get_sway_intensity);
     ClassDB::bind_method(D_METHOD("set_sway_intensity", "intensity"), &WeaponManager::set_sway_intensity);
@@ -192,38 +557,115 @@ void WeaponManager::_bind_methods() {
     ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "bob_intensity", PROPERTY_HINT_RANGE, "0.001,0.1,0.001"), "set_bob_intensity", "get_bob_intensity");
     ADD_PROPERTY(PropertyInfo(Variant::BOOL, "enable_sway"), "set_enable_sway", "get_enable_sway");
     ADD_PROPERTY(PropertyInfo(Variant::BOOL, "enable_bob"), "set_enable_bob", "get_enable_bob");
+
+    BIND_ENUM_CONSTANT(LAYER_SWAY);
+    BIND_ENUM_CONSTANT(LAYER_BOB);
+    BIND_ENUM_CONSTANT(LAYER_RECOIL);
+    BIND_ENUM_CONSTANT(LAYER_MAX);
+}
+
+void WeaponManager::_notification(int p_what) {
+    // Children enter after us, so connecting here sees every weapon
+    if (p_what == NOTIFICATION_ENTER_TREE) {
+        Callable entered = callable_mp(this, &WeaponManager::on_child_entered);
+        if (!is_connected("child_entered_tree", entered)) {
+            connect("child_entered_tree", entered);
+            connect("child_exiting_tree", callable_mp(this, &WeaponManager::on_child_exiting));
+        }
+        if (monitor_users++ == 0) {
+            PerfMonitors::add("Weapons/Shots Per Second", callable_mp_static(&Weapon::get_shots_per_second));
+        }
+    } else if (p_what == NOTIFICATION_EXIT_TREE) {
+        if (--monitor_users == 0) {
+            PerfMonitors::remove("Weapons/Shots Per Second");
+        }
+    }
 }
 
 void WeaponManager::_ready() {
-    store_positions();
+    set_process_priority(VIEWMODEL_PROCESS_PRIORITY);
 }
 
 void WeaponManager::_process(double delta) {
-    if (enable_sway) update_sway(delta);
-    if (enable_bob) update_bob(delta);
+    TRACE_SCOPE("WeaponManager::process");
+    active_layers = 0;
+    bool sway_active = enable_sway && update_sway(delta);
+    bool bob_active = enable_bob && update_bob(delta);
+    if (sway_active) active_layers |= 1u << LAYER_SWAY;
+    if (bob_active) active_layers |= 1u << LAYER_BOB;
+
+    Vector3 shared_offset;
+    if (sway_active) {
+        shared_offset.x += current_sway.x;
+        shared_offset.y += current_sway.y;
+    }
+    if (bob_active) {
+        shared_offset.y += bob_offset;
+    }
+    apply_layers(shared_offset, sway_active || bob_active);
 }
 
-void WeaponManager::_input(const Ref<InputEvent>& event) {
-    Ref<InputEventMouseButton> mouse_button = event;
-    if (mouse_button.is_valid() && mouse_button->get_button_index() == MOUSE_BUTTON_LEFT) {
-        UtilityFunctions::print("WeaponManager: Left mouse button ", mouse_button->is_pressed() ? "pressed" : "released");
-        handle_shoot_input(mouse_button->is_pressed());
+void WeaponManager::apply_layers(const Vector3 &shared_offset, bool shared_active) {
+    for (ViewmodelSlot &slot : slots) {
+        bool kick_active = slot.weapon && slot.weapon->is_recoiling();
+        if (!shared_active && !kick_active && !slot.displaced) {
+            continue;
+        }
+
+        // A settled weapon is at rest, so pick up any pose set since (e.g. in _ready)
+        if (!slot.displaced) {
+            slot.rest = slot.node->get_transform();
+        }
+
+        // Every layer lands in one transform write relative to the rest pose
+        Transform3D transform = slot.rest;
+        transform.origin += shared_offset;
+        if (kick_active) {
+            Vector3 kick = slot.weapon->get_recoil_kick() * (Math_PI / 180.0);
+            transform.basis = transform.basis * Basis::from_euler(kick);
+            active_layers |= 1u << LAYER_RECOIL;
+        }
+        slot.node->set_transform(transform);
+        slot.displaced = shared_active || kick_active;
     }
 }
 
-void WeaponManager::store_positions() {
-    weapon_children.clear();
-    original_positions.clear();
-    
-    for (int i = 0; i < get_child_count(); i++) {
-        Node3D* child = Object::cast_to<Node3D>(get_child(i));
-        if (child) {
-            weapon_children.append(child);
-            original_positions.append(child->get_position());
+void WeaponManager::on_child_entered(Node* child) {
+    Node3D* node = Object::cast_to<Node3D>(child);
+    if (!node) return;
+
+    ViewmodelSlot slot;
+    slot.node = node;
+    slot.weapon = Object::cast_to<Weapon>(node);
+    slot.rest = node->get_transform();
+    if (slot.weapon) {
+        slot.weapon->set_viewmodel_managed(true);
+    }
+    slots.push_back(slot);
+}
+
+void WeaponManager::on_child_exiting(Node* child) {
+    for (size_t i = 0; i < slots.size(); i++) {
+        if (slots[i].node != child) continue;
+
+        // Leave the node at rest so it can be re-added or reparented cleanly
+        if (slots[i].displaced) {
+            slots[i].node->set_transform(slots[i].rest);
         }
+        if (slots[i].weapon) {
+            slots[i].weapon->set_viewmodel_managed(false);
+        }
+        slots.erase(slots.begin() + i);
+        return;
+    }
+}
+
+void WeaponManager::_input(const Ref<InputEvent>& event) {
+    Ref<InputEventMouseButton> mouse_button = event;
+    if (mouse_button.is_valid() && mouse_button->get_button_index() == MOUSE_BUTTON_LEFT) {
+        TRACE_PRINT("WeaponManager: Left mouse button ", mouse_button->is_pressed() ? "pressed" : "released");
+        handle_shoot_input(mouse_button->is_pressed());
     }
-    
-    UtilityFunctions::print("WeaponManager: Stored ", weapon_children.size(), " weapon positions");
 }
 
 void WeaponManager::apply_mouse_input(Vector2 mouse_delta) {
@@ -232,75 +674,94 @@ void WeaponManager::apply_mouse_input(Vector2 mouse_delta) {
     target_sway = mouse_delta * sway_intensity * 0.001;
 }
 
-void WeaponManager::update_sway(double delta) {
-    current_sway = current_sway.lerp(target_sway, sway_smoothness * delta);
-    
-    for (int i = 0; i < weapon_children.size(); i++) {
-        Variant weapon_variant = weapon_children[i];
-        Node3D* weapon = Object::cast_to<Node3D>(weapon_variant);
-        Variant pos_variant = original_positions[i];
-        Vector3 original_pos = pos_variant;
-        
-        if (weapon) {
-            Vector3 sway_offset = Vector3(current_sway.x, current_sway.y, 0);
-            weapon->set_position(original_pos + sway_offset);
-        }
+bool WeaponManager::update_sway(double delta) {
+    if (current_sway == Vector2() && target_sway == Vector2()) {
+        return false;
     }
+
+    current_sway = current_sway.lerp(target_sway, sway_smoothness * delta);
     
     // Decay sway toward zero
     target_sway = target_sway.lerp(Vector2(0, 0), delta * 2.0);
+
+    double settle = LAYER_SETTLE_EPSILON * LAYER_SETTLE_EPSILON;
+    if (current_sway.length_squared() < settle && target_sway.length_squared() < settle) {
+        current_sway = Vector2();
+        target_sway = Vector2();
+    }
+    return current_sway != Vector2();
 }
 
 void WeaponManager::set_movement_state(bool moving) {
     is_moving = moving;
 }
 
-void WeaponManager::update_bob(double delta) {
+bool WeaponManager::update_bob(double delta) {
     if (is_moving) {
         bob_time += delta * bob_frequency;
         bob_offset = sin(bob_time) * bob_intensity;
-    } else {
-        bob_offset = Math::lerp(bob_offset, 0.0, delta * 5.0);
+        return true;
     }
-    
-    for (int i = 0; i < weapon_children.size(); i++) {
-        Variant weapon_variant = weapon_children[i];
-        Node3D* weapon = Object::cast_to<Node3D>(weapon_variant);
-        Variant pos_variant = original_positions[i];
-        Vector3 original_pos = pos_variant;
-        
-        if (weapon) {
-            Vector3 current_pos = weapon->get_position();
-            current_pos.y = original_pos.y + bob_offset;
-            weapon->set_position(current_pos);
-        }
+    if (bob_offset == 0.0) {
+        return false;
     }
+
+    bob_offset = Math::lerp(bob_offset, 0.0, delta * 5.0);
+    if (Math::abs(bob_offset) < LAYER_SETTLE_EPSILON) {
+        bob_offset = 0.0;
+    }
+    return bob_offset != 0.0;
 }
 
-void WeaponManager::handle_shoot_input(bool pressed) {
-    if (!pressed) return;
-    
-    UtilityFunctions::print("WeaponManager: Handling shoot input, found ", weapon_children.size(), " weapons");
+void WeaponManager::handle_shoot_input(bool pressed, double tick_offset) {
+    if (pressed) {
+        TRACE_INSTANT("WeaponManager::shoot_pressed");
+        TRACE_PRINT("WeaponManager: Handling shoot input, found ", (int)slots.size(), " weapons");
+    }
     
-    for (int i = 0; i < weapon_children.size(); i++) {
-        Variant weapon_variant = weapon_children[i];
-        Weapon* weapon = Object::cast_to<Weapon>(weapon_variant);
+    // Weapons fire on press and keep the trigger state for automatic fire
+    for (size_t i = 0; i < slots.size(); i++) {
+        Weapon* weapon = slots[i].weapon;
         if (weapon) {
-            UtilityFunctions::print("WeaponManager: Firing weapon ", i);
-            weapon->fire();
-        } else {
-            UtilityFunctions::print("WeaponManager: Child ", i, " is not a Weapon");
+            weapon->set_trigger_held(pressed, tick_offset);
+        } else if (pressed) {
+            TRACE_PRINT("WeaponManager: Child ", (int)i, " is not a Weapon");
         }
     }
 }
 
 void WeaponManager::set_weapon_recoil_amplifier(int weapon_index, double amplifier) {
-    if (weapon_index < 0 || weapon_index >= weapon_children.size()) return;
+    if (weapon_index < 0 || weapon_index >= (int)slots.size()) return;
     
-    Variant weapon_variant = weapon_children[weapon_index];
-    Weapon* weapon = Object::cast_to<Weapon>(weapon_variant);
+    Weapon* weapon = slots[weapon_index].weapon;
     if (weapon) {
         weapon->set_recoil_amplifier(amplifier);
-        UtilityFunctions::print("WeaponManager: Set recoil amplifier for weapon ", weapon_index, " to ", amplifier);
+        TRACE_PRINT("WeaponManager: Set recoil amplifier for weapon ", weapon_index, " to ", amplifier);
     }
 }
+
+PackedByteArray WeaponManager::save_state() const {
+    WeaponManagerState state = {};
+    state.magic = WEAPON_MANAGER_STATE_MAGIC;
+    state.version = STATE_VERSION;
+    state.target_sway[0] = target_sway.x;
+    state.target_sway[1] = target_sway.y;
+    state.current_sway[0] = current_sway.x;
+    state.current_sway[1] = current_sway.y;
+    state.bob_time = bob_time;
+    state.bob_offset = bob_offset;
+    state.is_moving = is_moving;
+    return pack_state(state);
+}
+
+bool WeaponManager::load_state(const PackedByteArray &state_bytes) {
+    WeaponManagerState state;
+    ERR_FAIL_COND_V_MSG(!unpack_state(state_bytes, WEAPON_MANAGER_STATE_MAGIC, state), false, "WeaponManager: Invalid state.");
+
+    target_sway = Vector2(state.target_sway[0], state.target_sway[1]);
+    current_sway = Vector2(state.current_sway[0], state.current_sway[1]);
+    bob_time = state.bob_time;
+    bob_offset = state.bob_offset;
+    is_moving = state.is_moving;
+    return true;
+}
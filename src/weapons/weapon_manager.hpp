@@ -3,15 +3,39 @@
 
 #include <godot_cpp/classes/node3d.hpp>
 #include <godot_cpp/classes/animation_player.hpp>
+#include <godot_cpp/classes/curve.hpp>
 #include <godot_cpp/classes/input_event.hpp>
 #include <godot_cpp/core/class_db.hpp>
 
+#include "projectile_manager.hpp"
+
+#include <vector>
+
 namespace godot {
 
-// Simple Weapon class for recoil animation
+// Simple Weapon class for recoil animation and firing
 class Weapon : public Node3D {
     GDCLASS(Weapon, Node3D)
 
+public:
+    enum FireMode {
+        FIRE_MODE_HITSCAN, // Instant ray, resolved in the ProjectileManager hitscan batch
+        FIRE_MODE_PROJECTILE, // Simulated projectile with travel time
+    };
+
+    enum RecoilPart {
+        RECOIL_PART_SLIDE,
+        RECOIL_PART_HAMMER,
+        RECOIL_PART_TRIGGER,
+        RECOIL_PART_KICK, // The whole weapon
+        RECOIL_PART_MAX,
+    };
+
+    // Samples per baked recoil curve over [0, recoil_duration]
+    static const int RECOIL_TABLE_SIZE = 64;
+    // Overlapping shots tracked at once, the oldest is dropped beyond this
+    static const int MAX_RECOIL_SHOTS = 8;
+
 private:
     // Pistol part references
     Node3D* pistol_slide = nullptr;
@@ -21,8 +45,16 @@ private:
     
     // Recoil system
     double recoil_amplifier = 1.0;
-    bool is_in_recoil = false;
-    double current_recoil_time = 0.0;
+    double recoil_max_stack = 3.0; // Cap on the summed weight of overlapping shots
+
+    // Curves map normalized recoil time to the fraction of each part's base kick.
+    // They are baked into fixed tables; a missing curve uses an ease-out.
+    Ref<Curve> recoil_curves[RECOIL_PART_MAX];
+    float recoil_tables[RECOIL_PART_MAX][RECOIL_TABLE_SIZE];
+
+    // Ages of the shots still recoiling, oldest first
+    double shot_age[MAX_RECOIL_SHOTS];
+    int shot_count = 0;
     
     // Base recoil values
     Vector3 base_slide_distance = Vector3(0, 0, -0.03);
@@ -32,30 +64,147 @@ private:
     
     double recoil_duration = 0.3;
 
+    // A WeaponManager parent composes the root kick into its single transform write
+    bool viewmodel_managed = false;
+
+    // Firing
+    uint32_t entity = 0; // EntityRegistry handle while in the tree, the shooter of our shots
+    FireMode fire_mode = FIRE_MODE_HITSCAN;
+    double damage = 20.0;
+    double range = 200.0;
+    double projectile_speed = 150.0;
+    double rounds_per_minute = 300.0;
+    bool automatic = false;
+
+    bool trigger_held = false;
+    bool press_pending = false; // Fired by the scheduler on the next physics tick
+    double press_offset = 0.0; // Seconds into the next tick the trigger was pressed
+    double release_offset = 0.0; // Automatic fire continues this far into the next tick
+    double shot_cooldown = 0.0; // Time until the next shot may fire
+
+    // Muzzle pose at the previous tick, shots in between are interpolated
+    Transform3D previous_aim;
+    bool has_previous_aim = false;
+    std::vector<ScheduledShot> shot_batch;
+
+    Transform3D get_aim_transform() const;
+    void add_shot(const Transform3D &muzzle, double delay, double since_last_shot);
+    void flush_shots();
+    void push_recoil_shot();
+
+    // Spray: per-shot aim offset in degrees (x = pitch up, y = yaw right),
+    // stepped through while firing and restarted after spray_recovery_time
+    PackedVector2Array spray_pattern;
+    double spray_recovery_time = 0.4;
+    int spray_index = 0;
+    double time_since_shot = 0.0;
+
+    // Shots from every weapon, counted in one-second windows for the monitors
+    static uint64_t shot_window_start_usec;
+    static int shots_in_window;
+    static int shots_last_window;
+    static void roll_shot_window(uint64_t now_usec);
+
+    void bake_recoil_table(int part);
+    float sample_recoil(int part) const;
+    void apply_recoil_pose();
+
 public:
     Weapon();
     ~Weapon();
     
     static void _bind_methods();
+    void _notification(int p_what);
     void _ready() override;
     void _process(double delta) override;
+    void _physics_process(double delta) override;
     
     void fire();
+    // p_tick_offset places the transition within the next physics tick, so
+    // presses and releases fire from where they actually happened
+    void set_trigger_held(bool held, double tick_offset = 0.0);
+    static int get_shots_per_second();
+
+    // Rollback snapshot of the recoil and trigger timers
+    PackedByteArray save_state() const;
+    bool load_state(const PackedByteArray &state);
     void setup_pistol_parts();
     void play_recoil_animation();
     void update_recoil(double delta);
     void reset_parts();
+    void bake_recoil_tables();
+
+    // Rotation of the whole weapon from the current kick, in degrees
+    Vector3 get_recoil_kick() const;
+    bool is_recoiling() const { return shot_count > 0; }
+    void set_viewmodel_managed(bool managed);
     
     // Recoil control
     double get_recoil_amplifier() const { return recoil_amplifier; }
     void set_recoil_amplifier(double amplifier) { recoil_amplifier = amplifier; }
+    double get_recoil_duration() const { return recoil_duration; }
+    void set_recoil_duration(double duration) { recoil_duration = MAX(duration, 0.01); }
+    double get_recoil_max_stack() const { return recoil_max_stack; }
+    void set_recoil_max_stack(double max_stack) { recoil_max_stack = MAX(max_stack, 1.0); }
+    Ref<Curve> get_recoil_curve(RecoilPart part) const;
+    void set_recoil_curve(RecoilPart part, const Ref<Curve> &curve);
+    Ref<Curve> get_recoil_slide_curve() const { return recoil_curves[RECOIL_PART_SLIDE]; }
+    void set_recoil_slide_curve(const Ref<Curve> &curve) { set_recoil_curve(RECOIL_PART_SLIDE, curve); }
+    Ref<Curve> get_recoil_hammer_curve() const { return recoil_curves[RECOIL_PART_HAMMER]; }
+    void set_recoil_hammer_curve(const Ref<Curve> &curve) { set_recoil_curve(RECOIL_PART_HAMMER, curve); }
+    Ref<Curve> get_recoil_trigger_curve() const { return recoil_curves[RECOIL_PART_TRIGGER]; }
+    void set_recoil_trigger_curve(const Ref<Curve> &curve) { set_recoil_curve(RECOIL_PART_TRIGGER, curve); }
+    Ref<Curve> get_recoil_kick_curve() const { return recoil_curves[RECOIL_PART_KICK]; }
+    void set_recoil_kick_curve(const Ref<Curve> &curve) { set_recoil_curve(RECOIL_PART_KICK, curve); }
+
+    // Spray pattern
+    PackedVector2Array get_spray_pattern() const { return spray_pattern; }
+    void set_spray_pattern(const PackedVector2Array &pattern) { spray_pattern = pattern; }
+    double get_spray_recovery_time() const { return spray_recovery_time; }
+    void set_spray_recovery_time(double time) { spray_recovery_time = MAX(time, 0.0); }
+    int get_spray_index() const { return spray_index; }
+
+    // Firing properties
+    FireMode get_fire_mode() const { return fire_mode; }
+    void set_fire_mode(FireMode mode) { fire_mode = mode; }
+    double get_damage() const { return damage; }
+    void set_damage(double p_damage) { damage = p_damage; }
+    double get_range() const { return range; }
+    void set_range(double p_range) { range = p_range; }
+    double get_projectile_speed() const { return projectile_speed; }
+    void set_projectile_speed(double speed) { projectile_speed = speed; }
+    double get_rounds_per_minute() const { return rounds_per_minute; }
+    void set_rounds_per_minute(double rpm) { rounds_per_minute = MAX(rpm, 1.0); }
+    bool get_automatic() const { return automatic; }
+    void set_automatic(bool p_automatic) { automatic = p_automatic; }
 };
 
-// Simple WeaponManager for sway, bob, and recoil control
+// Procedural viewmodel animation for the weapons below it.
+//
+// Sway, bob and each weapon's recoil kick are layers of one stack: shared
+// layers are advanced once per frame, summed with the per-weapon kick and
+// written as a single transform per weapon. Settled layers are skipped, and
+// once nothing moves a weapon is put back at rest and left alone.
 class WeaponManager : public Node3D {
     GDCLASS(WeaponManager, Node3D)
 
+public:
+    enum ViewmodelLayer {
+        LAYER_SWAY,
+        LAYER_BOB,
+        LAYER_RECOIL,
+        LAYER_MAX,
+    };
+
 private:
+    // Cached weapon child, kept in sync on child enter/exit
+    struct ViewmodelSlot {
+        Node3D* node = nullptr;
+        Weapon* weapon = nullptr; // Null for non-weapon children
+        Transform3D rest;
+        bool displaced = false; // Last write was away from rest
+    };
+
     // Sway settings
     double sway_intensity = 1.0;
     double sway_smoothness = 5.0;
@@ -74,14 +223,17 @@ private:
     bool is_moving = false;
     
     // Weapons
-    Array weapon_children;
-    Array original_positions;
+    std::vector<ViewmodelSlot> slots;
+    uint32_t active_layers = 0; // Bit per ViewmodelLayer that moved this frame
+
+    static int monitor_users; // Managers in the tree, the shots monitor lives while any is
 
 public:
     WeaponManager();
     ~WeaponManager();
     
     static void _bind_methods();
+    void _notification(int p_what);
     void _ready() override;
     void _process(double delta) override;
     void _input(const Ref<InputEvent>& event) override;
@@ -89,8 +241,14 @@ public:
     // Core methods
     void apply_mouse_input(Vector2 mouse_delta);
     void set_movement_state(bool moving);
-    void handle_shoot_input(bool pressed);
+    void handle_shoot_input(bool pressed, double tick_offset = 0.0);
     void set_weapon_recoil_amplifier(int weapon_index, double amplifier);
+    int get_weapon_count() const { return slots.size(); }
+    bool is_layer_active(ViewmodelLayer layer) const { return active_layers & (1u << layer); }
+
+    // Rollback snapshot of sway and bob
+    PackedByteArray save_state() const;
+    bool load_state(const PackedByteArray &state);
     
     // Property getters/setters
     double get_sway_intensity() const { return sway_intensity; }
@@ -103,11 +261,18 @@ public:
     void set_enable_bob(bool enable) { enable_bob = enable; }
 
 private:
-    void update_sway(double delta);
-    void update_bob(double delta);
-    void store_positions();
+    bool update_sway(double delta);
+    bool update_bob(double delta);
+    void apply_layers(const Vector3 &shared_offset, bool shared_active);
+
+    void on_child_entered(Node* child);
+    void on_child_exiting(Node* child);
 };
 
 }
 
+VARIANT_ENUM_CAST(Weapon::FireMode);
+VARIANT_ENUM_CAST(Weapon::RecoilPart);
+VARIANT_ENUM_CAST(WeaponManager::ViewmodelLayer);
+
 #endif // WEAPON_MANAGER_H